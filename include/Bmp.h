@@ -0,0 +1,172 @@
+/**
+ * @file Bmp.h
+ * @brief Decoder of BMP images with scaling to the image area.
+ */
+#ifndef BMP_H
+#define BMP_H
+
+#include <File.h>
+#include <StreamReader.h>
+#include <config.h>
+#include <stdint.h>
+#if defined(BMP_DITHER)
+#include <Dither.h>
+#endif
+
+/**
+ * @enum BMPCompression
+ * @brief Compression methods of BMP pixel data.
+ */
+enum BMPCompression
+{
+    BI_RGB = 0,      /**< Uncompressed. */
+    BI_RLE8 = 1,     /**< Run-length encoded 8 bpp. */
+    BI_RLE4 = 2,     /**< Run-length encoded 4 bpp. */
+    BI_BITFIELDS = 3 /**< Uncompressed with colour masks. */
+};
+
+/**
+ * @struct BMPHeader
+ * @brief Structure representing the header of a BMP image file.
+ * @details The BMP header contains the width and height of the image, as well as the offset to the
+ * image data. This is not the full BMP header, but it is enough to read the image data from the
+ * file.
+ */
+typedef struct
+{
+    int32_t width;        /**< The width of the image. */
+    int32_t height;       /**< The height of the image. */
+    uint32_t data_offset; /**< The offset to the image data. */
+    uint32_t header_size; /**< The size of the info header, the colour table follows it. */
+    uint16_t depth;       /**< Bits per pixel. */
+    uint32_t compression; /**< The compression method. */
+    uint16_t colors;      /**< The number of colour table entries of a palettized image. */
+    bool rgb555;          /**< 16 bpp pixels are RGB555 rather than RGB565. */
+} BMPHeader;
+
+/**
+ * @class Bmp
+ * @brief Draws BMP images straight to the display, scaled or cropped to an area.
+ *
+ * @details Uncompressed 24, 16, 8 and 4 bpp images and RLE8 and RLE4 compressed ones are drawn.
+ * Every path converts its pixels with pixel_to_565(), so a depth is handled the same way whether
+ * an image is drawn whole, sampled, interlaced or zoomed.
+ */
+class Bmp
+{
+public:
+    static bool parse_header(File& bmp_file, BMPHeader& header);
+
+    static bool draw(File& bmpFile, uint8_t x, uint8_t y);
+
+    static bool draw(File& bmpFile, BMPHeader& header, uint8_t x, uint8_t y);
+
+    static bool draw_area(File& bmpFile, BMPHeader& header, uint16_t x, uint16_t y, int area_w,
+                          int area_h);
+
+    static bool draw_view(File& bmpFile, const BMPHeader& header, uint8_t shift, uint16_t vx,
+                          uint16_t vy, uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+
+    static uint32_t row_size(const BMPHeader& header);
+
+    static uint32_t first_row_position(const BMPHeader& header);
+
+    static void load_palette(File& bmpFile, const BMPHeader& header, uint16_t* lut);
+
+    static bool read_pixel(StreamReader& reader, const BMPHeader& header, uint32_t col,
+                           uint32_t& offset, uint32_t& loaded, uint8_t* px);
+
+    /**
+     * @brief Converts a B, G, R pixel to RGB565, dithered with BMP_DITHER.
+     *
+     * @param px The pixel.
+     * @param x The display column of the pixel, for the dither.
+     * @param y The display row of the pixel, for the dither.
+     * @return The RGB565 colour.
+     */
+    static uint16_t bgr_to_565(const uint8_t* px, uint16_t x, uint16_t y)
+    {
+#if defined(BMP_DITHER)
+        return Dither::rgb_to_565(px[2], px[1], px[0], x, y);
+#else
+        return (px[2] & 0xF8) << 8 | (px[1] & 0xFC) << 3 | px[0] >> 3;
+#endif
+    }
+
+    /**
+     * @brief Converts a pixel as read from the file to RGB565.
+     *
+     * @details A 24 bpp pixel is B, G, R and dithered with BMP_DITHER, a 16 bpp one is
+     * little-endian RGB565 or RGB555. For a palettized image px[0] is the palette index, see
+     * read_pixel().
+     *
+     * @param header The parsed BMP header of the file.
+     * @param lut The colour table as RGB565, for palettized images.
+     * @param px The pixel.
+     * @param x The display column of the pixel, for the dither.
+     * @param y The display row of the pixel, for the dither.
+     * @return The RGB565 colour.
+     */
+    static uint16_t pixel_to_565(const BMPHeader& header, const uint16_t* lut, const uint8_t* px,
+                                 uint16_t x, uint16_t y)
+    {
+        if (header.depth == 24)
+        {
+            return bgr_to_565(px, x, y);
+        }
+        if (header.depth == 16)
+        {
+            uint16_t color = px[0] | px[1] << 8;
+            return header.rgb555 ? (color & 0x7FE0) << 1 | (color & 0x1F) : color;
+        }
+        return lut[px[0]];
+    }
+
+private:
+    /**
+     * @union Buffers
+     * @brief The buffers of draw_area() and draw_view(), kept in the Workspace.
+     */
+    union Buffers
+    {
+        uint8_t rgb[3 * BUFFPIXEL]; ///< Pixel buffer (B+G+R per pixel).
+        struct
+        {
+            uint16_t lut[256]; ///< Colour table as RGB565.
+#if defined(BMP_INTERLACE)
+            uint8_t index[BUFFPIXEL]; ///< Palette indices, a whole row.
+#else
+            uint8_t index[3 * BUFFPIXEL - 512]; ///< Palette indices.
+#endif
+        } pal;
+#if defined(BMP_FIT) && defined(BMP_BOX_FILTER)
+        struct
+        {
+            uint8_t acc[3 * BUFFPIXEL]; ///< Averaged colour of each output column.
+            uint8_t read[32];           ///< Pixel data.
+        } box;
+#endif
+    };
+
+    static Buffers& map_buffers(File& bmpFile, const BMPHeader& header, bool view,
+                                uint8_t*& buffer, uint16_t& buffsize);
+
+    static bool draw_rle(File& bmpFile, const BMPHeader& header, const uint16_t* lut,
+                         uint8_t* buffer, uint16_t buffsize, uint16_t x, uint16_t y, int w, int h);
+
+    static void fit(const BMPHeader& header, int area_w, int area_h, int& w, int& h);
+
+    static bool draw_nearest(File& bmpFile, const BMPHeader& header, const uint16_t* lut,
+                             uint8_t* buffer, uint16_t buffsize, bool flip, int w, int h);
+#if defined(BMP_INTERLACE)
+    static bool draw_interlaced(File& bmpFile, const BMPHeader& header, const uint16_t* lut,
+                                uint8_t* buffer, uint16_t buffsize, bool flip, uint16_t x,
+                                uint16_t y, int w, int h, bool shrink);
+#endif
+#if defined(BMP_BOX_FILTER)
+    static bool draw_box(File& bmpFile, const BMPHeader& header, uint8_t* acc,
+                         uint8_t* buffer, uint16_t buffsize, bool flip, int w, int h);
+#endif
+};
+
+#endif // BMP_H
@@ -0,0 +1,32 @@
+/**
+ * @file Dither.h
+ * @brief Ordered dithering of 24-bit colours to RGB565.
+ */
+#ifndef DITHER_H
+#define DITHER_H
+
+#include <stdint.h>
+
+/**
+ * @class Dither
+ * @brief Converts 24-bit colours to RGB565 with a 4x4 ordered dither.
+ *
+ * @details Truncating 8-bit channels to 5 or 6 bits turns smooth gradients into visible bands. A
+ * 4x4 Bayer matrix adds a position dependent bias of less than one output step before the
+ * truncation, so the bands become a fine, stable pattern that averages to the true colour.
+ *
+ * All of the arithmetic is folded into PROGMEM tables that are generated by the preprocessor. A
+ * channel value plus its bias indexes a table whose entry is already clamped, shifted and masked
+ * into its place in the big-endian RGB565 bytes, so a pixel costs three additions, four flash
+ * lookups and two ORs. bgr_to_565() converts a whole run of BMP pixels in place, and the run is
+ * then sent with one ILI9341_PushPixels565BE() call instead of one call per pixel.
+ */
+class Dither
+{
+public:
+    static void bgr_to_565(uint8_t* data, uint16_t count, uint16_t x, uint16_t y);
+
+    static uint16_t rgb_to_565(uint8_t r, uint8_t g, uint8_t b, uint16_t x, uint16_t y);
+};
+
+#endif // DITHER_H
@@ -0,0 +1,98 @@
+/**
+ * @file Gif.h
+ * @brief Animated GIF player.
+ */
+#ifndef GIF_H
+#define GIF_H
+
+#include <File.h>
+#include <StreamReader.h>
+#include <Workspace.h>
+#include <stdint.h>
+
+/**
+ * @class Gif
+ * @brief Plays GIF animations frame by frame, paced by the GIF frame delays.
+ *
+ * @details Only a few bytes of playback state are kept between frames. Each frame is decoded by
+ * draw_frame() with a streaming LZW decoder whose buffers live in the Workspace for that call
+ * only. The colour table of the frame is converted to RGB565 once, and only the frame's own
+ * sub-rectangle is written to the display, so unchanged parts of the animation cost nothing.
+ *
+ * A full 4096 code LZW dictionary does not fit the RAM of the ATmega32. The colour table and the
+ * dictionary share a POOL_SIZE byte pool instead, the Workspace less the string stack of the
+ * decoder, which for a 256 colour frame holds codes up to 363. Frames whose encoder lets the
+ * dictionary grow past that are drawn up to the first code that does not fit. tools/gif_recode.py
+ * rewrites any GIF with early clear codes so that it fits.
+ */
+class Gif
+{
+public:
+    Gif();
+
+    static bool is_gif(File& file);
+
+    static uint16_t max_codes(uint16_t colors, uint8_t min_code_size);
+
+    bool start(File& file, uint8_t x, uint8_t y);
+
+    void stop();
+
+    /**
+     * @brief Checks if an animation is being played.
+     * @return True if an animation is being played, false otherwise.
+     */
+    bool is_playing()
+    {
+        return file != NULL;
+    }
+
+    bool frame_due();
+
+    bool draw_frame();
+
+    static const uint16_t STACK_SIZE = 32; ///< Characters written per walk of a dictionary string.
+
+    /// Bytes shared by the colour table and the dictionary.
+    static const uint16_t POOL_SIZE = Workspace::SIZE - STACK_SIZE;
+
+private:
+    /**
+     * @struct Frame
+     * @brief The image descriptor and control data of a frame.
+     */
+    typedef struct
+    {
+        uint16_t left;       /**< Position of the frame on the canvas. */
+        uint16_t top;        /**< Position of the frame on the canvas. */
+        uint16_t width;      /**< Width of the frame. */
+        uint16_t height;     /**< Height of the frame. */
+        bool interlaced;     /**< Rows are stored in four interlaced passes. */
+        bool local_palette;  /**< A local colour table follows the descriptor. */
+        int16_t transparent; /**< Transparent colour index, -1 if none. */
+    } Frame;
+
+    bool decode_image(StreamReader& reader, const Frame& frame, uint16_t colors);
+
+    void dispose();
+
+    static void skip_sub_blocks(StreamReader& reader);
+
+    File* file;              ///< The GIF file, NULL when not playing.
+    uint8_t x;               ///< Display position of the canvas.
+    uint8_t y;               ///< Display position of the canvas.
+    uint16_t width;          ///< Visible width of the canvas.
+    uint16_t height;         ///< Visible height of the canvas.
+    uint32_t first_frame;    ///< File position of the first frame.
+    uint32_t next_frame;     ///< File position of the next frame.
+    uint32_t palette_pos;    ///< File position of the global colour table, 0 if none.
+    uint16_t palette_colors; ///< Size of the global colour table.
+    uint16_t frame_count;    ///< Frames drawn in the current pass over the file.
+    uint32_t due_time;       ///< Millis at which the next frame is due.
+    uint8_t disposal;        ///< Disposal method of the last frame.
+    uint16_t dispose_rect[4]; ///< Display rectangle of the last frame, x0, y0, x1, y1.
+
+    static const uint16_t DEFAULT_DELAY_MS = 100; ///< Used for frames without a usable delay.
+};
+
+#endif // GIF_H
@@ -0,0 +1,68 @@
+/**
+ * @file ImageCache.h
+ * @brief Images as drawn, cached in files on the card.
+ */
+#ifndef IMAGE_CACHE_H
+#define IMAGE_CACHE_H
+
+#include <FAT.h>
+#include <File.h>
+#include <stdint.h>
+
+/**
+ * @struct CacheKey
+ * @brief Identifies the contents of an image file, from its directory entry.
+ */
+typedef struct
+{
+    uint32_t cluster;  /**< The first cluster of the image file. */
+    uint32_t size;     /**< The size of the image file. */
+    uint32_t modified; /**< The date and time of the last write, see File::get_modified(). */
+} CacheKey;
+
+/**
+ * @class ImageCache
+ * @brief Draws images that were shown before from the card as RGB565, and stores new ones.
+ *
+ * @details The hidden directory IMGCACHE in the root holds the index file INDEX.DAT and one entry
+ * file per cached image, Enn.RGB for slot nn. The index is a single sector: a header of "ICA1" and
+ * a use counter, then a record per slot of the CacheKey of the image and the use counter at its
+ * last view. A slot with a zero cluster is empty. A record whose key does not match the image file,
+ * because the image was replaced or changed, is never found, and its slot is reused in turn.
+ *
+ * An entry file is the image area as drawn, big-endian RGB565 pixels row after row from the top,
+ * so drawing it costs no decoding and one read of whole sectors that follow each other on the card.
+ * It is written once, by reading back the display memory, into clusters allocated in one run
+ * beforehand and with a single multiple block write. IMAGE_CACHE_KB limits the number of slots.
+ * When all are used the slot shown least recently is overwritten.
+ */
+class ImageCache
+{
+public:
+    ImageCache(FAT* fs);
+
+    static void make_key(File& file, CacheKey& key);
+
+    bool draw(File& root_dir, const CacheKey& key);
+
+    bool store(File& root_dir, const CacheKey& key);
+
+private:
+    bool open_dir(File& root_dir);
+
+    int8_t find(File& index, const CacheKey& key);
+
+    bool open_index(File& index);
+
+    uint8_t slot_count();
+
+    static void entry_name(uint8_t slot, char* name);
+
+    FAT* fs;  ///< The FAT file system of the cache files.
+    File dir; ///< The cache directory, opened on first use.
+
+    static const uint8_t RECORD_SIZE = 16; ///< Bytes of the header and of a record.
+    static const uint8_t SLOTS = 31;       ///< Records that follow the header in the index sector.
+};
+
+#endif // IMAGE_CACHE_H
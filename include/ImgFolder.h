@@ -26,11 +26,21 @@ public:
     ~ImgFolder();
 
     void init(File& root_dir, const char* folder_name);
+    bool count_step();
+    bool resume(uint32_t folder_cluster, int8_t index, uint16_t entry, File& imgFile);
     bool next_file(File& imgFile);
     bool prev_file(File& imgFile);
+    bool prefetch_next(File& imgFile);
+    void use_prefetched();
+    bool reopen_current(File& imgFile);
+    bool list_start(uint8_t index);
+    bool list_next(uint16_t& entry, uint32_t& size, uint32_t& cluster);
+    bool open_entry(uint16_t entry, File& imgFile);
+    bool go_to(int8_t index, uint16_t entry, File& imgFile);
 
     /**
      * @brief Gets the number of image files in the folder.
+     * @details While is_counting() is true this is only the number found so far.
      * @return The number of image files.
      */
     uint8_t get_image_count()
@@ -66,6 +76,33 @@ public:
         return index;
     }
 
+    /**
+     * @brief Gets the directory entry of the current image file.
+     * @return The entry number within the folder.
+     */
+    uint16_t get_entry()
+    {
+        return entry;
+    }
+
+    /**
+     * @brief Gets the first cluster of the folder.
+     * @return The cluster the folder starts at.
+     */
+    uint32_t get_folder_cluster()
+    {
+        return dir.get_first_cluster();
+    }
+
+    /**
+     * @brief Checks if the image files are still being counted.
+     * @return True until count_step() has reached the end of the folder.
+     */
+    bool is_counting()
+    {
+        return counting;
+    }
+
     /**
      * @brief Checks if the loop flag is enabled.
      * @return True if the loop flag is enabled, false otherwise.
@@ -83,7 +120,18 @@ private:
     uint8_t image_count;  ///< The number of image files in the folder.
     bool loop_on_end; ///< Flag indicating whether to loop back to the first file when reaching the
                       ///< end.
+    bool counting;    ///< Flag indicating that the folder has not been fully counted yet.
+    uint32_t scan_position; ///< Directory position where counting continues.
+    uint8_t scan_files;     ///< Files passed by counting so far, the index of the next one.
+    uint16_t entry;         ///< Directory entry of the current image file.
+    int8_t prefetch_index;  ///< Index of the file opened by prefetch_next().
+    uint16_t prefetch_entry; ///< Directory entry of the file opened by prefetch_next().
+    uint32_t list_position;  ///< Directory position where list_next() continues.
+
+    static const uint8_t COUNT_SLICE = 8; ///< Files examined by one count_step() call.
 
+    static bool is_image(const char* name);
+    bool open_current(File& imgFile);
     bool next_file_name(char* buffer);
     bool prev_file_name(char* buffer);
 };
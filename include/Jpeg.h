@@ -0,0 +1,151 @@
+/**
+ * @file Jpeg.h
+ * @brief Baseline JPEG decoder with scaled output.
+ */
+#ifndef JPEG_H
+#define JPEG_H
+
+#include <File.h>
+#include <StreamReader.h>
+#include <stdint.h>
+
+/**
+ * @class Jpeg
+ * @brief Decodes baseline JPEG images straight to the display, one MCU at a time.
+ *
+ * @details The image is decoded at 1/1, 1/2, 1/4 or 1/8 of its size, the largest scale that fits
+ * the 240x300 image area or the area given to draw_area(). Scaling is done inside the IDCT: at
+ * scale 1/n only the lowest 8/n x 8/n coefficients of each block are kept and transformed with an
+ * 8/n-point IDCT, and at 1/8 only the DC coefficient is used. A large camera photo therefore costs
+ * little more than Huffman decoding. Every decoded MCU is written into its own display window.
+ * Decoding stops after the last visible MCU row, MCUs right of the area are Huffman decoded but not
+ * transformed.
+ *
+ * Supported are baseline (SOF0) and extended 8-bit (SOF1) Huffman images with one scan, greyscale
+ * or YCbCr with 1x1, 2x1 or 2x2 luma sampling, and restart intervals. Progressive images are not.
+ *
+ * RAM budget of the decoder. The tables and block buffers are kept in the Workspace that all
+ * decoders share, only the reader and the frame state are on the stack of draw():
+ *
+ * | Data                                  | Bytes |
+ * |---------------------------------------|-------|
+ * | Quantization tables, 2 x 64           | 128   |
+ * | Huffman code counts, 4 x 16           | 64    |
+ * | Huffman DC symbols, 2 x 12            | 24    |
+ * | Huffman AC symbols, 2 x 162           | 324   |
+ * | Coefficient block, 64 x int16         | 128   |
+ * | MCU samples, Y 8x8 + Cb 4x4 + Cr 4x4  | 96    |
+ * | In the Workspace                      | 764   |
+ * | Read buffer                           | 32    |
+ * | Components, reader and bit state      | 54    |
+ * | On the stack of draw()                | 86    |
+ *
+ * The 2048 bytes of RAM of the ATmega32 while a JPEG image is drawn:
+ *
+ * | Data                                          | Bytes |
+ * |-----------------------------------------------|-------|
+ * | PhotoAlbum, on the stack of main()            | 964   |
+ * | Workspace                                     | 768   |
+ * | Other static variables and strings            | 136   |
+ * | Decoder on the stack of draw()                | 86    |
+ * | Left for the call frames and the interrupt    | 94    |
+ *
+ * These are worked out from the type sizes with 16-bit int and pointers, not measured. The frames
+ * of the calls from main() down to the SD card driver and of the timer interrupt have to fit in
+ * what is left. STACK_REPORT measures the margin that really remains on the target, see Stack.
+ *
+ * Huffman codes are decoded from the code counts directly, so no lookup tables are built. The MCU
+ * sample buffer holds one MCU at scale 1/2 or below. This limits colour images to scale 1/2 or
+ * below; a 2x2 subsampled MCU at full scale alone would need 384 bytes.
+ */
+class Jpeg
+{
+public:
+    static bool is_jpeg(File& file);
+
+    static bool draw(File& file, uint8_t x, uint8_t y);
+
+    static bool draw_area(File& file, uint8_t x, uint8_t y, uint16_t area_w, uint16_t area_h,
+                          bool crop);
+
+private:
+    /**
+     * @struct Component
+     * @brief A colour component of the frame.
+     */
+    typedef struct
+    {
+        uint8_t id;      /**< Component identifier. */
+        uint8_t h;       /**< Horizontal sampling factor. */
+        uint8_t v;       /**< Vertical sampling factor. */
+        uint8_t tq;      /**< Quantization table. */
+        uint8_t td;      /**< DC Huffman table. */
+        uint8_t ta;      /**< AC Huffman table. */
+        int16_t dc_pred; /**< DC value of the previous block. */
+        uint8_t* samples; /**< Decoded samples of the current MCU. */
+    } Component;
+
+    explicit Jpeg(File& file);
+
+    bool read_markers();
+
+    bool read_dqt(uint16_t length);
+
+    bool read_dht(uint16_t length);
+
+    bool read_sof(uint16_t length);
+
+    bool fit(uint16_t area_w, uint16_t area_h);
+
+    bool read_sos();
+
+    uint16_t read16();
+
+    bool decode(uint8_t x, uint8_t y, uint16_t area_w, uint16_t area_h);
+
+    bool decode_block(Component& comp, bool keep);
+
+    void idct(uint8_t* out, uint8_t stride);
+
+    void put_mcu(uint16_t x, uint16_t y, uint8_t w, uint8_t h);
+
+    int16_t decode_huffman(const uint8_t* bits, const uint8_t* vals);
+
+    int16_t receive_extend(uint8_t size);
+
+    uint8_t get_bit();
+
+    void restart();
+
+    /**
+     * @struct Buffers
+     * @brief The tables and block buffers of the decoder, kept in the Workspace.
+     */
+    typedef struct
+    {
+        uint8_t quant[2][64];    /**< Quantization tables in zigzag order. */
+        uint8_t dc_bits[2][16];  /**< DC Huffman code counts per code length. */
+        uint8_t dc_vals[2][12];  /**< DC Huffman symbols. */
+        uint8_t ac_bits[2][16];  /**< AC Huffman code counts per code length. */
+        uint8_t ac_vals[2][162]; /**< AC Huffman symbols. */
+        int16_t coef[64];        /**< Dequantized coefficients of the current block. */
+        uint8_t samples[96];     /**< Sample buffers of the current MCU. */
+    } Buffers;
+
+    StreamReader reader;     ///< Buffered reader over the file.
+    uint8_t read_buffer[32]; ///< Buffer of the reader.
+    Buffers& buf;            ///< The tables and block buffers in the Workspace.
+
+    Component comps[3];       ///< The frame components.
+    uint8_t comp_count;       ///< Number of components.
+    uint16_t width;           ///< Image width.
+    uint16_t height;          ///< Image height.
+    uint16_t restart_interval; ///< MCUs between restart markers, 0 if none.
+    uint8_t scale;            ///< Output block size, 8 >> log2 of the scale denominator.
+
+    uint8_t bit_byte;         ///< Byte the entropy coded bits are taken from.
+    uint8_t bit_count;        ///< Bits left in bit_byte.
+    bool marker_hit;          ///< A marker ended the entropy coded data.
+};
+
+#endif // JPEG_H
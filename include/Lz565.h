@@ -0,0 +1,54 @@
+/**
+ * @file Lz565.h
+ * @brief Streaming decoder for LZ compressed RGB565 images.
+ */
+#ifndef LZ565_H
+#define LZ565_H
+
+#include <File.h>
+#include <stdint.h>
+
+/**
+ * @struct Lz565Header
+ * @brief Structure representing the header of an LZ compressed RGB565 image file.
+ */
+typedef struct
+{
+    uint16_t width;  /**< The width of the image. */
+    uint16_t height; /**< The height of the image. */
+} Lz565Header;
+
+/**
+ * @class Lz565
+ * @brief Decodes LZ compressed RGB565 images straight to the display.
+ *
+ * @details A file starts with "L565" and the width and height as little-endian 16-bit values.
+ * Then follow the rows from the top, each a block of tokens that decodes to exactly one row:
+ *
+ * | Token               | Pixels                                                      |
+ * |---------------------|-------------------------------------------------------------|
+ * | 0nnnnnnn            | n + 1 literal big-endian RGB565 pixels follow, 1 to 128     |
+ * | 10nnnnnn            | The previous pixel repeated n + 1 times, 1 to 64            |
+ * | 11nnnnnn oooooooo   | n + 2 pixels copied from o + 1 pixels back, 2 to 65 from 1 to 128 |
+ *
+ * A copy only reaches back within its row, so the window is the last RING pixels of the current
+ * row and no state carries over from one row to the next. Literals and copies land in the window
+ * and go to the display from there, repeats go with a single run-fill. tools/lz565_pack.py makes
+ * such a file from any image and tools/lz565_bench.cpp compares it with uncompressed RGB565.
+ */
+class Lz565
+{
+public:
+    static bool parse_header(File& file, Lz565Header& header);
+
+    static bool draw(File& file, const Lz565Header& header, uint8_t x, uint8_t y);
+
+    static const uint8_t RING = 128; ///< Pixels of the window, the farthest a copy reaches back.
+
+private:
+    static const uint8_t OP_COPY = 0xC0; ///< 11nnnnnn - copy from the window.
+    static const uint8_t OP_RUN = 0x80;  ///< 10nnnnnn - previous pixel repeated.
+    static const uint8_t OP_MASK = 0xC0; ///< Mask of the 2-bit tags.
+};
+
+#endif // LZ565_H
@@ -5,27 +5,21 @@
 #ifndef PHOTO_ALBUM_H
 #define PHOTO_ALBUM_H
 
+#include <Bmp.h>
 #include <FAT.h>
 #include <File.h>
+#include <Gif.h>
+#include <ImageCache.h>
 #include <ImgFolder.h>
 #include <SDCard.h>
+#include <Scheduler.h>
+#include <Thumbs.h>
+#include <Tiles.h>
+#include <UiBars.h>
+#include <Video.h>
 #include <avr/io.h>
 #include <config.h>
 
-/**
- * @struct BMPHeader
- * @brief Structure representing the header of a BMP image file.
- * @details The BMP header contains the width and height of the image, as well as the offset to the
- * image data. This is not the full BMP header, but it is enough to read the image data from the
- * file.
- */
-typedef struct
-{
-    int32_t width;        /**< The width of the image. */
-    int32_t height;       /**< The height of the image. */
-    uint32_t data_offset; /**< The offset to the image data. */
-} BMPHeader;
-
 /**
  * @class PhotoAlbum
  * @brief The main class that runs the project.
@@ -39,20 +33,68 @@ public:
 
     void init();
 
-    void listen_for_input();
+    void start_tasks();
 
 private:
+    static bool input_task(void* album, Task& task);
+
+    static bool slideshow_task(void* album, Task& task);
+
+    static bool draw_task(void* album, Task& task);
+
+    static bool background_task(void* album, Task& task);
+
+    void listen_for_input();
+
+    void mount_filesystem();
+
+    bool resume();
+
+    void save_position();
+
     bool button_pressed(uint8_t button_pin);
 
+    void button_action(uint8_t button_pin);
+
+    void toggle_slideshow();
+
+    void zoom_step();
+
+    void pan(uint8_t button_pin);
+
+    void zoomed_size(uint8_t shift, uint32_t& width, uint32_t& height) const;
+
+    void draw_view(uint16_t first, uint16_t count);
+
+    void show_grid();
+
+    void grid_move(uint8_t button_pin);
+
+    void grid_open();
+
+    uint32_t draw_grid_page();
+
+    void make_thumbnail();
+
+    static bool thumbnail_draw(File& imgFile, uint8_t x, uint8_t y);
+
+    void draw_grid_cursor(uint16_t color);
+
+    bool show_next();
+
+    void prefetch_next();
+
+    void discard_prefetch();
+
     void draw_image();
 
     void draw_ui();
 
     void draw_title_screen();
 
-    static void bmp_draw(File& bmpFile, uint8_t x, uint8_t y);
+    void draw_image_count();
 
-    static bool parse_bmp_header(File& file, BMPHeader& header);
+    static bool image_draw(File& imgFile, uint8_t x, uint8_t y);
 
     SDCard disk;         /// The SD card object. 
     FAT fs;              /// The FAT file system object. 
@@ -60,6 +102,43 @@ private:
     File current_file;   /// The currently displayed file. 
     bool image_changed;  /// Flag indicating if the image has changed. 
     ImgFolder imgFolder; /// The image folder object. 
+    Gif animation;       /// Player of current_file if it is a GIF.
+    Video video;         /// Player of current_file if it is a video.
+    UiBars ui;           /// Text shown in the UI bars.
+
+    union
+    {
+        BMPHeader current_header; /// Header of current_file or next_image, see header_ready.
+        TilesHeader tiles_header; /// Header of current_file while a tiled image is zoomed.
+    };
+    bool header_ready;        /// Flag indicating that current_header is that of current_file.
+
+    uint8_t held_button;      /// Pin of the button being held, 0xFF if none.
+    uint32_t press_time;      /// Millis at which held_button was pressed.
+    bool long_press;          /// Flag indicating that the hold has been handled as a long press.
+
+    bool slideshow;           /// Flag indicating if the slideshow is running.
+    uint32_t slide_time;      /// Millis at which the current slide was due.
+    File next_image;          /// The prefetched next image file.
+    bool next_ready;          /// Flag indicating that next_image is open.
+    bool next_header_ready;   /// Flag indicating that current_header is that of next_image.
+
+    uint8_t zoom;             /// Zoom level of current_file, 0 when fitted, n for 1:2^(n-1).
+    uint16_t view_x;          /// Left edge of the zoomed view, in zoomed image pixels.
+    uint16_t view_y;          /// Top edge of the zoomed view, in zoomed image pixels.
+    uint16_t view_scroll;     /// Image area row in memory at the top of the scrolling area.
+    bool view_tiled;          /// Flag indicating that the zoomed image is a tiled one.
+
+    Thumbs thumbs;            /// Thumbnail cache of the image folder.
+    bool grid;                /// Flag indicating that the thumbnail grid is shown.
+    uint8_t grid_cursor;      /// Index of the image selected in the grid.
+    uint8_t grid_filled;      /// Number of thumbnails on the grid page shown.
+    uint32_t grid_missing;    /// One bit per thumbnail of the grid page still to make.
+    bool grid_covered;        /// Flag indicating that a thumbnail drawn large covers the page.
+
+#if defined(IMAGE_CACHE_KB)
+    ImageCache cache;         /// Still images as drawn, stored on the card.
+#endif
 };
 
 #endif // PHOTO_ALBUM_H
\ No newline at end of file
@@ -0,0 +1,46 @@
+/**
+ * @file Qoi.h
+ * @brief Streaming decoder for QOI images.
+ */
+#ifndef QOI_H
+#define QOI_H
+
+#include <File.h>
+#include <stdint.h>
+
+/**
+ * @struct QOIHeader
+ * @brief Structure representing the header of a QOI image file.
+ */
+typedef struct
+{
+    uint32_t width;  /**< The width of the image. */
+    uint32_t height; /**< The height of the image. */
+} QOIHeader;
+
+/**
+ * @class Qoi
+ * @brief Decodes QOI images straight to the display.
+ *
+ * @details QOI needs no back-reference window, only the previous pixel and a 64 entry table of
+ * recently seen colours, so an image is decoded in a single sequential pass with a few hundred
+ * bytes of RAM.
+ */
+class Qoi
+{
+public:
+    static bool parse_header(File& file, QOIHeader& header);
+
+    static bool draw(File& file, const QOIHeader& header, uint8_t x, uint8_t y);
+
+private:
+    static const uint8_t OP_INDEX = 0x00; ///< 00xxxxxx - colour from the index.
+    static const uint8_t OP_DIFF = 0x40;  ///< 01xxxxxx - small difference to the previous pixel.
+    static const uint8_t OP_LUMA = 0x80;  ///< 10xxxxxx - difference based on the green channel.
+    static const uint8_t OP_RUN = 0xC0;   ///< 11xxxxxx - previous pixel repeated.
+    static const uint8_t OP_RGB = 0xFE;   ///< 11111110 - full RGB value.
+    static const uint8_t OP_RGBA = 0xFF;  ///< 11111111 - full RGBA value.
+    static const uint8_t OP_MASK = 0xC0;  ///< Mask of the 2-bit tags.
+};
+
+#endif // QOI_H
@@ -0,0 +1,42 @@
+/**
+ * @file Resume.h
+ * @brief Last viewed image kept in EEPROM for a fast warm start.
+ */
+#ifndef RESUME_H
+#define RESUME_H
+
+#include <FAT.h>
+#include <stdint.h>
+
+/**
+ * @struct ResumeData
+ * @brief Everything needed to show the last viewed image again after power-on.
+ * @details The volume geometry lets the filesystem be mounted from a single boot sector read, the
+ * folder cluster and directory entry let the image be opened without walking any directory.
+ */
+typedef struct
+{
+    uint16_t magic;          /**< RESUME_MAGIC if the record is valid. */
+    fat_volume_t volume;     /**< Geometry of the volume the record belongs to. */
+    uint32_t folder_cluster; /**< First cluster of the image folder. */
+    int8_t index;            /**< Index of the image in the folder. */
+    uint16_t entry;          /**< Directory entry of the image in the folder. */
+} ResumeData;
+
+/**
+ * @class Resume
+ * @brief Loads and stores the ResumeData record in EEPROM.
+ */
+class Resume
+{
+public:
+    static bool load(ResumeData& data);
+
+    static void save(ResumeData& data);
+
+private:
+    /** Changes whenever the layout of ResumeData changes. */
+    static const uint16_t RESUME_MAGIC = 0xA1B1;
+};
+
+#endif // RESUME_H
@@ -0,0 +1,148 @@
+/**
+ * @file Scheduler.h
+ * @brief Cooperative scheduler of stackless tasks, paced with Millis.
+ */
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Millis.h>
+#include <stdint.h>
+
+struct Task;
+
+/**
+ * @brief A task body, called every time the task is run.
+ *
+ * @param context The pointer the task was added with.
+ * @param task The state of the task, passed to the TASK_ macros.
+ * @return True while the task is running, false once it has ended.
+ */
+typedef bool (*TaskFunction)(void* context, Task& task);
+
+/**
+ * @struct Task
+ * @brief State of a task of the Scheduler.
+ *
+ * @details A task is a protothread: its body is a function that returns to the scheduler at every
+ * TASK_YIELD() and is entered again at the same place the next time it runs. Only `line` is kept
+ * between runs, so local variables of the body do not survive a yield, and state that must is kept
+ * in the context object. A TASK_ macro can only be used in the body itself, not inside a switch
+ * statement of the body or a function it calls, and at most once per source line.
+ */
+struct Task
+{
+    TaskFunction function; ///< The body of the task, NULL for a free slot.
+    void* context;         ///< The pointer passed to the body.
+    uint16_t line;         ///< Source line of the yield to go on from, 0 at the start.
+    uint32_t wake;         ///< Millis before which the task is not run.
+};
+
+/**
+ * @brief Starts the body of a task.
+ */
+#define TASK_BEGIN(task)                                                                           \
+    switch ((task).line)                                                                           \
+    {                                                                                              \
+    case 0:
+
+/**
+ * @brief Ends the body of a task. A task that gets here is removed from the scheduler.
+ */
+#define TASK_END(task)                                                                             \
+    }                                                                                              \
+    (task).line = 0;                                                                               \
+    return false;
+
+/**
+ * @brief Returns to the scheduler, the task goes on from here after the other due tasks ran.
+ */
+#define TASK_YIELD(task)                                                                           \
+    do                                                                                             \
+    {                                                                                              \
+        (task).line = __LINE__;                                                                    \
+        return true;                                                                               \
+    case __LINE__:;                                                                                \
+    } while (0)
+
+/**
+ * @brief Yields until a Millis time has been reached.
+ */
+#define TASK_SLEEP_UNTIL(task, time)                                                               \
+    do                                                                                             \
+    {                                                                                              \
+        (task).wake = (time);                                                                      \
+        TASK_YIELD(task);                                                                          \
+    } while (0)
+
+/**
+ * @brief Yields for a number of milliseconds.
+ */
+#define TASK_SLEEP(task, ms) TASK_SLEEP_UNTIL(task, Millis::get() + (ms))
+
+/**
+ * @brief Yields until a condition is true. The condition is checked at most once a millisecond, so
+ * a task waiting on it lets the scheduler idle.
+ */
+#define TASK_WAIT_UNTIL(task, condition)                                                           \
+    do                                                                                             \
+    {                                                                                              \
+        (task).line = __LINE__;                                                                    \
+    case __LINE__:                                                                                 \
+        if (!(condition))                                                                          \
+        {                                                                                          \
+            (task).wake = Millis::get() + 1;                                                       \
+            return true;                                                                           \
+        }                                                                                          \
+    } while (0)
+
+/**
+ * @brief Yields if the time slice of the task is used up, see Scheduler::budget_expired().
+ */
+#define TASK_YIELD_IF_EXPIRED(task)                                                                \
+    do                                                                                             \
+    {                                                                                              \
+        if (Scheduler::budget_expired())                                                           \
+        {                                                                                          \
+            (task).line = __LINE__;                                                                \
+            return true;                                                                           \
+        }                                                                                          \
+    case __LINE__:;                                                                                \
+    } while (0)
+
+/**
+ * @class Scheduler
+ * @brief Runs stackless tasks in turn, without preemption.
+ *
+ * @details The tasks are run round-robin in the order they were added, each one until it yields.
+ * A task that sleeps is skipped until its wake time. When no task is due the CPU idles until the
+ * next interrupt, which is at the latest the next Millis tick. Every task shares the one stack, so
+ * a task costs only its Task slot.
+ *
+ * A task is given a time budget of TASK_SLICE_MS every time it runs. Work that is done in steps,
+ * such as counting the image folder or making thumbnails, checks budget_expired() between steps
+ * and yields once the budget is used up, so the other tasks wait at most about a slice plus one
+ * step. A single call that blocks, such as drawing an image, still runs to its end.
+ *
+ * Like Millis the class only has static members.
+ */
+class Scheduler
+{
+public:
+    static bool add(TaskFunction function, void* context);
+
+    static void run();
+
+    static bool step();
+
+    static void start_budget(uint16_t ms);
+
+    static bool budget_expired();
+
+    static const uint8_t MAX_TASKS = 4; ///< Number of task slots.
+
+private:
+    static Task tasks[MAX_TASKS]; ///< The task slots.
+    static uint32_t budget_end;   ///< Millis at which the budget of the running task is used up.
+};
+
+#endif // SCHEDULER_H
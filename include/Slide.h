@@ -0,0 +1,78 @@
+/**
+ * @file Slide.h
+ * @brief Slide transition between images with hardware vertical scrolling.
+ */
+#ifndef SLIDE_H
+#define SLIDE_H
+
+#include <stdint.h>
+
+/**
+ * @class Slide
+ * @brief Slides a new image in from the bottom of the image area while it is being drawn.
+ *
+ * @details The image area between the two UI bars is the vertical scrolling area of the panel and
+ * the bars are its fixed areas. A decoder that draws top to bottom writes its rows to their usual
+ * display rows, and reveal() moves the scroll start to the first row not drawn yet. The old rows
+ * from there down are shown at the top of the area and the new rows below them, so the old image
+ * moves up and out while the new one comes in from the bottom. When the last row is drawn the
+ * scroll start is back at the top of the area and the memory is shown unscrolled.
+ *
+ * The panel has no memory rows off the screen, so a row is visible at the top of the area while it
+ * is written, before reveal() moves it to the bottom. The rows and columns around the image are
+ * filled black just before they are revealed, and nothing else is written, so the transition sends
+ * fewer pixels than clearing the screen before drawing did.
+ *
+ * PhotoAlbum arms the transition before it draws an image and ends it afterwards. Decoders that
+ * draw top to bottom call begin() with their image rectangle and reveal() as rows are finished.
+ * Decoders that cannot call cancel() before they draw, which clears the image area instead. All
+ * functions do nothing while the transition is not armed.
+ */
+class Slide
+{
+public:
+    static void arm();
+
+    static void begin(uint8_t x, uint8_t y, uint16_t w, uint16_t h);
+
+    /**
+     * @brief Reveals the rows of the image drawn so far.
+     * @param rows The number of image rows that have been drawn, from the top.
+     */
+    static void reveal(uint16_t rows)
+    {
+        if (active && image_y + rows > next_row)
+        {
+            show(image_y + rows);
+        }
+    }
+
+    static void end();
+
+    static void cancel();
+
+    /**
+     * @brief Checks if an image is sliding in.
+     * @return True if begin() has started the transition, false otherwise.
+     */
+    static bool is_active()
+    {
+        return active;
+    }
+
+    static const uint16_t AREA_TOP = 10;     ///< First display row of the image area.
+    static const uint16_t AREA_BOTTOM = 310; ///< Display row below the image area.
+
+private:
+    static void show(uint16_t row);
+
+    static bool armed;         ///< The next image is to slide in.
+    static bool active;        ///< An image is sliding in.
+    static uint8_t image_x;    ///< Display position of the image.
+    static uint16_t image_y;   ///< Display position of the image.
+    static uint16_t image_w;   ///< Size of the image on the display.
+    static uint16_t image_end; ///< Display row below the image.
+    static uint16_t next_row;  ///< First display row not revealed yet.
+};
+
+#endif // SLIDE_H
@@ -0,0 +1,33 @@
+/**
+ * @file Stack.h
+ * @brief Measurement of the RAM the stack has never reached.
+ */
+#ifndef STACK_H
+#define STACK_H
+
+#include <stdint.h>
+
+/**
+ * @class Stack
+ * @brief Reports how close the stack has come to the static variables.
+ *
+ * @details Before main() runs, the RAM between the end of the static variables and the top of the
+ * stack is filled with a known byte. The stack overwrites it as it grows, so the bytes above the
+ * variables that still hold it are the margin that was left at the deepest point reached so far,
+ * interrupts included. A margin of 0 means that the stack may have run into the variables.
+ *
+ * The PhotoAlbum object is a local of main() and is counted as stack, the Workspace and the other
+ * static variables are not. The report is written to the UART after every image when
+ * STACK_REPORT is defined.
+ */
+class Stack
+{
+public:
+    static uint16_t unused();
+
+    static void report();
+
+    static const uint8_t PAINT = 0xC5; ///< The byte the free RAM is filled with.
+};
+
+#endif // STACK_H
@@ -0,0 +1,66 @@
+/**
+ * @file StreamReader.h
+ * @brief Buffered sequential byte reader on top of a File.
+ */
+#ifndef STREAM_READER_H
+#define STREAM_READER_H
+
+#include <File.h>
+#include <stdint.h>
+
+/**
+ * @class StreamReader
+ * @brief Reads a file sequentially through a caller provided buffer.
+ *
+ * @details Image decoders consume their input one byte at a time. Going through File::read() for
+ * every byte would repeat the cluster and cache bookkeeping per byte, so the reader fetches the
+ * file in buffer sized chunks and hands out bytes from memory. The buffer is owned by the caller
+ * so that it can share RAM with other decoder state.
+ */
+class StreamReader
+{
+public:
+    StreamReader(File& file, uint8_t* buffer, uint16_t size);
+
+    /**
+     * @brief Reads the next byte.
+     * @return The byte, or -1 at the end of the file.
+     */
+    int16_t read()
+    {
+        if (index >= length && !fill())
+        {
+            return -1;
+        }
+        return buffer[index++];
+    }
+
+    uint16_t read(uint8_t* dst, uint16_t count);
+
+    void skip(uint32_t count);
+
+    void seek(uint32_t pos);
+
+    uint32_t position();
+
+    /**
+     * @brief Checks whether a read ran out of bytes.
+     * @return True once a read found no more bytes, at the end of the file or on a read error.
+     */
+    bool failed()
+    {
+        return ran_out;
+    }
+
+private:
+    File& file;      ///< The file being read.
+    uint8_t* buffer; ///< The read buffer.
+    uint16_t size;   ///< The size of the read buffer.
+    uint16_t length; ///< Number of valid bytes in the buffer.
+    uint16_t index;  ///< Position of the next byte in the buffer.
+    bool ran_out;    ///< A read found no more bytes.
+
+    bool fill();
+};
+
+#endif // STREAM_READER_H
@@ -0,0 +1,75 @@
+/**
+ * @file Thumbs.h
+ * @brief Thumbnails of the image folder, cached in a file on the card.
+ */
+#ifndef THUMBS_H
+#define THUMBS_H
+
+#include <FAT.h>
+#include <File.h>
+#include <stdint.h>
+
+/**
+ * @struct ThumbKey
+ * @brief Identifies the contents of an image file, from its directory entry.
+ */
+typedef struct
+{
+    uint32_t size;    /**< The size of the image file. */
+    uint32_t cluster; /**< The first cluster of the image file. */
+} ThumbKey;
+
+/**
+ * @class Thumbs
+ * @brief Draws thumbnails of the images of a folder from a cache file, and adds missing ones.
+ *
+ * @details The cache file THUMBS.DAT in the root directory starts with a sector that holds "THM1"
+ * and the first cluster of the folder it belongs to. A cache of another folder is emptied when it
+ * is opened. Then follows a record of RECORD_SECTORS sectors for every file of the folder, by its
+ * index: the ThumbKey of the image it was made from and WIDTH x HEIGHT big-endian RGB565 pixels.
+ * A record whose key does not match the image file, because the image was replaced or the record
+ * was never written, is stale.
+ *
+ * A thumbnail is drawn with one read of whole sectors that follow each other in the file. It is
+ * made from the image as drawn on the display and read back from the display memory: drawn
+ * straight to thumbnail size by the decoders that can scale that far, otherwise drawn into the
+ * image area and shrunk by SCALE. Either way every format the album can show has a thumbnail and
+ * the letterbox is part of it.
+ */
+class Thumbs
+{
+public:
+    Thumbs(FAT* fs);
+
+    bool open(File& root_dir, uint32_t folder_cluster);
+
+    void close();
+
+    bool draw(uint8_t index, const ThumbKey& key, uint16_t x, uint16_t y);
+
+    bool store(uint8_t index, const ThumbKey& key, uint16_t x, uint16_t y, uint8_t scale);
+
+    static const uint8_t WIDTH = 48;  ///< Width of a thumbnail.
+    static const uint8_t HEIGHT = 60; ///< Height of a thumbnail.
+    static const uint8_t SCALE = 5;   ///< Image area pixels per thumbnail pixel, each way.
+
+private:
+    bool pad(uint32_t end);
+
+    /**
+     * @brief Gets the position of a record in the cache file.
+     * @param index The index of the image.
+     * @return The file position of the record.
+     */
+    static uint32_t record_position(uint8_t index)
+    {
+        return (1 + (uint32_t) index * RECORD_SECTORS) * 512;
+    }
+
+    File file;  ///< The cache file, open for reading between calls.
+    File* root; ///< The directory of the cache file.
+
+    static const uint8_t RECORD_SECTORS = 12; ///< Sectors of a record, key and pixels.
+};
+
+#endif // THUMBS_H
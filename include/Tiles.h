@@ -0,0 +1,92 @@
+/**
+ * @file Tiles.h
+ * @brief Reader of tiled, mipmapped RGB565 album images.
+ */
+#ifndef TILES_H
+#define TILES_H
+
+#include <File.h>
+#include <stdint.h>
+
+/**
+ * @struct TilesHeader
+ * @brief Structure representing the header of a tiled image file.
+ */
+typedef struct
+{
+    uint16_t width;           /**< The width of level 0. */
+    uint16_t height;          /**< The height of level 0. */
+    uint8_t levels;           /**< The number of levels, 1 to Tiles::MAX_LEVELS. */
+    uint32_t first_sector[4]; /**< The sector of the first tile of each level. */
+} TilesHeader;
+
+/**
+ * @class Tiles
+ * @brief Draws any part of a tiled image at any of its levels, reading only the tiles in view.
+ *
+ * @details A tiled image file starts with a 512 byte header:
+ *
+ * | Offset | Size | Field                                          |
+ * |--------|------|------------------------------------------------|
+ * | 0      | 4    | "TIL1"                                         |
+ * | 4      | 2    | Width of level 0                               |
+ * | 6      | 2    | Height of level 0                              |
+ * | 8      | 1    | Number of levels, 1 to 4                       |
+ * | 9      | 3    | Zero                                           |
+ * | 12     | 16   | Sector of the first tile of each level         |
+ * | 28     | 484  | Zero                                           |
+ *
+ * Level n is the image shrunk by 2^n, rounded up, so the levels are 1, 1/2, 1/4 and 1/8 of the
+ * size. Each level is cut into TILE_SIZE x TILE_SIZE tiles of big-endian RGB565 pixels, stored row
+ * after row of tiles from the top left, and the tiles at the right and bottom edges are padded with
+ * black. A tile is TILE_SECTORS whole sectors, so the sector table of the header is all the tile
+ * directory there is: tile (tx, ty) of level n starts at sector first_sector[n] + (ty *
+ * tiles_x + tx) * TILE_SECTORS. tools/tile_pack.py makes such a file from any image.
+ *
+ * A view is drawn tile by tile, each through its own display window. Only the sectors of a tile
+ * that hold rows in view are read, through the FAT cache a tile row at a time, and the pixels go to
+ * the bus in the byte order they are stored in. Zooming out reads a smaller level rather than
+ * skipping over pixels of a larger one.
+ */
+class Tiles
+{
+public:
+    static bool parse_header(File& file, TilesHeader& header);
+
+    static bool draw(File& file, const TilesHeader& header, uint8_t x, uint8_t y);
+
+    static bool draw_area(File& file, const TilesHeader& header, uint16_t x, uint16_t y,
+                          uint16_t area_w, uint16_t area_h);
+
+    static bool draw_view(File& file, const TilesHeader& header, uint8_t level, uint16_t vx,
+                          uint16_t vy, uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+
+    /**
+     * @brief Gets the width of a level.
+     * @param header The parsed header.
+     * @param level The level.
+     * @return The width in pixels.
+     */
+    static uint16_t level_width(const TilesHeader& header, uint8_t level)
+    {
+        return ((uint32_t) header.width + (1 << level) - 1) >> level;
+    }
+
+    /**
+     * @brief Gets the height of a level.
+     * @param header The parsed header.
+     * @param level The level.
+     * @return The height in pixels.
+     */
+    static uint16_t level_height(const TilesHeader& header, uint8_t level)
+    {
+        return ((uint32_t) header.height + (1 << level) - 1) >> level;
+    }
+
+    static const uint8_t MAX_LEVELS = 4;    ///< Levels a file can have.
+    static const uint8_t TILE_SIZE = 32;    ///< Width and height of a tile.
+    static const uint8_t TILE_SECTORS = 4;  ///< Sectors per tile, 32 * 32 * 2 bytes.
+    static const uint16_t HEADER_SIZE = 512; ///< Bytes before the first tile.
+};
+
+#endif // TILES_H
@@ -0,0 +1,55 @@
+/**
+ * @file UiBars.h
+ * @brief Text fields of the UI bars, redrawn only when they change.
+ */
+#ifndef UI_BARS_H
+#define UI_BARS_H
+
+#include <stdint.h>
+
+/**
+ * @class UiBars
+ * @brief Keeps the text last drawn into each field of the top and bottom UI bars.
+ *
+ * @details Every field has a fixed position and a fixed number of character cells. set() compares
+ * the new text, padded with spaces to the width of the field, with the text on the screen and
+ * draws the field only if they differ. The field is drawn with its background in one display
+ * window by ILI9341_DrawStringCells(), so the old text never has to be erased first. The bars are
+ * the fixed areas of the display's vertical scrolling, see Slide, so they are not touched while an
+ * image is drawn.
+ *
+ * The retained text is all the state there is: one byte per cell and no string terminators.
+ */
+class UiBars
+{
+public:
+    /**
+     * @enum Field
+     * @brief The fields of the UI bars.
+     */
+    enum Field
+    {
+        NAME,       /**< Name of the current file. */
+        POSITION,   /**< "x/y" position in the folder. */
+        SIZE,       /**< Size of the current file. */
+        PREV,       /**< Previous image button. */
+        SPLIT,      /**< Separator, shows the slideshow state. */
+        NEXT,       /**< Next image button. */
+        FIELD_COUNT /**< Number of fields. */
+    };
+
+    UiBars();
+
+    void set(Field field, const char* text);
+
+    void set_P(Field field, const char* text);
+
+    void invalidate();
+
+private:
+    static const uint8_t CELLS = 57; ///< Character cells of all fields together.
+
+    char text[CELLS]; ///< The text on the screen, a run of cells per field.
+};
+
+#endif // UI_BARS_H
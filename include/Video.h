@@ -0,0 +1,81 @@
+/**
+ * @file Video.h
+ * @brief Player of raw RGB565 frame sequences.
+ */
+#ifndef VIDEO_H
+#define VIDEO_H
+
+#include <File.h>
+#include <stdint.h>
+
+/**
+ * @class Video
+ * @brief Plays raw RGB565 videos as fast as the SD card and the display bus allow.
+ *
+ * @details A video file starts with a 512 byte header:
+ *
+ * | Offset | Size | Field                                  |
+ * |--------|------|----------------------------------------|
+ * | 0      | 4    | "RGV1"                                 |
+ * | 4      | 2    | Frame width, always 240                |
+ * | 6      | 2    | Frame height, always 300               |
+ * | 8      | 2    | Number of frames                       |
+ * | 10     | 1    | Frames per second                      |
+ * | 11     | 501  | Zero                                   |
+ *
+ * The frames follow back to back as 240x300 big-endian RGB565 pixels, each padded with zeros to
+ * FRAME_SIZE bytes, so every frame starts on a sector boundary. A frame fills the image area. The
+ * pixels are in the byte order of the panel and go to the bus untouched. Only whole sectors are
+ * read with File::read(), which streams them with CMD18 and without the FAT cache when the file is
+ * contiguous, so a frame and the one after it are a single multi-block read. tools/video_pack.py
+ * makes such a file from any video.
+ *
+ * Frames are due at the times given by the frame rate, counted from the start of playback. A
+ * frame that is already past its time when the previous one is done is dropped rather than shown
+ * late, so a slow card lowers the frame rate but not the playback speed. The achieved frame rate
+ * is reported over the serial port at the end of every pass over the file, see VIDEO_REPORT.
+ */
+class Video
+{
+public:
+    Video();
+
+    bool start(File& file, uint8_t x, uint8_t y);
+
+    void stop();
+
+    /**
+     * @brief Checks if a video is being played.
+     * @return True if a video is being played, false otherwise.
+     */
+    bool is_playing()
+    {
+        return file != NULL;
+    }
+
+    bool frame_due();
+
+    bool draw_frame();
+
+    static const uint16_t FRAME_WIDTH = 240;        ///< Width of every frame.
+    static const uint16_t FRAME_HEIGHT = 300;       ///< Height of every frame.
+    static const uint16_t HEADER_SIZE = 512;        ///< Bytes before the first frame.
+    static const uint32_t FRAME_SIZE = 282UL * 512; ///< Bytes per frame, 144000 rounded up.
+
+private:
+    uint32_t frame_time(uint16_t frame);
+
+    void report();
+
+    File* file;           ///< The video file, NULL when not playing.
+    uint8_t x;            ///< Display position of the frames.
+    uint8_t y;            ///< Display position of the frames.
+    uint16_t frame_count; ///< Number of frames in the file.
+    uint8_t fps;          ///< Frames per second.
+    uint16_t next_frame;  ///< Index of the next frame to show.
+    uint32_t start_time;  ///< Millis at which the current pass started.
+    uint16_t shown;       ///< Frames shown in the current pass.
+    uint16_t dropped;     ///< Frames dropped in the current pass.
+};
+
+#endif // VIDEO_H
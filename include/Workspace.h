@@ -0,0 +1,80 @@
+/**
+ * @file Workspace.h
+ * @brief RAM shared by the image decoders.
+ */
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#include <stdint.h>
+
+/**
+ * @class Workspace
+ * @brief One static buffer that holds the large buffers of whichever decoder is running.
+ *
+ * @details Only one image is decoded at a time: a decoder runs to the end of its image or frame
+ * before anything else is drawn, and the image and thumbnail caches store or draw only after it
+ * has returned. The row, sector, table and dictionary buffers of all of them therefore share this
+ * buffer instead of each taking its own room on the stack. Each decoder gathers its buffers in a
+ * struct or union and maps it onto the workspace with get(), which checks at compile time that it
+ * fits. The contents are not kept from one call of a decoder to the next, unless it maps them with
+ * an Owner: they are then kept until anything else maps the workspace or it is released.
+ *
+ * SIZE is a sector and a 256 byte window, the most any decoder needs, see Lz565 and Qoi. Since the
+ * buffer is static its size is part of the .bss that avr-size reports, and the stack only has to
+ * hold the small locals of the decoders on top of the call frames, see Stack.
+ */
+class Workspace
+{
+public:
+    static const uint16_t SIZE = 768; ///< Bytes of the workspace.
+
+    /**
+     * @enum Owner
+     * @brief Users that keep contents in the workspace from one call to the next.
+     */
+    enum Owner
+    {
+        NOBODY,  /**< The contents are not kept. */
+        BMP_VIEW /**< The colour table of the zoomed BMP image, see Bmp::draw_view(). */
+    };
+
+    /**
+     * @brief Maps the buffers of a decoder onto the workspace.
+     * @return The buffers, with undefined contents.
+     */
+    template <typename T> static T& get()
+    {
+        static_assert(sizeof(T) <= SIZE, "The buffers do not fit the workspace");
+        owner = NOBODY;
+        return *(T*) buffer;
+    }
+
+    /**
+     * @brief Maps the buffers of a user that keeps contents onto the workspace.
+     * @param user The user.
+     * @param kept Set to true if the contents are as the user left them, false if they are
+     * undefined.
+     * @return The buffers.
+     */
+    template <typename T> static T& get(Owner user, bool& kept)
+    {
+        static_assert(sizeof(T) <= SIZE, "The buffers do not fit the workspace");
+        kept = owner == user;
+        owner = user;
+        return *(T*) buffer;
+    }
+
+    /**
+     * @brief Drops the contents kept in the workspace.
+     */
+    static void release()
+    {
+        owner = NOBODY;
+    }
+
+private:
+    static uint16_t buffer[SIZE / 2]; ///< The workspace, word aligned for 16-bit tables.
+    static uint8_t owner;             ///< The Owner of the contents.
+};
+
+#endif // WORKSPACE_H
@@ -27,6 +27,135 @@
 #define TFT_HEIGHT 320UL
 #define BUFFPIXEL  240
 
+/**
+ * @def FAT_MIRROR_DEFER_MAX
+ * @brief Number of FAT blocks whose mirror copy may be left stale.
+ *
+ * A dirty FAT block only has its primary copy written when it leaves the cache. The mirror
+ * copies are written on FAT::sync() (File::sync() / File::close()) or once this many distinct
+ * blocks are pending.
+ */
+#define FAT_MIRROR_DEFER_MAX 4
+
+/**
+ * @def BMP_FIT
+ * @brief Scale BMP images to fit the image area, keeping their aspect ratio.
+ *
+ * Large images are shrunk and small ones are enlarged by a whole factor. Comment this line out to
+ * crop large images to their top-left corner and to centre small ones at their own size.
+ */
+#define BMP_FIT
+
+/**
+ * @def BMP_BOX_FILTER
+ * @brief Shrink 24 bpp and 16 bpp BMP images with a box filter instead of nearest neighbour.
+ *
+ * The box filter averages every source pixel and so has to read the whole image. Nearest neighbour
+ * reads only the rows and columns it samples, which is much faster for large images.
+ */
+// #define BMP_BOX_FILTER
+
+/**
+ * @def BMP_DITHER
+ * @brief Convert 24 bpp BMP pixels to RGB565 with a 4x4 ordered dither instead of truncating.
+ *
+ * Dithering removes the banding of smooth gradients. See Dither for its cost.
+ */
+#define BMP_DITHER
+
+/**
+ * @def BMP_INTERLACE
+ * @brief Draw uncompressed BMP images in four interlaced passes instead of top to bottom.
+ *
+ * The first pass draws every 8th row 8 rows tall, so a coarse picture is on the screen after an
+ * eighth of the image has been read. Comment this line out to draw the rows in order.
+ */
+#define BMP_INTERLACE
+
+/**
+ * @def BMP_ROTATE
+ * @brief Draw BMP images that are wider than tall in the landscape orientation of the display.
+ *
+ * The display is turned by its memory access control, so no pixel is rotated in software. Comment
+ * this line out to draw every image in portrait.
+ */
+#define BMP_ROTATE
+
+/**
+ * @def SLIDE_TRANSITION
+ * @brief Slide a new image in from the bottom while it is drawn, instead of clearing the screen.
+ *
+ * Only images drawn top to bottom slide in, see Slide. Comment this line out to clear the screen
+ * before every image.
+ */
+#define SLIDE_TRANSITION
+
+/**
+ * @def SLIDESHOW_INTERVAL_MS
+ * @brief Time in milliseconds each image is shown in slideshow mode.
+ */
+#define SLIDESHOW_INTERVAL_MS 5000
+
+/**
+ * @def LONG_PRESS_MS
+ * @brief Time in milliseconds a button has to be held to toggle the slideshow.
+ */
+#define LONG_PRESS_MS 1000
+
+/**
+ * @def PAN_STEP
+ * @brief Display pixels the zoomed view moves per step of the joystick.
+ */
+#define PAN_STEP 40
+
+/**
+ * @def PAN_REPEAT_MS
+ * @brief Time in milliseconds between the steps of the zoomed view while the joystick is held.
+ */
+#define PAN_REPEAT_MS 200
+
+/**
+ * @def VIDEO_REPORT
+ * @brief Report the frame rate a video achieved over the serial port.
+ *
+ * At the end of every pass over a video the frames shown and dropped and the achieved frame rate
+ * are written to the UART, whether or not DEBUG_SERIAL is defined. Without DEBUG_SERIAL only the
+ * transmitter is set up and stdio is not used. Comment this line out to leave the UART unused.
+ */
+#define VIDEO_REPORT
+
+/**
+ * @def STACK_REPORT
+ * @brief Report the RAM the stack has never reached over the serial port.
+ *
+ * After every image the bytes between the static variables and the deepest point the stack has
+ * reached since start-up are written to the UART, see Stack. Uncomment this line to measure the
+ * RAM margin on the target.
+ */
+// #define STACK_REPORT
+
+/**
+ * @def INPUT_POLL_MS
+ * @brief Time in milliseconds between polls of the joystick, which also debounces it.
+ */
+#define INPUT_POLL_MS 50
+
+/**
+ * @def TASK_SLICE_MS
+ * @brief Time in milliseconds a task may run before work done in steps yields, see Scheduler.
+ */
+#define TASK_SLICE_MS 10
+
+/**
+ * @def IMAGE_CACHE_KB
+ * @brief Card space in KiB the image cache may use, see ImageCache.
+ *
+ * A still image is stored on the card as drawn the first time it is shown, and later drawn from
+ * there. When the space is used up the image shown least recently is dropped. Comment this line
+ * out to decode every image from its file each time.
+ */
+#define IMAGE_CACHE_KB 4096
+
 /**
  * @defgroup SPI_PIN SPI pins and registers
  * @brief SPI pins and registers used for connecting with the SD card
@@ -50,8 +179,12 @@
 #define IMG_CTRL_PORT PORTA /**< Joystick port register */
 #define IMG_CTRL_PIN  PINA  /**< Joystick pin register */
 #define IMG_CTRL_DDR  DDRA  /**< Joystick ddr register */
-#define IMG_NEXT      0     /**< Joystick pin for the next image */
-#define IMG_PREV      1     /**< Joystick pin for the previous image */
+#define IMG_NEXT      0     /**< Joystick pin for the next image, right when zoomed */
+#define IMG_PREV      1     /**< Joystick pin for the previous image, left when zoomed */
+#define IMG_UP        2     /**< Joystick pin for up when zoomed */
+#define IMG_DOWN      3     /**< Joystick pin for down when zoomed */
+#define IMG_ZOOM      4     /**< Joystick push pin for the zoom level */
+#define IMG_CTRL_MASK (_BV(IMG_NEXT) | _BV(IMG_PREV) | _BV(IMG_UP) | _BV(IMG_DOWN) | _BV(IMG_ZOOM))
 /** @}*/
 
 #endif // CONFIG_H
\ No newline at end of file
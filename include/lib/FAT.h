@@ -32,6 +32,7 @@
 
 #include <SDCard.h> // For now the only option
 #include <FatStructs.h>
+#include <config.h>
 
 union cache_t {
            /** Used to access cached file data blocks. */
@@ -48,6 +49,24 @@ union cache_t {
   fbs_t    fbs;
 };
 
+/** Geometry of a mounted volume - enough to mount it again without the MBR. */
+struct fat_volume_t {
+           /** Block holding the volume boot sector. */
+  uint32_t boot_block;
+           /** Volume serial number from the boot sector. */
+  uint32_t serial;
+  uint32_t blocks_per_fat;
+  uint32_t fat_start_block;
+  uint32_t root_dir_start;
+  uint32_t data_start_block;
+  uint32_t cluster_count;
+  uint16_t root_dir_entry_cnt;
+  uint8_t  fat_count;
+  uint8_t  blocks_per_cluster;
+  uint8_t  cluster_size_shift;
+  uint8_t  fat_type;
+};
+
 class FAT {
 public:
     enum class Type {
@@ -58,6 +77,8 @@ public:
 
     FAT(SDCard *dev);
     bool mount();
+    bool mount(const fat_volume_t *volume);
+    void get_volume(fat_volume_t *volume);
     Type get_type();
     uint32_t get_cluster_count();
     uint8_t get_blocks_per_cluster();
@@ -67,15 +88,18 @@ public:
     uint32_t get_root_entry_count();
     uint32_t get_root_start();
     bool get_chain_size(uint32_t cluster, uint32_t *size);
+    bool is_contiguous(uint32_t cluster, uint32_t size);
     uint8_t get_block(uint32_t position);
     uint32_t get_start_block(uint32_t cluster);
     uint32_t get_cache_block_no();
 
     bool read_data(uint32_t block, uint16_t offset, uint16_t count, uint8_t *buffer);
+    bool read_start(uint32_t block);
     uint8_t* get_buffer_data_ptr();
     dir_t* get_buffer_dir_ptr();
 
     bool flush_cache();
+    bool sync();
     bool is_eoc(uint32_t cluster);
     uint8_t get_cluster_size_shift();
     bool free_chain(uint32_t cluster);
@@ -85,6 +109,9 @@ public:
     void set_cache_block_no(uint32_t block_no);
 
     bool write_block(uint32_t block, const uint8_t *dst);
+    bool write_start(uint32_t block, uint32_t count);
+    bool write_data(const uint8_t *src);
+    bool write_stop();
     void set_cache_dirty();
 
 
@@ -95,11 +122,18 @@ public:
 private:
     SDCard *dev;
 
+    uint32_t boot_block;
+    uint32_t volume_serial;
+
     uint32_t cache_block_no;
     bool cache_dirty;
     cache_t buffer;
     uint32_t cache_mirror_block;
 
+    // FAT blocks whose primary copy is on the card but whose mirrors are stale
+    uint32_t mirror_dirty[FAT_MIRROR_DEFER_MAX];
+    uint8_t mirror_dirty_cnt;
+
     uint8_t fat_count;
     uint8_t blocks_per_cluster;
     uint8_t cluster_size_shift;
@@ -112,7 +146,10 @@ private:
     Type fat_type;
     uint32_t alloc_search_start;
 
+    bool mount_volume(uint32_t start_block);
     bool put_fat(uint32_t cluster, uint32_t value);
+    bool defer_mirror(uint32_t block);
+    bool flush_mirrors();
 
 
 };
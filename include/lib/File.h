@@ -75,7 +75,8 @@ public:
 
         // bits defined in flags_    
         F_OFLAG = (O_ACCMODE | O_APPEND | O_SYNC), // should be 0XF
-        F_UNUSED = 0X30, // available bits
+        F_FILE_CONTIGUOUS = 0X10, // clusters form one run - no FAT lookups
+        F_UNUSED = 0X20, // available bits
         F_FILE_UNBUFFERED_READ = 0X40,   // use unbuffered SD read
         F_FILE_DIR_DIRTY = 0X80 // sync of directory entry required
     };
@@ -89,6 +90,7 @@ public:
     bool open_root();
     bool ls(char *buffer, uint8_t options);
     bool ls(char *buffer, uint8_t options, uint8_t index);
+    dir_t* ls_next(uint8_t options);
     bool is_dir();
 
     int16_t read(uint8_t *buffer, uint16_t size);
@@ -98,12 +100,17 @@ public:
     bool is_file();
 
     bool open(File &dir, const char *filename, uint8_t oflag);
+    bool open_entry(File &dir, uint16_t entry, uint8_t oflag);
+    bool open_dir(uint32_t cluster);
+    bool make_dir(File &dir, const char *name, uint8_t attributes);
     bool close();
     bool sync();
     static bool make83name(const char *str, uint8_t *name);
 
     uint32_t get_current_position();
     uint32_t get_file_size();
+    uint32_t get_first_cluster();
+    uint32_t get_modified();
     Type get_type();
     bool add_dir_cluster();
     uint32_t available();
@@ -111,6 +118,10 @@ public:
 
     int print(const char* format, ...);
     size_t write(const uint8_t *buffer, uint16_t size);
+    bool preallocate(uint32_t size);
+    bool write_start();
+    bool write_next(const uint8_t *block);
+    bool write_stop();
     bool seek(uint32_t pos) {
         return seek_set(pos);
     }
@@ -136,6 +147,7 @@ private:
  
     dir_t* read_dir_cache();
     uint8_t is_unbuffered_read();
+    uint8_t is_contiguous();
 
     bool fill_name(dir_t* p, char* buffer, uint8_t options);    
 
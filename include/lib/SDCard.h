@@ -65,18 +65,33 @@ public:
         WRITE_PROGRAMMING = 0X14, /** card returned an error to a CMD13 status check after a write */
         WRITE_TIMEOUT = 0X15,     /** timeout occurred during write programming */
         SCK_RATE = 0X16,          /** incorrect rate selected */
+        CMD18 = 0X17,             /** card returned an error response for CMD18 (read multiple blocks) */
+        CMD12 = 0X18,             /** card returned an error response for CMD12 (stop transmission) */
+    };
+
+    enum class InitStatus {
+        BUSY,       /** card is still in its ACMD41 initialization */
+        READY,      /** card is initialized */
+        FAILED      /** initialization failed - see get_error() */
     };
 
     SDCard(volatile uint8_t *port_cs, volatile uint8_t *ddr_cs, uint8_t pin_cs);
     bool init();
+    bool init_start();
+    InitStatus init_poll();
     Type get_type();
     Error get_error();
 
     bool write_block(uint32_t block_no, const uint8_t* src);
+    bool write_start(uint32_t block_no, uint32_t count);
+    bool write_data(const uint8_t* src);
+    bool write_stop();
     bool read_block(uint32_t block, uint8_t *dst);
 
     bool read_data(uint32_t block, uint16_t offset, uint16_t count, uint8_t *dst);
 
+    bool read_start(uint32_t block);
+    bool read_stop();
 
 private:
     volatile uint8_t *PORT_CS;
@@ -89,6 +104,8 @@ private:
     Type type;
     uint32_t block;
     uint8_t partial_block_read;
+    uint8_t multi_block;
+    uint32_t init_then;
 
     void deselect();
     void select();
@@ -98,6 +115,7 @@ private:
     uint8_t send_acmd(uint8_t cmd, uint32_t arg);
 
     bool write_data(uint8_t token, const uint8_t* src);
+    void write_abort();
 
     bool wait_start_block();
 
@@ -112,8 +130,10 @@ private:
     static const uint8_t CMD8 = 0x08;   /** SEND_IF_COND - verify SD Memory Card interface operating condition.*/
     static const uint8_t CMD9 = 0X09;   /** SEND_CSD - read the Card Specific Data (CSD register) */
     static const uint8_t CMD10 = 0X0A;  /** SEND_CID - read the card identification information (CID register) */    
+    static const uint8_t CMD12 = 0X0C;  /** STOP_TRANSMISSION - end multiple block read sequence */
     static const uint8_t CMD13 = 0X0D;  /** SEND_STATUS - read the card status register */
     static const uint8_t CMD17 = 0X11;  /** READ_BLOCK - read a single data block from the card */
+    static const uint8_t CMD18 = 0X12;  /** READ_MULTIPLE_BLOCK - read blocks of data until a STOP_TRANSMISSION */
     static const uint8_t CMD24 = 0X18;  /** WRITE_BLOCK - write a single data block to the card */
     static const uint8_t CMD25 = 0X19;  /** WRITE_MULTIPLE_BLOCK - write blocks of data until a STOP_TRANSMISSION */
     static const uint8_t CMD32 = 0X20;  /** ERASE_WR_BLK_START - sets the address of the first block to be erased */
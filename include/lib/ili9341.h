@@ -137,6 +137,16 @@
   // T pulse L -> Tl = 31.25ns > twrl - condition satisfied
   #define WR_IMPULSE()          { ILI9341_PORT_CONTROL &= ~(1 << ILI9341_PIN_WR); ILI9341_PORT_CONTROL |= (1 << ILI9341_PIN_WR); }
 
+  // RD Impulse - condition
+  // ---------------------------------------------------------------
+  // Read Control pulse L duration for memory -> trdlfm > 355ns
+  // Read access time for memory              -> tratfm < 340ns
+  // ---------------------------------------------------------------
+  // the data is sampled 3 cycles after RD goes LOW, which is more
+  // than 340ns up to 8 MHz
+  #define RD_LOW()              { ILI9341_PORT_CONTROL &= ~(1 << ILI9341_PIN_RD); __asm__ __volatile__ ("nop\n\tnop\n\tnop"); }
+  #define RD_HIGH()             { ILI9341_PORT_CONTROL |= (1 << ILI9341_PIN_RD); }
+
   // SOFTWARE DEFINITION
   // ---------------------------------------------------------------
   #define ILI9341_SUCCESS       0
@@ -170,6 +180,24 @@
     X3 = 0x81
   } ILI9341_Sizes;
 
+  // MADCTL row address order
+  #define ILI9341_MADCTL_MY     0x80
+  // MADCTL column address order
+  #define ILI9341_MADCTL_MX     0x40
+  // MADCTL row / column exchange
+  #define ILI9341_MADCTL_MV     0x20
+  // MADCTL BGR order of the panel
+  #define ILI9341_MADCTL_BGR    0x08
+
+  /** @enum Orientations of the memory address space */
+  typedef enum {
+    // 240 columns x 320 rows, set by INIT_ILI9341
+    PORTRAIT = ILI9341_MADCTL_MX | ILI9341_MADCTL_BGR,
+    // 320 columns x 240 rows, column 0 is portrait row 0
+    //      and row 0 is portrait column 239
+    LANDSCAPE = ILI9341_MADCTL_MV | ILI9341_MADCTL_BGR
+  } ILI9341_Orientations;
+
   /** @const Command list ILI9341B */
   extern const uint8_t INIT_ILI9341[];
 
@@ -182,6 +210,17 @@
    */
   void ILI9341_Init (void);
 
+  /**
+   * @desc    LCD Init step by step - lets the caller use the delays
+   *          of the init sequence for other work; the first call
+   *          starts the hardware reset
+   *
+   * @param   uint16_t * -> delay in ms required before the next step
+   *
+   * @return  char -> 1 if more steps follow, 0 when init is done
+   */
+  char ILI9341_InitStep (uint16_t *);
+
   /**
    * @desc    LCD Hardware Reset
    *
@@ -258,6 +297,83 @@
    */
   void ILI9341_SendColor565 (uint16_t, uint32_t);
 
+  /**
+   * @desc    LCD Write Color Pixels - continue memory write
+   *          started by RAMWR, chip select is held for the run
+   *
+   * @param   uint16_t
+   * @param   uint32_t
+   *
+   * @return  void
+   */
+  void ILI9341_PushColor565 (uint16_t, uint32_t);
+
+  /**
+   * @desc    LCD Write Pixels - continue memory write with
+   *          little-endian RGB565 pixels, chip select is held
+   *
+   * @param   const uint8_t *
+   * @param   uint16_t
+   *
+   * @return  void
+   */
+  void ILI9341_PushPixels565LE (const uint8_t *, uint16_t);
+
+  /**
+   * @desc    LCD Write Pixels - continue memory write with
+   *          big-endian RGB565 pixels, chip select is held
+   *
+   * @param   const uint8_t *
+   * @param   uint16_t
+   *
+   * @return  void
+   */
+  void ILI9341_PushPixels565BE (const uint8_t *, uint16_t);
+
+  /**
+   * @desc    LCD Start memory read of the window set before,
+   *          the data bus is turned to input and chip select
+   *          is held until ILI9341_ReadEnd
+   *
+   * @param   void
+   *
+   * @return  void
+   */
+  void ILI9341_ReadStart (void);
+
+  /**
+   * @desc    LCD Read Pixel - continue memory read started
+   *          by ILI9341_ReadStart
+   *
+   * @param   void
+   *
+   * @return  uint16_t - color in 565 mode
+   */
+  uint16_t ILI9341_PullColor565 (void);
+
+  /**
+   * @desc    LCD End memory read, the data bus is turned
+   *          back to output
+   *
+   * @param   void
+   *
+   * @return  void
+   */
+  void ILI9341_ReadEnd (void);
+
+  /**
+   * @desc    LCD Fill window with one color
+   *
+   * @param   uint16_t - x start position
+   * @param   uint16_t - y start position
+   * @param   uint16_t - x end position
+   * @param   uint16_t - y end position
+   * @param   uint16_t - color
+   *
+   * @return  char
+   */
+  char ILI9341_FillWindow (uint16_t, uint16_t, uint16_t, uint16_t, uint16_t);
+
   /**
    * @desc    LCD Draw Pixel
    *
@@ -278,6 +394,37 @@
    */
   void ILI9341_ClearScreen (uint16_t);
 
+  /**
+   * @desc    LCD Set vertical scrolling area between
+   *          fixed top and bottom areas
+   *
+   * @param   uint16_t - rows of the fixed top area
+   * @param   uint16_t - rows of the fixed bottom area
+   *
+   * @return  char
+   */
+  char ILI9341_SetScrollArea (uint16_t, uint16_t);
+
+  /**
+   * @desc    LCD Set memory row shown at the top of
+   *          the vertical scrolling area
+   *
+   * @param   uint16_t - row within the scrolling area
+   *
+   * @return  void
+   */
+  void ILI9341_SetScrollStart (uint16_t);
+
+  /**
+   * @desc    LCD Set orientation of the memory address space,
+   *          the pixels already on the panel stay as they are
+   *
+   * @param   ILI9341_Orientations
+   *
+   * @return  void
+   */
+  void ILI9341_SetOrientation (ILI9341_Orientations);
+
   /**
    * @desc    LCD Inverse Screen
    *
@@ -386,6 +533,30 @@
    */
   void ILI9341_DrawString (char*, uint16_t, ILI9341_Sizes);
 
+  /**
+   * @desc    Draw string from program memory
+   *
+   * @param   const char* -> string in program memory
+   * @param   uint16_t -> color
+   * @param   ILI9341_Sizes -> size
+   *
+   * @return  void
+   */
+  void ILI9341_DrawString_P (const char*, uint16_t, ILI9341_Sizes);
+
+  /**
+   * @desc    Draw string into a fixed number of character
+   *          cells with background, in one window
+   *
+   * @param   const char* -> string, padded or cut to the cells
+   * @param   uint8_t -> number of cells
+   * @param   uint16_t -> color
+   * @param   uint16_t -> background color
+   *
+   * @return  void
+   */
+  void ILI9341_DrawStringCells (const char*, uint8_t, uint16_t, uint16_t);
+
   /**
    * @desc    Delay
    *
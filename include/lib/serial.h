@@ -13,8 +13,12 @@
 #include <avr/io.h>
 #include <util/setbaud.h>
 
+void uart_write(char c);
+void uart_print_P(const char* text);
+void uart_print(uint16_t value);
 int uart_putchar(char c, FILE *stream);
 int uart_getchar(FILE *stream);
+void uart_init_tx();
 void uart_init();
 
 
@@ -1,16 +1,16 @@
-
 /**
  * @file main.cpp
  * @brief Program entrypoint.
  */
 
 #include <PhotoAlbum.h>
-#include <util/delay.h>
+#include <Scheduler.h>
 
 /**
  * @brief The main function of the program.
  *
- * @details This function initializes the PhotoAlbum object, listens for user input in a while loop.
+ * @details This function initializes the PhotoAlbum object, adds its tasks to the scheduler and
+ * runs them, see PhotoAlbum::start_tasks().
  *
  * @return int The exit status of the program.
  */
@@ -18,11 +18,8 @@ int main()
 {
     PhotoAlbum photoAlbum;
     photoAlbum.init();
-    while (1)
-    {
-        photoAlbum.listen_for_input();
-        _delay_ms(50);
-    }
+    photoAlbum.start_tasks();
+    Scheduler::run();
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,1259 @@
+/**
+ * @file Bmp.cpp
+ * @brief Decoder of BMP images with scaling to the image area.
+ *
+ * This file contains the implementation of the Bmp class, which streams the pixel rows of a BMP
+ * file to the display, cropped, scaled or interlaced, and decodes RLE compressed ones.
+ */
+#include <Bmp.h>
+#include <Slide.h>
+#include <StreamReader.h>
+#include <Workspace.h>
+extern "C"
+{
+#include <ili9341.h>
+}
+
+/**
+ * Parses the BMP header of a given file.
+ *
+ * Uncompressed 24 bpp and 16 bpp images and palettized 8 bpp and 4 bpp images are supported.
+ * Palettized images may also be RLE8 or RLE4 compressed. 16 bpp images must be RGB555, or use
+ * RGB565 or RGB555 bitfield masks.
+ *
+ * @param bmp_file The file to parse the BMP header from.
+ * @param header The BMPHeader object to store the parsed header information.
+ * @return True if the BMP header was successfully parsed, false otherwise.
+ */
+bool Bmp::parse_header(File& bmp_file, BMPHeader& header)
+{
+    // BMP Signature
+    if (File::read16(bmp_file) != 0x4D42)
+    {
+        return false;
+    }
+
+    // File size
+    File::read32(bmp_file);
+
+    // Read & ignore creator bytes
+    File::read32(bmp_file);
+
+    // Offset to start of image data
+    header.data_offset = File::read32(bmp_file);
+
+    // Header Size
+    header.header_size = File::read32(bmp_file);
+
+    // Width
+    header.width = File::read32(bmp_file);
+
+    // Height
+    header.height = File::read32(bmp_file);
+
+    // Number of planes - must be 1
+    if (File::read16(bmp_file) != 1)
+    {
+        return false;
+    }
+
+    // Depth - Bits per pixel - 24, 16, 8 and 4 supported
+    header.depth = File::read16(bmp_file);
+    if (header.depth != 24 && header.depth != 16 && header.depth != 8 && header.depth != 4)
+    {
+        return false;
+    }
+
+    // Compression - uncompressed, or run-length encoding or bitfields matching the depth
+    header.compression = File::read32(bmp_file);
+    if (header.compression != BI_RGB &&
+        !(header.compression == BI_RLE8 && header.depth == 8) &&
+        !(header.compression == BI_RLE4 && header.depth == 4) &&
+        !(header.compression == BI_BITFIELDS && header.depth == 16))
+    {
+        return false;
+    }
+    // Compressed images are always stored bottom-to-top
+    if ((header.compression == BI_RLE8 || header.compression == BI_RLE4) && header.height < 0)
+    {
+        return false;
+    }
+
+    header.rgb555 = false;
+    if (header.depth == 16)
+    {
+        // Image size, resolution and colour counts
+        for (uint8_t i = 0; i < 5; i++)
+        {
+            File::read32(bmp_file);
+        }
+
+        // Without masks 16 bpp pixels are RGB555
+        header.rgb555 = true;
+        if (header.compression == BI_BITFIELDS)
+        {
+            uint32_t red = File::read32(bmp_file);
+            uint32_t green = File::read32(bmp_file);
+            uint32_t blue = File::read32(bmp_file);
+            if (red == 0xF800 && green == 0x07E0 && blue == 0x001F)
+            {
+                header.rgb555 = false;
+            }
+            else if (red != 0x7C00 || green != 0x03E0 || blue != 0x001F)
+            {
+                return false;
+            }
+        }
+    }
+
+    header.colors = 0;
+    if (header.depth <= 8)
+    {
+        // Image size, horizontal and vertical resolution
+        File::read32(bmp_file);
+        File::read32(bmp_file);
+        File::read32(bmp_file);
+
+        // Colors used - 0 means all
+        uint32_t colors = File::read32(bmp_file);
+        if (colors == 0 || colors > (1UL << header.depth))
+        {
+            colors = 1UL << header.depth;
+        }
+        header.colors = colors;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Gets the size of one pixel row in the file.
+ *
+ * @param header The parsed BMP header.
+ * @return The row size in bytes, including the padding to a 4-byte boundary.
+ */
+uint32_t Bmp::row_size(const BMPHeader& header)
+{
+    return ((header.width * header.depth + 31) >> 5) << 2;
+}
+
+/**
+ * @brief Gets the file position of the first pixel row drawn.
+ *
+ * @details BMP images are normally stored bottom-to-top, so the top row is the last one in the
+ * file. Compressed images can only be decoded from the start of their data.
+ *
+ * @param header The parsed BMP header.
+ * @return The file position of the top row of the image.
+ */
+uint32_t Bmp::first_row_position(const BMPHeader& header)
+{
+    if (header.height < 0 || header.compression == BI_RLE8 || header.compression == BI_RLE4)
+    {
+        return header.data_offset;
+    }
+    return header.data_offset + (header.height - 1) * row_size(header);
+}
+
+/**
+ * @brief Reads the colour table of a palettized BMP into an RGB565 lookup table.
+ *
+ * @details The colour table follows the info header and stores one B, G, R, reserved quadruple per
+ * entry. Entries past the colour count are set to black, so out of range indices are harmless.
+ *
+ * @param bmpFile The File object representing the BMP file.
+ * @param header The parsed BMP header of the file.
+ * @param lut The 256 entry lookup table to fill.
+ */
+void Bmp::load_palette(File& bmpFile, const BMPHeader& header, uint16_t* lut)
+{
+    uint8_t bgrx[4];
+    uint16_t i;
+
+    bmpFile.seek(14 + header.header_size);
+    for (i = 0; i < header.colors; i++)
+    {
+        bmpFile.read(bgrx, sizeof(bgrx));
+        lut[i] = (bgrx[2] & 0xF8) << 8 | (bgrx[1] & 0xFC) << 3 | bgrx[0] >> 3;
+    }
+    for (; i < 256; i++)
+    {
+        lut[i] = ILI9341_BLACK;
+    }
+}
+
+/**
+ * @brief Reads the pixel at a column of a row, unless its bytes were read last.
+ *
+ * @details The reader is moved past the pixel. A 4 bpp pixel shares its byte with a neighbour, so
+ * the byte is kept in px[1] and px[0] is set to the palette index of the pixel.
+ *
+ * @param reader The reader over the file, in a row.
+ * @param header The parsed BMP header of the file.
+ * @param col The column of the pixel.
+ * @param offset The position of the reader in the row, moved past the pixel.
+ * @param loaded The position in the row of the bytes in px, 0xFFFFFFFF if none.
+ * @param px The pixel, 3 bytes.
+ * @return True if px holds another pixel than before, false if it is the same one.
+ */
+bool Bmp::read_pixel(StreamReader& reader, const BMPHeader& header, uint32_t col, uint32_t& offset,
+                     uint32_t& loaded, uint8_t* px)
+{
+    uint32_t pos = col * header.depth >> 3;
+    bool fresh = pos != loaded;
+    if (fresh)
+    {
+        uint8_t bytes = header.depth >= 8 ? header.depth >> 3 : 1;
+        reader.skip(pos - offset);
+        reader.read(header.depth == 4 ? px + 1 : px, bytes);
+        offset = pos + bytes;
+        loaded = pos;
+    }
+    if (header.depth == 4)
+    {
+        // Two pixels per byte, high nibble first
+        px[0] = col & 1 ? px[1] & 0x0F : px[1] >> 4;
+        return true;
+    }
+    return fresh;
+}
+
+/**
+ * @brief Draws a BMP image on the display at the specified coordinates.
+ *
+ * @details This function parses the BMP header of the given File object and draws the image, see
+ * draw(File&, BMPHeader&, uint8_t, uint8_t). The file is closed afterwards.
+ *
+ * @param bmpFile The File object representing the BMP file.
+ * @param x The x-coordinate of the top-left corner of the image on the display.
+ * @param y The y-coordinate of the top-left corner of the image on the display.
+ * @return True if the whole image was drawn, false otherwise.
+ */
+bool Bmp::draw(File& bmpFile, uint8_t x, uint8_t y)
+{
+    BMPHeader header;
+    if (!parse_header(bmpFile, header))
+    {
+        DEBUG("Invalid BMP file\n");
+        bmpFile.close();
+        return false;
+    }
+    DEBUG("Valid BMP file\n");
+    return draw(bmpFile, header, x, y);
+}
+
+/**
+ * @brief Draws a BMP image into the image area at the specified coordinates.
+ *
+ * @details The image area reaches from (x, y) to the right edge of the display and down to the
+ * bottom UI bar. With BMP_ROTATE an image that is wider than it is tall is drawn in the landscape
+ * orientation of the display, see ILI9341_SetOrientation(), in which the same image area is 300
+ * columns wide and 240 rows tall. The display exchanges rows and columns itself, so the rows are
+ * still read from the file in order and streamed as they are. Landscape images cannot slide in,
+ * because their rows run across the scrolling direction, see Slide. The display is set back to
+ * portrait afterwards. The image is drawn by draw_area() and the file is closed.
+ *
+ * @param bmpFile The File object representing the BMP file.
+ * @param header The parsed BMP header of the file.
+ * @param x The x-coordinate of the top-left corner of the image area on the display.
+ * @param y The y-coordinate of the top-left corner of the image area on the display.
+ * @return True if the whole image was drawn, false otherwise.
+ */
+bool Bmp::draw(File& bmpFile, BMPHeader& header, uint8_t x, uint8_t y)
+{
+    if ((x >= TFT_WIDTH) || (y >= TFT_HEIGHT - 10))
+    {
+        bmpFile.close();
+        return false;
+    }
+
+#if defined(BMP_ROTATE)
+    if (header.width > header.height && header.width > -header.height)
+    {
+        // Portrait row y is landscape column y, portrait column x is landscape row 239 - x
+        Slide::cancel();
+        ILI9341_SetOrientation(ILI9341_Orientations::LANDSCAPE);
+        bool drawn = draw_area(bmpFile, header, y, 0, TFT_HEIGHT - 10 - y, TFT_WIDTH - x);
+        ILI9341_SetOrientation(ILI9341_Orientations::PORTRAIT);
+        return drawn;
+    }
+#endif
+    return draw_area(bmpFile, header, x, y, TFT_WIDTH - x, TFT_HEIGHT - 10 - y);
+}
+
+/**
+ * @brief Maps the buffers of draw_area() or draw_view() onto the Workspace.
+ *
+ * @details For a palettized image the colour table is converted into the lookup table, which the
+ * pixel data shares the buffers with, and the rest is left for the pixel data. A view keeps the
+ * lookup table in the Workspace, so it is only converted for the first rows drawn after the
+ * Workspace was released or used by something else, see Workspace::get().
+ *
+ * @param bmpFile The File object representing the BMP file.
+ * @param header The parsed BMP header of the file.
+ * @param view True to keep the lookup table for the next rows of a view.
+ * @param buffer Set to the pixel data part of the buffers.
+ * @param buffsize Set to the size of the pixel data part.
+ * @return The buffers.
+ */
+Bmp::Buffers& Bmp::map_buffers(File& bmpFile, const BMPHeader& header, bool view,
+                               uint8_t*& buffer, uint16_t& buffsize)
+{
+    bool kept = false;
+    Buffers& sdbuffer = view ? Workspace::get<Buffers>(Workspace::BMP_VIEW, kept)
+                             : Workspace::get<Buffers>();
+    if (header.depth <= 8)
+    {
+        if (!kept)
+        {
+            load_palette(bmpFile, header, sdbuffer.pal.lut);
+        }
+        buffer = sdbuffer.pal.index;
+        buffsize = sizeof(sdbuffer.pal.index);
+    }
+    else
+    {
+        buffer = sdbuffer.rgb;
+        buffsize = sizeof(sdbuffer.rgb);
+    }
+    return sdbuffer;
+}
+
+/**
+ * @brief Draws a BMP image into an area of the display.
+ *
+ * @details This function reads the pixel data of a BMP file whose header has already been parsed
+ * and draws it into the area_w x area_h area at (x, y) in the current orientation of the display.
+ * With BMP_FIT the image is scaled to fit the area, see fit(), otherwise it is cropped if it
+ * exceeds the area. The image is centred in the area. The display window is set to the image once
+ * and the pixels are streamed into it row by row. Scaled images are drawn by draw_nearest() or
+ * draw_box(). With BMP_INTERLACE, images that are not enlarged are drawn by
+ * draw_interlaced() instead, unless the box filter applies or the image slides in, which needs
+ * the rows in order, see Slide. The box filter and the interlaced passes keep a whole display row
+ * in RAM, so landscape rows wider than BUFFPIXEL fall back to the paths that stream them.
+ *
+ * 24 bpp pixels are converted to the TFT format with shifts and masks, or with BMP_DITHER a buffer
+ * at a time by Dither::bgr_to_565() and streamed with a single call. For palettized images the
+ * colour table is converted once into an RGB565 lookup table, and each pixel then costs a single
+ * table load. The lookup table shares the pixel buffer, so palettized images need no extra RAM.
+ * RGB565 pixels are passed to the display a buffer at a time with only a byte swap, and RGB555
+ * pixels are expanded with one shift. RLE compressed images are decoded by draw_rle(). The
+ * buffers are kept in the Workspace. The file is closed afterwards.
+ *
+ * @param bmpFile The File object representing the BMP file.
+ * @param header The parsed BMP header of the file.
+ * @param x The x-coordinate of the top-left corner of the area on the display.
+ * @param y The y-coordinate of the top-left corner of the area on the display.
+ * @param area_w The width of the area.
+ * @param area_h The height of the area.
+ * @return True if the whole image was drawn, false if its pixel data could not be read.
+ */
+bool Bmp::draw_area(File& bmpFile, BMPHeader& header, uint16_t x, uint16_t y, int area_w,
+                    int area_h)
+{
+    uint8_t* buffer;   // Pixel data part of the buffers
+    uint16_t buffsize; // Size of the pixel data part
+    Buffers& sdbuffer = map_buffers(bmpFile, header, false, buffer, buffsize);
+    bool flip = true; // BMP is stored bottom-to-top
+    int w, h;
+
+    // If bmpHeight is negative, image is in top-down order.
+    // This is not canon but has been observed in the wild.
+    if (header.height < 0)
+    {
+        header.height = -header.height;
+        flip = false;
+    }
+
+    // Size on the display, scaled or cropped to the image area
+    w = header.width;
+    h = header.height;
+#if defined(BMP_FIT)
+    fit(header, area_w, area_h, w, h);
+#else
+    if (w > area_w)
+        w = area_w;
+    if (h > area_h)
+        h = area_h;
+#endif
+
+    // If the image is smaller than the area
+    // center vertically and horizontally
+    x += (area_w - w) / 2;
+    y += (area_h - h) / 2;
+
+    if (header.compression == BI_RLE8 || header.compression == BI_RLE4)
+    {
+        // RLE rows are decoded bottom to top
+        Slide::cancel();
+        bool drawn = draw_rle(bmpFile, header, sdbuffer.pal.lut, buffer, buffsize, x, y, w, h);
+        bmpFile.close();
+        return drawn;
+    }
+
+    // Pixels are streamed into the image area
+    Slide::begin(x, y, w, h);
+    ILI9341_SetWindow(x, y, x + w - 1, y + h - 1);
+    ILI9341_TransmitCmmd(ILI9341_RAMWR);
+
+#if defined(BMP_INTERLACE)
+    // The passes need a whole display row in the buffer, which a landscape row may not fit
+    bool interlace = !Slide::is_active() &&
+                     (header.depth <= 8 ? w : header.depth == 24 ? 3 * w : 2 * w + 2) <= buffsize;
+#endif
+
+#if defined(BMP_FIT)
+    if (w != header.width || h != header.height)
+    {
+#if defined(BMP_BOX_FILTER)
+        if (header.depth >= 16 && w < header.width && 3 * w <= (int) sizeof(sdbuffer.box.acc))
+        {
+            bool drawn = draw_box(bmpFile, header, sdbuffer.box.acc, sdbuffer.box.read,
+                                      sizeof(sdbuffer.box.read), flip, w, h);
+            bmpFile.close();
+            return drawn;
+        }
+#endif
+#if defined(BMP_INTERLACE)
+        if (w < header.width && interlace)
+        {
+            bool drawn = draw_interlaced(bmpFile, header, sdbuffer.pal.lut, buffer, buffsize,
+                                             flip, x, y, w, h, true);
+            bmpFile.close();
+            return drawn;
+        }
+#endif
+        bool drawn =
+            draw_nearest(bmpFile, header, sdbuffer.pal.lut, buffer, buffsize, flip, w, h);
+        bmpFile.close();
+        return drawn;
+    }
+#endif
+
+#if defined(BMP_INTERLACE)
+    if (interlace)
+    {
+        bool drawn = draw_interlaced(bmpFile, header, sdbuffer.pal.lut, buffer, buffsize, flip,
+                                         x, y, w, h, false);
+        bmpFile.close();
+        return drawn;
+    }
+#endif
+
+    uint32_t rowSize = row_size(header); // BMP rows are padded to a 4-byte boundary
+    uint32_t rowBytes = ((uint32_t) w * header.depth + 7) >> 3; // Drawn part of a row
+    uint32_t left;                           // Bytes of the row not read yet
+    uint16_t buffidx, bufflen;               // Current position in and end of buffer
+    int row, col, n;
+    uint32_t pos = 0;
+    bool drawn = true; // every read got its bytes
+
+    for (row = 0; row < h; row++)
+    { // For each scanline...
+        Slide::reveal(row);
+
+        // Seek to start of scan line.  It might seem labor-
+        // intensive to be doing this on every line, but this
+        // method covers a lot of gritty details like cropping
+        // and scanline padding.  Also, the seek only takes
+        // place if the file position actually needs to change
+        // (avoids a lot of cluster math in SD library).
+        if (flip) // Bitmap is stored bottom-to-top order (normal BMP)
+            pos = header.data_offset + (header.height - 1 - row) * rowSize;
+        else // Bitmap is stored top-to-bottom
+            pos = header.data_offset + row * rowSize;
+        if (bmpFile.get_current_position() != pos)
+        { // Need seek?
+            bmpFile.seek(pos);
+        }
+        // Only the drawn part of the row is read, so no row is read twice
+        left = rowBytes;
+        buffidx = bufflen = 0;
+
+        if (header.depth == 16)
+        { // 16 bpp pixels are streamed a buffer at a time
+            for (col = 0; col < w; col += n)
+            {
+                if (buffidx >= bufflen)
+                {
+                    bufflen = left < buffsize ? left : buffsize;
+                    if (bmpFile.read(buffer, bufflen) != bufflen)
+                        drawn = false;
+                    left -= bufflen;
+                    buffidx = 0;
+                }
+                n = (bufflen - buffidx) >> 1;
+                if (n > w - col)
+                    n = w - col;
+                if (!header.rgb555)
+                {
+                    // RGB565 only needs its bytes swapped
+                    ILI9341_PushPixels565LE(buffer + buffidx, n);
+                    buffidx += n << 1;
+                }
+                else
+                {
+                    // Shift red and green up, the low green bit stays 0
+                    for (int i = 0; i < n; i++, buffidx += 2)
+                    {
+                        uint16_t v = buffer[buffidx] | buffer[buffidx + 1] << 8;
+                        ILI9341_Transmit16bitData((v & 0x7FE0) << 1 | (v & 0x1F));
+                    }
+                }
+            }
+            continue;
+        }
+
+#if defined(BMP_DITHER)
+        if (header.depth == 24)
+        { // 24 bpp pixels are dithered in place and streamed a buffer at a time
+            for (col = 0; col < w; col += n)
+            {
+                if (buffidx >= bufflen)
+                {
+                    bufflen = left < buffsize ? left : buffsize;
+                    if (bmpFile.read(buffer, bufflen) != bufflen)
+                        drawn = false;
+                    left -= bufflen;
+                    buffidx = 0;
+                }
+                n = (bufflen - buffidx) / 3;
+                if (n > w - col)
+                    n = w - col;
+                Dither::bgr_to_565(buffer + buffidx, n, col, row);
+                ILI9341_PushPixels565BE(buffer + buffidx, n);
+                buffidx += 3 * n;
+            }
+            continue;
+        }
+#endif
+
+        for (col = 0; col < w; col++)
+        { // For each pixel...
+            // Time to read more pixel data?
+            if (buffidx >= bufflen)
+            { // Indeed
+                bufflen = left < buffsize ? left : buffsize;
+                if (bmpFile.read(buffer, bufflen) != bufflen)
+                    drawn = false;
+                left -= bufflen;
+                buffidx = 0; // Set index to beginning
+            }
+
+            // Convert pixel from BMP to TFT format, push to display
+            const uint8_t* px = buffer + buffidx;
+            uint8_t index;
+            if (header.depth == 4)
+            {
+                // Two pixels per byte, high nibble first
+                index = col & 1 ? *px & 0x0F : *px >> 4;
+                px = &index;
+                buffidx += col & 1;
+            }
+            else
+            {
+                buffidx += header.depth >> 3;
+            }
+            ILI9341_Transmit16bitData(pixel_to_565(header, sdbuffer.pal.lut, px, col, row));
+        } // end pixel
+    } // end scanline
+    Slide::reveal(h);
+
+    bmpFile.close();
+    return drawn;
+}
+
+/**
+ * @struct Sampler
+ * @brief Steps through the source pixels sampled along one axis of a scaled image.
+ *
+ * @details Display pixel i maps to source position floor((2i + c) * src / (2 * dst)). With c = 1
+ * that is the source pixel under the centre of the display pixel, with c = 0 the first source
+ * pixel it covers. The position is stepped without a division per pixel.
+ */
+struct Sampler
+{
+    uint32_t pos;       ///< Source position of the current display pixel.
+    uint32_t step;      ///< Whole source pixels per display pixel.
+    uint16_t frac;      ///< Fraction of the position, in 1/den.
+    uint16_t frac_step; ///< Fraction of the step, in 1/den.
+    uint16_t den;       ///< Twice the display size.
+
+    /**
+     * @brief Starts at a display pixel.
+     *
+     * @param src The source size.
+     * @param dst The display size.
+     * @param centre Sample the centre of a display pixel rather than its first source pixel.
+     * @param i The display pixel.
+     */
+    void init(uint32_t src, uint16_t dst, bool centre, uint16_t i)
+    {
+        den = 2 * dst;
+        step = 2 * src / den;
+        frac_step = 2 * src % den;
+        uint32_t num = (2UL * i + centre) * src;
+        pos = num / den;
+        frac = num % den;
+    }
+
+    /**
+     * @brief Moves to the next display pixel.
+     */
+    void next()
+    {
+        pos += step;
+        frac += frac_step;
+        if (frac >= den)
+        {
+            frac -= den;
+            pos++;
+        }
+    }
+
+    /**
+     * @brief Moves to the previous display pixel.
+     */
+    void prev()
+    {
+        pos -= step;
+        if (frac < frac_step)
+        {
+            frac += den - frac_step;
+            pos--;
+        }
+        else
+        {
+            frac -= frac_step;
+        }
+    }
+};
+
+/**
+ * @brief Draws a rectangle of an image shown at 1:2^shift.
+ *
+ * @details Every display pixel shows the source pixel in the centre of its 2^shift block. Only the
+ * sampled source rows are read, and in each of them only the range of columns in view, after a
+ * seek to its first byte. The rectangle is one display window, so its rows have to be contiguous
+ * in display memory. The lookup table of a palettized image is kept from one call to the next,
+ * see map_buffers(). The file stays open.
+ *
+ * @param bmpFile The uncompressed BMP file.
+ * @param header The parsed BMP header of the file.
+ * @param shift The zoom level as a power of two, 0 for 1:1.
+ * @param vx The left edge of the rectangle in the zoomed image.
+ * @param vy The top edge of the rectangle in the zoomed image.
+ * @param x The x-coordinate of the rectangle on the display.
+ * @param y The y-coordinate of the rectangle on the display.
+ * @param w The width of the rectangle, within the zoomed image.
+ * @param h The height of the rectangle, within the zoomed image.
+ * @return True if the rectangle was drawn, false if its pixel data could not be read.
+ */
+bool Bmp::draw_view(File& bmpFile, const BMPHeader& header, uint8_t shift, uint16_t vx,
+                    uint16_t vy, uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+    uint8_t* buffer;
+    uint16_t buffsize;
+    Buffers& sdbuffer = map_buffers(bmpFile, header, true, buffer, buffsize);
+    uint8_t half = (1 << shift) >> 1; // Offset of the sample in its block
+    bool flip = header.height > 0;
+    uint32_t height = flip ? header.height : -header.height;
+
+    // The bytes in view are read in equal chunks, so no read goes past them
+    uint32_t rowSize = row_size(header);
+    uint8_t bytes = header.depth >= 8 ? header.depth >> 3 : 1; // bytes read per pixel
+    uint32_t first_col = ((uint32_t) vx << shift) + half;
+    uint32_t start = first_col * header.depth >> 3;
+    uint32_t last_col = first_col + ((uint32_t) (w - 1) << shift);
+    uint32_t span = (last_col * header.depth >> 3) + bytes - start;
+    uint16_t chunks = (span + buffsize - 1) / buffsize;
+    buffsize = (span + chunks - 1) / chunks;
+    StreamReader reader(bmpFile, buffer, buffsize);
+    uint8_t px[3];
+
+    ILI9341_SetWindow(x, y, x + w - 1, y + h - 1);
+    ILI9341_TransmitCmmd(ILI9341_RAMWR);
+    for (uint16_t row = vy; row < vy + h; row++)
+    {
+        uint32_t line = ((uint32_t) row << shift) + half;
+        if (flip)
+            line = height - 1 - line;
+        reader.seek(header.data_offset + line * rowSize + start);
+        uint32_t offset = start;      // Position of the reader in the row
+        uint32_t loaded = 0xFFFFFFFF; // Position of the pixel data in px
+
+        for (uint16_t col = 0; col < w; col++)
+        {
+            uint32_t sx = first_col + ((uint32_t) col << shift);
+            read_pixel(reader, header, sx, offset, loaded, px);
+            ILI9341_Transmit16bitData(pixel_to_565(header, sdbuffer.pal.lut, px, vx + col, row));
+        }
+    }
+    return !reader.failed();
+}
+
+/**
+ * @brief Works out the size of an image scaled to fit an area.
+ *
+ * @details The aspect ratio is kept. An image larger than the area is shrunk until it touches two
+ * opposite edges. A smaller one is enlarged by the largest whole factor that fits, so every source
+ * pixel becomes a block of the same size. RLE images are not enlarged, since a decoded row cannot
+ * be drawn a second time without decoding it again.
+ *
+ * @param header The parsed BMP header, with a positive height.
+ * @param area_w The width of the area.
+ * @param area_h The height of the area.
+ * @param w The width of the scaled image.
+ * @param h The height of the scaled image.
+ */
+void Bmp::fit(const BMPHeader& header, int area_w, int area_h, int& w, int& h)
+{
+    uint32_t width = header.width;
+    uint32_t height = header.height;
+    if (width == 0 || height == 0)
+    {
+        w = h = 0;
+        return;
+    }
+
+    if (width <= (uint32_t) area_w && height <= (uint32_t) area_h)
+    {
+        uint16_t k = area_w / width < area_h / height ? area_w / width : area_h / height;
+        if (header.compression == BI_RLE8 || header.compression == BI_RLE4)
+            k = 1;
+        w = width * k;
+        h = height * k;
+    }
+    else if (width * area_h >= height * area_w)
+    {
+        w = area_w;
+        h = height * area_w / width;
+    }
+    else
+    {
+        h = area_h;
+        w = width * area_h / height;
+    }
+    if (w == 0)
+        w = 1;
+    if (h == 0)
+        h = 1;
+}
+
+/**
+ * @brief Draws a scaled uncompressed BMP image by nearest neighbour sampling.
+ *
+ * @details Every display pixel shows the source pixel under its centre. Source rows that no display
+ * row samples are never read, and within a row the reader skips ahead to the next sampled pixel.
+ * When the samples are further apart than the read buffer, only the sampled pixels are read. When
+ * enlarging, a display row that samples the same source row as the one before it is drawn again
+ * from the read buffer, and a source pixel is read and converted once for all of its copies.
+ *
+ * The display window has to be open on the w x h image area.
+ *
+ * @param bmpFile The File object representing the BMP file.
+ * @param header The parsed BMP header of the file, with a positive height.
+ * @param lut The colour table as RGB565, for palettized images.
+ * @param buffer The read buffer.
+ * @param buffsize The size of the read buffer.
+ * @param flip The image is stored bottom-to-top.
+ * @param w The width of the image on the display.
+ * @param h The height of the image on the display.
+ * @return True if every sampled pixel was read, false otherwise.
+ */
+bool Bmp::draw_nearest(File& bmpFile, const BMPHeader& header, const uint16_t* lut,
+                       uint8_t* buffer, uint16_t buffsize, bool flip, int w, int h)
+{
+    uint32_t rowSize = row_size(header);
+    uint8_t bytes = header.depth >= 8 ? header.depth >> 3 : 1; // bytes read per pixel
+    uint8_t px[3];
+    uint16_t color = 0;
+    Sampler rows, cols;
+
+    // Samples that never share a buffer are read one at a time, others a row at most
+    if (((uint32_t) header.width / w * header.depth >> 3) >= buffsize)
+        buffsize = bytes;
+    else if (rowSize < buffsize)
+        buffsize = rowSize;
+    StreamReader reader(bmpFile, buffer, buffsize);
+
+    rows.init(header.height, h, true, 0);
+    for (int row = 0; row < h; row++, rows.next())
+    {
+        uint32_t line = flip ? header.height - 1 - rows.pos : rows.pos;
+        reader.seek(header.data_offset + line * rowSize);
+        uint32_t offset = 0;          // Position of the reader in the row
+        uint32_t loaded = 0xFFFFFFFF; // Position of the pixel data in px
+
+        cols.init(header.width, w, true, 0);
+        for (int col = 0; col < w; col++, cols.next())
+        {
+            bool fresh = read_pixel(reader, header, cols.pos, offset, loaded, px);
+#if defined(BMP_DITHER)
+            // the dither differs from one display pixel to the next
+            fresh = fresh || header.depth == 24;
+#endif
+            if (fresh)
+                color = pixel_to_565(header, lut, px, col, row);
+            ILI9341_Transmit16bitData(color);
+        }
+        Slide::reveal(row + 1);
+    }
+    return !reader.failed();
+}
+
+#if defined(BMP_INTERLACE)
+/**
+ * @brief Draws an uncompressed BMP image in four interlaced passes.
+ *
+ * @details The first pass draws every 8th display row stretched 8 rows tall, the second the rows
+ * halfway between them 4 rows tall, the third the remaining even rows 2 rows tall and the last the
+ * odd rows. A coarse picture is on the screen after an eighth of the rows has been read, and the
+ * later passes only sharpen it. Every row is still read once, after a seek to its position. On a
+ * contiguous file the seek is free, otherwise it follows the cluster chain through the FAT cache.
+ *
+ * A row is converted into a line of display pixels at the start of `buffer`. Then a window over
+ * the row and the rows it stands for is opened and the line is pushed once per row. An unscaled or
+ * cropped row is read in one piece and converted in place. A shrunk row is sampled like in
+ * draw_nearest(), through a reader that uses the rest of the buffer or, for palettized images,
+ * a few bytes of its own. A palettized line holds palette indices that are looked up as it is
+ * pushed, so the buffer has to hold a whole row of indices. The final image is the same as with
+ * the progressive paths.
+ *
+ * @param bmpFile The File object representing the BMP file.
+ * @param header The parsed BMP header of the file, with a positive height.
+ * @param lut The colour table as RGB565, for palettized images.
+ * @param buffer The line and read buffer.
+ * @param buffsize The size of the buffer.
+ * @param flip The image is stored bottom-to-top.
+ * @param x The x-coordinate of the top-left corner of the image on the display.
+ * @param y The y-coordinate of the top-left corner of the image on the display.
+ * @param w The width of the image on the display.
+ * @param h The height of the image on the display.
+ * @param shrink The image is shrunk to w x h rather than drawn at its own size.
+ * @return True if every row was read, false otherwise.
+ */
+bool Bmp::draw_interlaced(File& bmpFile, const BMPHeader& header, const uint16_t* lut,
+                          uint8_t* buffer, uint16_t buffsize, bool flip, uint16_t x, uint16_t y,
+                          int w, int h, bool shrink)
+{
+    uint32_t rowSize = row_size(header);
+    bool palettized = header.depth <= 8;
+    uint8_t bytes = palettized ? 1 : header.depth >> 3; // bytes read per pixel
+    uint8_t px[3];
+    uint8_t small[8]; // read buffer of shrunk palettized rows
+    uint16_t color;
+    Sampler rows, cols;
+    bool drawn = true; // every unshrunk row was read whole
+
+    // Shrunk rows are read behind the line, one sample at a time if no two share a buffer
+    uint8_t* chunk = small;
+    uint16_t chunksize = sizeof(small);
+    if (!palettized)
+    {
+        chunk = buffer + 2 * w;
+        chunksize = buffsize - 2 * w;
+        if (((uint32_t) header.width / w * header.depth >> 3) >= chunksize)
+            chunksize = bytes;
+        else if (rowSize < chunksize)
+            chunksize = rowSize;
+    }
+    StreamReader reader(bmpFile, chunk, chunksize);
+
+    for (uint8_t pass = 0; pass < 4; pass++)
+    {
+        uint8_t size = 8 >> pass; // Display rows covered by a row of this pass
+        int step = pass ? size << 1 : 8;
+        for (int row = pass ? size : 0; row < h; row += step)
+        {
+            uint32_t line = row;
+            if (shrink)
+            {
+                rows.init(header.height, h, true, row);
+                line = rows.pos;
+            }
+            if (flip)
+                line = header.height - 1 - line;
+            uint32_t start = header.data_offset + line * rowSize;
+
+            if (!shrink)
+            {
+                int16_t bytes_in_row = ((uint32_t) w * header.depth + 7) >> 3;
+                bmpFile.seek(start);
+                if (bmpFile.read(buffer, bytes_in_row) != bytes_in_row)
+                    drawn = false;
+                if (header.depth == 24)
+                {
+#if defined(BMP_DITHER)
+                    Dither::bgr_to_565(buffer, w, 0, row);
+#else
+                    // In place, a pixel is read before its RGB565 bytes overwrite it
+                    for (int i = 0; i < w; i++)
+                    {
+                        color = bgr_to_565(buffer + 3 * i, i, row);
+                        buffer[2 * i] = color >> 8;
+                        buffer[2 * i + 1] = color;
+                    }
+#endif
+                }
+                else if (header.depth == 16 && header.rgb555)
+                {
+                    // Shift red and green up, the pixels stay little-endian
+                    for (int i = 0; i < 2 * w; i += 2)
+                    {
+                        color = pixel_to_565(header, lut, buffer + i, i >> 1, row);
+                        buffer[i] = color;
+                        buffer[i + 1] = color >> 8;
+                    }
+                }
+                else if (header.depth == 4)
+                {
+                    // Spread the nibbles from the end, so none is overwritten before it is read
+                    for (int i = w - 1; i >= 0; i--)
+                        buffer[i] = i & 1 ? buffer[i >> 1] & 0x0F : buffer[i >> 1] >> 4;
+                }
+            }
+            else
+            {
+                reader.seek(start);
+                uint32_t offset = 0;          // Position of the reader in the row
+                uint32_t loaded = 0xFFFFFFFF; // Position of the pixel data in px
+
+                cols.init(header.width, w, true, 0);
+                for (int col = 0; col < w; col++, cols.next())
+                {
+                    read_pixel(reader, header, cols.pos, offset, loaded, px);
+                    if (palettized)
+                    {
+                        buffer[col] = px[0];
+                        continue;
+                    }
+                    color = pixel_to_565(header, lut, px, col, row);
+                    buffer[2 * col] = color >> 8;
+                    buffer[2 * col + 1] = color;
+                }
+            }
+
+            // Fill the row and the rows it stands for until a later pass draws them
+            int n = h - row < size ? h - row : size;
+            ILI9341_SetWindow(x, y + row, x + w - 1, y + row + n - 1);
+            ILI9341_TransmitCmmd(ILI9341_RAMWR);
+            for (; n > 0; n--)
+            {
+                if (palettized)
+                {
+                    for (int i = 0; i < w; i++)
+                        ILI9341_Transmit16bitData(lut[buffer[i]]);
+                }
+                else if (header.depth == 16 && !shrink)
+                {
+                    ILI9341_PushPixels565LE(buffer, w);
+                }
+                else
+                {
+                    ILI9341_PushPixels565BE(buffer, w);
+                }
+            }
+        }
+    }
+    return drawn && !reader.failed();
+}
+#endif
+
+#if defined(BMP_BOX_FILTER)
+/**
+ * @brief Draws a shrunk 24 bpp or 16 bpp BMP image with a box filter.
+ *
+ * @details Every display pixel shows the average of the block of source pixels it covers, so
+ * every source pixel is read. The pixels of a source row are summed per display column and folded
+ * into a running average per display column, kept as one byte per channel in `acc`. A display row
+ * is drawn once the last source row of its blocks has been folded in, dithered with BMP_DITHER.
+ * Divisions are replaced by multiplications with 16-bit reciprocals.
+ *
+ * The display window has to be open on the w x h image area.
+ *
+ * @param bmpFile The File object representing the BMP file.
+ * @param header The parsed BMP header of the file, with a positive height.
+ * @param acc The running averages, 3 bytes per display column.
+ * @param buffer The read buffer.
+ * @param buffsize The size of the read buffer.
+ * @param flip The image is stored bottom-to-top.
+ * @param w The width of the image on the display.
+ * @param h The height of the image on the display.
+ * @return True if every pixel was read, false otherwise.
+ */
+bool Bmp::draw_box(File& bmpFile, const BMPHeader& header, uint8_t* acc, uint8_t* buffer,
+                   uint16_t buffsize, bool flip, int w, int h)
+{
+    uint32_t rowSize = row_size(header);
+    StreamReader reader(bmpFile, buffer, buffsize);
+    Sampler rows, cols;
+
+    // Blocks are step or step + 1 source columns wide
+    uint32_t step = header.width / w;
+    uint32_t recip[2] = {(uint32_t) 65536 / step, (uint32_t) 65536 / (step + 1)};
+
+    rows.init(header.height, h, false, 0);
+    for (int row = 0; row < h; row++)
+    {
+        uint32_t first = rows.pos;
+        rows.next();
+        for (uint32_t line = first; line < rows.pos; line++)
+        {
+            reader.seek(header.data_offset + (flip ? header.height - 1 - line : line) * rowSize);
+            int32_t weight = 65536L / (line - first + 1);
+            uint8_t* a = acc;
+
+            cols.init(header.width, w, false, 0);
+            for (int col = 0; col < w; col++, a += 3)
+            {
+                uint32_t start = cols.pos;
+                cols.next();
+                uint16_t n = cols.pos - start;
+                uint32_t sum[3] = {0, 0, 0}; // B, G, R
+                for (uint16_t i = 0; i < n; i++)
+                {
+                    if (header.depth == 24)
+                    {
+                        sum[0] += (uint8_t) reader.read();
+                        sum[1] += (uint8_t) reader.read();
+                        sum[2] += (uint8_t) reader.read();
+                    }
+                    else
+                    {
+                        uint16_t v = (uint8_t) reader.read();
+                        v |= reader.read() << 8;
+                        sum[0] += (v & 0x1F) << 3;
+                        if (header.rgb555)
+                        {
+                            sum[1] += (v >> 2) & 0xF8;
+                            sum[2] += (v >> 7) & 0xF8;
+                        }
+                        else
+                        {
+                            sum[1] += (v >> 3) & 0xFC;
+                            sum[2] += (v >> 8) & 0xF8;
+                        }
+                    }
+                }
+                for (uint8_t c = 0; c < 3; c++)
+                {
+                    int16_t v = (sum[c] * recip[n - step] + 0x8000) >> 16;
+                    a[c] += ((int32_t) (v - a[c]) * weight + 0x8000) >> 16;
+                }
+            }
+        }
+
+        uint8_t* a = acc;
+        for (int col = 0; col < w; col++, a += 3)
+        {
+            ILI9341_Transmit16bitData(bgr_to_565(a, col, row));
+        }
+        Slide::reveal(row + 1);
+    }
+    return !reader.failed();
+}
+#endif
+
+/**
+ * @brief Positions the display write pointer on a pixel of a decoded RLE row.
+ *
+ * @details The window spans to the right edge of the image, so the rest of the row can be streamed
+ * without another window.
+ *
+ * @param x The x-coordinate of the image on the display.
+ * @param y The y-coordinate of the image on the display.
+ * @param w The width of the image area on the display.
+ * @param row The display row.
+ * @param col The display column.
+ */
+static void rle_open_window(uint16_t x, uint16_t y, int w, int32_t row, int32_t col)
+{
+    ILI9341_SetWindow(x + col, y + row, x + w - 1, y + row);
+    ILI9341_TransmitCmmd(ILI9341_RAMWR);
+}
+
+/**
+ * @brief Finds the display row that shows a decoded RLE row.
+ *
+ * @details Source rows are decoded from the bottom up, so the row sampler only moves up.
+ *
+ * @param rows The row sampler, on display row `out`.
+ * @param out The lowest display row whose source row is not below `row`, -1 if there is none.
+ * @param row The source row.
+ * @return True if display row `out` shows source row `row`, false otherwise.
+ */
+static bool rle_find_row(Sampler& rows, int& out, int32_t row)
+{
+    while (out >= 0 && (int32_t) rows.pos > row)
+    {
+        if (--out >= 0)
+            rows.prev();
+    }
+    return out >= 0 && (int32_t) rows.pos == row;
+}
+
+/**
+ * @brief Moves the column sampler of a decoded RLE row up to a source column.
+ *
+ * @details Display pixels passed over this way have not been written, so the write pointer is no
+ * longer on the next display pixel.
+ *
+ * @param cols The column sampler, on display column `out`.
+ * @param out The next display column to write.
+ * @param w The width of the image area on the display.
+ * @param col The source column.
+ * @param window Cleared if display pixels were passed over.
+ */
+static void rle_skip_to(Sampler& cols, int& out, int w, int32_t col, bool& window)
+{
+    while (out < w && (int32_t) cols.pos < col)
+    {
+        out++;
+        cols.next();
+        window = false;
+    }
+}
+
+/**
+ * @brief Decodes RLE8 or RLE4 pixel data straight to the display.
+ *
+ * @details The compressed stream is read once, sequentially, from the bottom row up. Pixels are
+ * streamed into a one-row display window that is set again after every end of line or delta
+ * escape, so no row is ever buffered. Encoded runs of 8 bpp images are written with a single
+ * run-fill. With BMP_FIT a larger image is shrunk to w x h by nearest neighbour sampling, otherwise
+ * pixels outside the w x h area are discarded. Decoding stops above the top display row. Pixels
+ * skipped by a delta or an early end of line are left as they are on the display.
+ *
+ * @param bmpFile The File object representing the BMP file.
+ * @param header The parsed BMP header of the file, with a positive height.
+ * @param lut The colour table as RGB565.
+ * @param buffer The read buffer for the compressed data.
+ * @param buffsize The size of the read buffer.
+ * @param x The x-coordinate of the image on the display.
+ * @param y The y-coordinate of the image on the display.
+ * @param w The width of the image area on the display.
+ * @param h The height of the image area on the display.
+ * @return True if the data was decoded up to the end of the bitmap or past the top display row,
+ * false if it ended early or could not be read.
+ */
+bool Bmp::draw_rle(File& bmpFile, const BMPHeader& header, const uint16_t* lut, uint8_t* buffer,
+                   uint16_t buffsize, uint16_t x, uint16_t y, int w, int h)
+{
+    bool rle4 = header.compression == BI_RLE4;
+    int32_t row = header.height - 1; // Image row, the bottom one comes first
+    int32_t col = 0;                 // Image column
+    bool window = false;             // Write pointer is on (out_row, out_col)
+    int16_t count, value;
+    uint8_t pixel = 0;
+
+    // Source area drawn to the w x h display area
+#if defined(BMP_FIT)
+    uint32_t src_w = header.width;
+    uint32_t src_h = header.height;
+#else
+    uint32_t src_w = w;
+    uint32_t src_h = h;
+#endif
+    Sampler rows, cols;
+    int out_row = h - 1;
+    int out_col = 0;
+    rows.init(src_h, h, true, h - 1);
+    cols.init(src_w, w, true, 0);
+    bool sampled = rle_find_row(rows, out_row, row);
+
+    bmpFile.seek(header.data_offset);
+    StreamReader reader(bmpFile, buffer, buffsize);
+
+    while (out_row >= 0)
+    {
+        count = reader.read();
+        value = reader.read();
+        if (value < 0)
+            break;
+
+        if (count > 0)
+        { // Encoded run of count pixels
+            if (sampled)
+            {
+                rle_skip_to(cols, out_col, w, col, window);
+                if (!window && out_col < w && (int32_t) cols.pos < col + count)
+                {
+                    rle_open_window(x, y, w, out_row, out_col);
+                    window = true;
+                }
+                int n = 0;
+                for (; out_col < w && (int32_t) cols.pos < col + count; out_col++, cols.next())
+                {
+                    if (!rle4)
+                        n++;
+                    else // Two colours alternate, high nibble first
+                        ILI9341_PushColor565(lut[(cols.pos - col) & 1 ? value & 0x0F : value >> 4],
+                                             1);
+                }
+                if (n)
+                    ILI9341_PushColor565(lut[value], n);
+            }
+            col += count;
+        }
+        else if (value == 0)
+        { // End of line
+            row--;
+            col = 0;
+            window = false;
+            out_col = 0;
+            cols.init(src_w, w, true, 0);
+            sampled = rle_find_row(rows, out_row, row);
+        }
+        else if (value == 1)
+        { // End of bitmap
+            break;
+        }
+        else if (value == 2)
+        { // Delta - move right and up
+            col += reader.read();
+            int16_t up = reader.read();
+            if (up)
+            {
+                row -= up;
+                window = false;
+                sampled = rle_find_row(rows, out_row, row);
+            }
+            // the column sampler is never past the new column
+        }
+        else
+        { // Absolute mode - value literal pixels, padded to 16 bits
+            for (int i = 0; i < value; i++)
+            {
+                uint8_t index;
+                if (!rle4)
+                {
+                    index = reader.read();
+                }
+                else
+                {
+                    if (!(i & 1))
+                        pixel = reader.read();
+                    index = i & 1 ? pixel & 0x0F : pixel >> 4;
+                }
+                if (sampled)
+                {
+                    rle_skip_to(cols, out_col, w, col, window);
+                    for (; out_col < w && (int32_t) cols.pos == col; out_col++, cols.next())
+                    {
+                        if (!window)
+                        {
+                            rle_open_window(x, y, w, out_row, out_col);
+                            window = true;
+                        }
+                        ILI9341_PushColor565(lut[index], 1);
+                    }
+                }
+                col++;
+            }
+            if ((rle4 ? (value + 1) >> 1 : value) & 1)
+                reader.read();
+        }
+    }
+    return !reader.failed();
+}
@@ -0,0 +1,110 @@
+/**
+ * @file Dither.cpp
+ * @brief Ordered dithering of 24-bit colours to RGB565.
+ *
+ * This file contains the lookup tables and the conversion functions of the Dither class.
+ */
+#include <Dither.h>
+#include <avr/pgmspace.h>
+
+// Threshold 0 to 15 of the 4x4 Bayer matrix at x = i & 3, y = i >> 2
+#define BAYER(i)                                                                                   \
+    ((((i) ^ ((i) >> 2)) & 1) << 3 | ((i) & 4) | (((i) ^ ((i) >> 2)) & 2) | ((i) & 8) >> 3)
+
+// Table entries, i is a channel value plus its bias
+#define CLAMP(i) ((i) > 255 ? 255 : (i))
+#define R_HI(i) (CLAMP(i) & 0xF8)         // red, high byte bits 7-3
+#define G_HI(i) (CLAMP(i) >> 5)           // green, high byte bits 2-0
+#define G_LO(i) ((CLAMP(i) << 3) & 0xE0)  // green, low byte bits 7-5
+#define B_LO(i) (CLAMP(i) >> 3)           // blue, low byte bits 4-0
+#define BIAS5(i) (BAYER(i) >> 1)          // below one 5-bit step of 8
+#define BIAS6(i) (BAYER(i) >> 2)          // below one 6-bit step of 4
+
+#define REPEAT4(f, i) f(i), f(i + 1), f(i + 2), f(i + 3)
+#define REPEAT16(f, i) REPEAT4(f, i), REPEAT4(f, i + 4), REPEAT4(f, i + 8), REPEAT4(f, i + 12)
+#define REPEAT64(f, i) REPEAT16(f, i), REPEAT16(f, i + 16), REPEAT16(f, i + 32), REPEAT16(f, i + 48)
+#define REPEAT256(f, i)                                                                            \
+    REPEAT64(f, i), REPEAT64(f, i + 64), REPEAT64(f, i + 128), REPEAT64(f, i + 192)
+#define TABLE(f) {REPEAT256(f, 0), REPEAT4(f, 256), REPEAT4(f, 260)}
+
+static const uint8_t DITHER_R_HI[264] PROGMEM = TABLE(R_HI);
+static const uint8_t DITHER_G_HI[264] PROGMEM = TABLE(G_HI);
+static const uint8_t DITHER_G_LO[264] PROGMEM = TABLE(G_LO);
+static const uint8_t DITHER_B_LO[264] PROGMEM = TABLE(B_LO);
+static const uint8_t DITHER_BIAS5[16] PROGMEM = {REPEAT16(BIAS5, 0)};
+static const uint8_t DITHER_BIAS6[16] PROGMEM = {REPEAT16(BIAS6, 0)};
+
+/**
+ * @brief Converts one pixel with the given biases.
+ *
+ * @param src The B, G, R bytes of the pixel.
+ * @param dst The big-endian RGB565 bytes, may overlap the first two bytes of `src`.
+ * @param bias5 The bias of the red and blue channels.
+ * @param bias6 The bias of the green channel.
+ */
+static inline void dither_pixel(const uint8_t* src, uint8_t* dst, uint8_t bias5, uint8_t bias6)
+{
+    uint16_t b = src[0] + bias5;
+    uint16_t g = src[1] + bias6;
+    uint16_t r = src[2] + bias5;
+    dst[0] = pgm_read_byte(&DITHER_R_HI[r]) | pgm_read_byte(&DITHER_G_HI[g]);
+    dst[1] = pgm_read_byte(&DITHER_G_LO[g]) | pgm_read_byte(&DITHER_B_LO[b]);
+}
+
+/**
+ * @brief Converts a run of BMP pixels in place.
+ *
+ * @details The biases of the four columns of the row are loaded once, and the run is converted
+ * four pixels at a time so that every bias stays in a register.
+ *
+ * @param data The B, G, R bytes of the pixels, replaced by their big-endian RGB565 values.
+ * @param count The number of pixels.
+ * @param x The column of the first pixel.
+ * @param y The row of the pixels.
+ */
+void Dither::bgr_to_565(uint8_t* data, uint16_t count, uint16_t x, uint16_t y)
+{
+    const uint8_t* row5 = DITHER_BIAS5 + ((y & 3) << 2);
+    const uint8_t* row6 = DITHER_BIAS6 + ((y & 3) << 2);
+    const uint8_t* src = data;
+    uint8_t* dst = data;
+
+    // Single pixels up to the first column of the matrix
+    for (; count && (x & 3); count--, x++, src += 3, dst += 2)
+        dither_pixel(src, dst, pgm_read_byte(row5 + (x & 3)), pgm_read_byte(row6 + (x & 3)));
+
+    uint8_t b5[4], b6[4];
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        b5[i] = pgm_read_byte(row5 + i);
+        b6[i] = pgm_read_byte(row6 + i);
+    }
+    for (; count >= 4; count -= 4, src += 12, dst += 8)
+    {
+        dither_pixel(src, dst, b5[0], b6[0]);
+        dither_pixel(src + 3, dst + 2, b5[1], b6[1]);
+        dither_pixel(src + 6, dst + 4, b5[2], b6[2]);
+        dither_pixel(src + 9, dst + 6, b5[3], b6[3]);
+    }
+    for (uint8_t i = 0; i < count; i++, src += 3, dst += 2)
+        dither_pixel(src, dst, b5[i], b6[i]);
+}
+
+/**
+ * @brief Converts a single colour.
+ *
+ * @param r The red channel.
+ * @param g The green channel.
+ * @param b The blue channel.
+ * @param x The column of the pixel.
+ * @param y The row of the pixel.
+ * @return The RGB565 colour.
+ */
+uint16_t Dither::rgb_to_565(uint8_t r, uint8_t g, uint8_t b, uint16_t x, uint16_t y)
+{
+    uint8_t i = (y & 3) << 2 | (x & 3);
+    uint8_t src[3] = {b, g, r};
+    uint8_t dst[2];
+    dither_pixel(src, dst, pgm_read_byte(DITHER_BIAS5 + i), pgm_read_byte(DITHER_BIAS6 + i));
+    return dst[0] << 8 | dst[1];
+}
@@ -0,0 +1,547 @@
+/**
+ * @file Gif.cpp
+ * @brief Animated GIF player.
+ *
+ * This file contains the implementation of the Gif class, which decodes GIF frames from the SD
+ * card straight to the display and paces them with Millis.
+ */
+#include <Gif.h>
+#include <Millis.h>
+#include <config.h>
+extern "C"
+{
+#include <ili9341.h>
+}
+
+/**
+ * @brief Constructs a player that is not playing.
+ */
+Gif::Gif()
+    : file(NULL), x(0), y(0), width(0), height(0), first_frame(0), next_frame(0), palette_pos(0),
+      palette_colors(0), frame_count(0), due_time(0), disposal(0)
+{
+}
+
+/**
+ * @brief Checks for the GIF signature.
+ *
+ * @details The file must be positioned at its start.
+ *
+ * @param file The file to check.
+ * @return True if the file starts like a GIF file, false otherwise.
+ */
+bool Gif::is_gif(File& file)
+{
+    return file.read() == 'G' && file.read() == 'I' && file.read() == 'F' && file.read() == '8';
+}
+
+/**
+ * @brief Gets the number of LZW codes the decoder can hold for a frame.
+ *
+ * @details The RGB565 colour table takes 2 bytes per colour of the pool, and every dictionary
+ * entry 17 bits: an 8-bit suffix and a 9-bit prefix code. Codes never reach 512, so the code size
+ * stays at 9 bits or below.
+ *
+ * @param colors The size of the colour table of the frame.
+ * @param min_code_size The LZW minimum code size of the frame.
+ * @return The first code that does not fit.
+ */
+uint16_t Gif::max_codes(uint16_t colors, uint8_t min_code_size)
+{
+    uint16_t first_free = (1 << min_code_size) + 2;
+    uint16_t entries = ((uint32_t) (POOL_SIZE - 2 * colors) * 8 - 7) / 17;
+    if (first_free + entries > 512)
+    {
+        entries = 512 - first_free;
+    }
+    return first_free + entries;
+}
+
+/**
+ * @brief Starts playing a GIF file.
+ *
+ * @details The logical screen descriptor is read and the file is positioned on the first frame.
+ * The canvas is cropped to the 240x300 image area if it is larger and centered if it is smaller.
+ * The file stays open until stop() is called, which has to happen before the File object is
+ * reused. The first frame is due at once.
+ *
+ * @param file The GIF file, positioned at its start.
+ * @param x The x-coordinate of the top-left corner of the image area on the display.
+ * @param y The y-coordinate of the top-left corner of the image area on the display.
+ * @return True if the file is a GIF file, false otherwise.
+ */
+bool Gif::start(File& file, uint8_t x, uint8_t y)
+{
+    if (!is_gif(file))
+    {
+        return false;
+    }
+
+    // Version "7a" or "9a", then the logical screen descriptor
+    file.seek(6);
+    width = File::read16(file);
+    height = File::read16(file);
+    uint8_t packed = file.read();
+    file.read(); // background colour
+    file.read(); // pixel aspect ratio
+
+    palette_pos = 0;
+    palette_colors = 0;
+    if (packed & 0x80)
+    {
+        palette_pos = 13;
+        palette_colors = 2 << (packed & 0x07);
+    }
+    first_frame = 13 + 3 * palette_colors;
+
+    if (width > TFT_WIDTH)
+        width = TFT_WIDTH;
+    if (height > TFT_HEIGHT - 20)
+        height = TFT_HEIGHT - 20;
+    this->x = x + (TFT_WIDTH - width) / 2;
+    this->y = y + (TFT_HEIGHT - 20 - height) / 2;
+
+    this->file = &file;
+    next_frame = first_frame;
+    frame_count = 0;
+    disposal = 0;
+    due_time = Millis::get();
+    return true;
+}
+
+/**
+ * @brief Stops playing and closes the GIF file.
+ */
+void Gif::stop()
+{
+    if (file != NULL)
+    {
+        file->close();
+        file = NULL;
+    }
+}
+
+/**
+ * @brief Checks if the next frame should be drawn.
+ *
+ * @return True if an animation is playing and its next frame is due, false otherwise.
+ */
+bool Gif::frame_due()
+{
+    return file != NULL && (int32_t) (Millis::get() - due_time) >= 0;
+}
+
+/**
+ * @brief Draws the next frame of the animation.
+ *
+ * @details Extension blocks are read up to the next image, whose graphic control extension gives
+ * its delay, transparent colour and disposal method. The area of the previous frame is cleared
+ * first if its disposal method asked for it. At the end of the file playback loops to the first
+ * frame. An animation with a single frame is stopped after it has been drawn once.
+ *
+ * The next frame is due a frame delay after this one was due, so decoding time does not add up.
+ * If drawing fell a whole delay behind, the pace is restarted from now.
+ *
+ * @return True if a frame was drawn, false if playback stopped.
+ */
+bool Gif::draw_frame()
+{
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    uint8_t buffer[32];
+    StreamReader reader(*file, buffer, sizeof(buffer));
+    Frame frame;
+    uint16_t delay = 0;
+    uint8_t frame_disposal = 0;
+    frame.transparent = -1;
+
+    reader.seek(next_frame);
+    dispose();
+
+    while (true)
+    {
+        int16_t block = reader.read();
+        if (block == 0x21)
+        { // Extension
+            if (reader.read() == 0xF9)
+            { // Graphic control extension
+                uint8_t size = reader.read();
+                uint8_t packed = reader.read();
+                delay = reader.read();
+                delay |= reader.read() << 8;
+                uint8_t transparent = reader.read();
+                reader.skip(size - 4);
+                frame_disposal = (packed >> 2) & 0x07;
+                frame.transparent = packed & 0x01 ? transparent : -1;
+            }
+            skip_sub_blocks(reader);
+        }
+        else if (block == 0x2C)
+        { // Image descriptor
+            frame.left = reader.read();
+            frame.left |= reader.read() << 8;
+            frame.top = reader.read();
+            frame.top |= reader.read() << 8;
+            frame.width = reader.read();
+            frame.width |= reader.read() << 8;
+            frame.height = reader.read();
+            frame.height |= reader.read() << 8;
+            uint8_t packed = reader.read();
+            frame.interlaced = packed & 0x40;
+
+            uint16_t colors = palette_colors;
+            frame.local_palette = packed & 0x80;
+            if (frame.local_palette)
+            {
+                colors = 2 << (packed & 0x07);
+            }
+            if (colors == 0)
+            {
+                // No colour table to draw with, skip the LZW minimum code size and the data
+                reader.read();
+                skip_sub_blocks(reader);
+                DEBUG("GIF frame without colour table\n");
+            }
+            else if (!decode_image(reader, frame, colors))
+            {
+                DEBUG("GIF frame not fully decoded\n");
+            }
+            next_frame = reader.position();
+            frame_count++;
+            break;
+        }
+        else if (block == 0x3B && frame_count > 1)
+        { // Trailer, loop the animation
+            reader.seek(first_frame);
+            frame_count = 0;
+        }
+        else
+        { // Trailer of a still image, end of file or corrupt data
+            stop();
+            return false;
+        }
+    }
+
+    // Remember where the frame was for its disposal
+    disposal = frame_disposal;
+    dispose_rect[0] = x + frame.left;
+    dispose_rect[1] = y + frame.top;
+    dispose_rect[2] = x + frame.left + frame.width - 1;
+    dispose_rect[3] = y + frame.top + frame.height - 1;
+
+    // Delays below 20 ms are not meant literally, browsers slow them down as well
+    uint16_t delay_ms = delay < 2 ? DEFAULT_DELAY_MS : delay * 10;
+    due_time += delay_ms;
+    if ((int32_t) (Millis::get() - due_time) >= (int32_t) delay_ms)
+    {
+        due_time = Millis::get();
+    }
+    return true;
+}
+
+/**
+ * @brief Clears the area of the last frame if its disposal method is "restore to background".
+ *
+ * @details The background is drawn black, like the screen around the image. "Restore to previous"
+ * would need a copy of the display and is treated like "leave in place".
+ */
+void Gif::dispose()
+{
+    if (disposal != 2)
+    {
+        return;
+    }
+    uint16_t x1 = dispose_rect[2] < x + width ? dispose_rect[2] : x + width - 1;
+    uint16_t y1 = dispose_rect[3] < y + height ? dispose_rect[3] : y + height - 1;
+    if (dispose_rect[0] <= x1 && dispose_rect[1] <= y1)
+    {
+        ILI9341_FillWindow(dispose_rect[0], dispose_rect[1], x1, y1, ILI9341_BLACK);
+    }
+    disposal = 0;
+}
+
+/**
+ * @brief Skips data sub-blocks up to and including the block terminator.
+ *
+ * @param reader The reader positioned on the size of a sub-block.
+ */
+void Gif::skip_sub_blocks(StreamReader& reader)
+{
+    int16_t size;
+    while ((size = reader.read()) > 0)
+    {
+        reader.skip(size);
+    }
+}
+
+/**
+ * @brief Decodes the LZW image data of a frame and writes its pixels to the display.
+ *
+ * @details Pixels are written row by row into display windows. A window spanning the whole frame
+ * width is kept open over consecutive full rows; transparent pixels and pixels outside the canvas
+ * end the window, and the next visible pixel opens a new one for the rest of its row.
+ *
+ * Strings are written in order using a small stack: a dictionary string is walked backwards from
+ * its last character, so it is emitted in chunks of up to sizeof(stack) characters, each found by
+ * walking the prefix chain again. Most strings fit a single chunk.
+ *
+ * The POOL_SIZE byte pool for the colour table and the dictionary and the STACK_SIZE byte string
+ * stack fill the Workspace. Only the 32 byte read buffer of draw_frame() is on the stack.
+ *
+ * @param reader The reader positioned after the image descriptor.
+ * @param frame The image descriptor of the frame.
+ * @param colors The size of the colour table of the frame.
+ * @return True if the image data was decoded, false if it is corrupt or does not fit the
+ * dictionary. Either way the reader is left after the block terminator of the image data.
+ */
+bool Gif::decode_image(StreamReader& reader, const Frame& frame, uint16_t colors)
+{
+    struct Buffers
+    {
+        uint16_t pool16[POOL_SIZE / 2];
+        uint8_t stack[STACK_SIZE];
+    };
+    Buffers& buffers = Workspace::get<Buffers>();
+    uint8_t* pool = (uint8_t*) buffers.pool16;
+    uint16_t* lut = buffers.pool16;
+    uint8_t(&stack)[STACK_SIZE] = buffers.stack;
+
+    // Colour table, a local one follows the descriptor
+    uint32_t data_pos = 0;
+    if (!frame.local_palette)
+    {
+        data_pos = reader.position();
+        reader.seek(palette_pos);
+    }
+    for (uint16_t i = 0; i < colors; i++)
+    {
+        uint8_t r = reader.read();
+        uint8_t g = reader.read();
+        uint8_t b = reader.read();
+        lut[i] = (r & 0xF8) << 8 | (g & 0xFC) << 3 | b >> 3;
+    }
+    if (!frame.local_palette)
+    {
+        reader.seek(data_pos);
+    }
+
+    uint8_t min_code_size = reader.read();
+    if (min_code_size < 2 || min_code_size > 8)
+    {
+        skip_sub_blocks(reader);
+        return false;
+    }
+
+    // Dictionary after the colour table
+    uint16_t clear = 1 << min_code_size;
+    uint16_t first_free = clear + 2;
+    uint16_t cap = max_codes(colors, min_code_size);
+    uint16_t entries = cap - first_free;
+    uint8_t* suffix = pool + 2 * colors;
+    uint8_t* prefix_lo = suffix + entries;
+    uint8_t* prefix_hi = prefix_lo + entries;
+
+    // Sub-block and bit reader state
+    uint8_t block_left = 0;
+    uint32_t bits = 0;
+    uint8_t bit_count = 0;
+    bool terminated = false; // the block terminator has been read
+
+    // LZW state
+    uint8_t code_size = min_code_size + 1;
+    uint16_t next = first_free;
+    int16_t prev = -1;
+    uint8_t first_char = 0;
+
+    // Output state
+    uint16_t col = 0, row = 0; // position in the frame
+    uint8_t pass = 0;          // interlace pass
+    uint8_t window = 0;        // 0 closed, 1 full rows, 2 rest of a row
+    uint32_t pixels = (uint32_t) frame.width * frame.height;
+    bool ok = true;
+
+    while (pixels > 0)
+    {
+        // Read the next code, least significant bit first
+        while (bit_count < code_size)
+        {
+            if (block_left == 0)
+            {
+                int16_t size = reader.read();
+                if (size <= 0)
+                {
+                    terminated = true;
+                    ok = false;
+                    break;
+                }
+                block_left = size;
+            }
+            bits |= (uint32_t) (uint8_t) reader.read() << bit_count;
+            bit_count += 8;
+            block_left--;
+        }
+        if (!ok)
+        {
+            break;
+        }
+        uint16_t code = bits & ((1 << code_size) - 1);
+        bits >>= code_size;
+        bit_count -= code_size;
+
+        if (code == clear)
+        {
+            code_size = min_code_size + 1;
+            next = first_free;
+            prev = -1;
+            continue;
+        }
+        if (code == clear + 1)
+        {
+            break; // End of information
+        }
+
+        // The string to write: the code itself, or for the code not yet in the dictionary the
+        // previous string followed by its own first character
+        uint16_t string = code;
+        bool append_first = false;
+        if (prev < 0 ? code >= clear : code > next)
+        {
+            ok = false;
+            break;
+        }
+        if (prev >= 0 && code == next)
+        {
+            string = prev;
+            append_first = true;
+        }
+        if (string >= cap)
+        {
+            ok = false; // Dictionary grew past what fits in RAM
+            break;
+        }
+
+        // Length of the string
+        uint16_t length = 1;
+        for (uint16_t c = string; c >= first_free; length++)
+        {
+            uint16_t e = c - first_free;
+            c = prefix_lo[e] | ((prefix_hi[e >> 3] >> (e & 7)) & 1) << 8;
+        }
+
+        // Write it in chunks of up to sizeof(stack) characters
+        for (uint16_t start = 0; start < length + append_first; start += sizeof(stack))
+        {
+            uint16_t end = start + sizeof(stack);
+            if (end > length + append_first)
+                end = length + append_first;
+            uint16_t c = string;
+            for (uint16_t pos = length; pos > start; pos--)
+            {
+                uint8_t ch;
+                if (c >= first_free)
+                {
+                    uint16_t e = c - first_free;
+                    ch = suffix[e];
+                    c = prefix_lo[e] | ((prefix_hi[e >> 3] >> (e & 7)) & 1) << 8;
+                }
+                else
+                {
+                    ch = c;
+                }
+                if (pos <= end)
+                    stack[pos - 1 - start] = ch;
+            }
+            if (start == 0)
+                first_char = stack[0];
+            if (append_first && end == length + append_first)
+                stack[end - 1 - start] = first_char;
+
+            for (uint16_t i = 0; i < end - start && pixels > 0; i++, pixels--)
+            {
+                uint8_t index = stack[i];
+                uint16_t cx = frame.left + col, cy = frame.top + row;
+                if ((int16_t) index == frame.transparent || cx >= width || cy >= height)
+                {
+                    window = 0;
+                }
+                else
+                {
+                    if (window == 0)
+                    {
+                        if (col == 0 && !frame.interlaced)
+                        {
+                            uint16_t x1 = frame.left + frame.width;
+                            uint16_t y1 = frame.top + frame.height;
+                            ILI9341_SetWindow(x + cx, y + cy, x + (x1 < width ? x1 : width) - 1,
+                                              y + (y1 < height ? y1 : height) - 1);
+                            window = 1;
+                        }
+                        else
+                        {
+                            uint16_t x1 = frame.left + frame.width;
+                            ILI9341_SetWindow(x + cx, y + cy, x + (x1 < width ? x1 : width) - 1,
+                                              y + cy);
+                            window = 2;
+                        }
+                        ILI9341_TransmitCmmd(ILI9341_RAMWR);
+                    }
+                    ILI9341_Transmit16bitData(lut[index < colors ? index : 0]);
+                }
+
+                // Next pixel, interlaced rows come in passes 0, 8, 16.. 4, 12.. 2, 6.. 1, 3..
+                if (++col == frame.width)
+                {
+                    col = 0;
+                    if (window == 2 || cy + 1 >= height)
+                        window = 0;
+                    if (!frame.interlaced)
+                    {
+                        row++;
+                    }
+                    else
+                    {
+                        window = 0;
+                        row += pass == 0 ? 8 : 16 >> pass;
+                        while (row >= frame.height && pass < 3)
+                        {
+                            pass++;
+                            row = 8 >> pass;
+                        }
+                    }
+                }
+            }
+        }
+
+        // Add the previous string and the first character of this one
+        if (prev >= 0 && next < 4096)
+        {
+            if (next < cap)
+            {
+                uint16_t e = next - first_free;
+                suffix[e] = first_char;
+                prefix_lo[e] = prev;
+                if (prev & 0x100)
+                    prefix_hi[e >> 3] |= 1 << (e & 7);
+                else
+                    prefix_hi[e >> 3] &= ~(1 << (e & 7));
+            }
+            next++;
+            if (next == (1U << code_size) && code_size < 12)
+            {
+                code_size++;
+            }
+        }
+        prev = code;
+    }
+
+    // Data after the end of information or the last pixel, and the terminator, are skipped
+    if (!terminated)
+    {
+        reader.skip(block_left);
+        skip_sub_blocks(reader);
+    }
+    return ok;
+}
@@ -0,0 +1,323 @@
+/**
+ * @file ImageCache.cpp
+ * @brief Images as drawn, cached in files on the card.
+ *
+ * This file contains the implementation of the ImageCache class, which keeps the images shown last
+ * as RGB565 files and draws them from there instead of decoding them again.
+ */
+#include <ImageCache.h>
+#include <Slide.h>
+#include <Workspace.h>
+#include <config.h>
+#include <string.h>
+extern "C"
+{
+#include <ili9341.h>
+}
+
+#if defined(IMAGE_CACHE_KB)
+
+/// Name of the cache directory in the root directory.
+static const char DIR_NAME[] = "IMGCACHE";
+/// Name of the index file in the cache directory.
+static const char INDEX_NAME[] = "INDEX.DAT";
+/// Rows of the image area, the rows of an entry.
+static const uint16_t AREA_ROWS = Slide::AREA_BOTTOM - Slide::AREA_TOP;
+/// Bytes of an entry file.
+static const uint32_t ENTRY_SIZE = (uint32_t) TFT_WIDTH * AREA_ROWS * 2;
+
+/**
+ * @brief Constructs a cache whose directory is not open yet.
+ *
+ * @param fs Pointer to the FAT object.
+ */
+ImageCache::ImageCache(FAT* fs) : fs(fs), dir(fs)
+{
+}
+
+/**
+ * @brief Gets the key of an image file.
+ *
+ * @param file The open image file.
+ * @param key The key to fill, with a zero cluster if the file cannot be cached.
+ */
+void ImageCache::make_key(File& file, CacheKey& key)
+{
+    key.cluster = file.is_open() ? file.get_first_cluster() : 0;
+    key.size = file.get_file_size();
+    key.modified = key.cluster ? file.get_modified() : 0;
+}
+
+/**
+ * @brief Draws an image into the image area if the cache holds it.
+ *
+ * @details The entry is read a sector at a time straight into a buffer and pushed to one display
+ * window over the whole area. Every 15 sectors end on a row, and the rows are revealed there, so
+ * the image slides in like a decoded one, see Slide. A hit makes the slot the one shown last.
+ *
+ * @param root_dir The root directory, which holds the cache directory.
+ * @param key The key of the image file.
+ * @return True if the image was drawn, false if it has to be decoded.
+ */
+bool ImageCache::draw(File& root_dir, const CacheKey& key)
+{
+    File file(fs);
+    if (!key.cluster || !open_dir(root_dir) || !open_index(file))
+    {
+        return false;
+    }
+    int8_t slot = find(file, key);
+    file.close();
+    if (slot < 0)
+    {
+        return false;
+    }
+    char name[8];
+    entry_name(slot, name);
+    if (!file.open(dir, name, File::O_RDONLY) || file.get_file_size() != ENTRY_SIZE)
+    {
+        file.close();
+        return false;
+    }
+
+    typedef uint8_t Sector[512];
+    Sector& sector = Workspace::get<Sector>();
+    uint32_t done = 0;
+    int16_t n;
+    Slide::begin(0, Slide::AREA_TOP, TFT_WIDTH, AREA_ROWS);
+    ILI9341_SetWindow(0, Slide::AREA_TOP, TFT_WIDTH - 1, Slide::AREA_BOTTOM - 1);
+    ILI9341_TransmitCmmd(ILI9341_RAMWR);
+    while ((n = file.read(sector, sizeof(sector))) > 0)
+    {
+        ILI9341_PushPixels565BE(sector, n / 2);
+        done += n;
+        if (done % (TFT_WIDTH * 2) == 0)
+        {
+            Slide::reveal(done / (TFT_WIDTH * 2));
+        }
+    }
+    file.close();
+    if (done != ENTRY_SIZE)
+    {
+        DEBUG("Cache read error\n");
+        return false;
+    }
+
+    // The use counter only moves when another image was shown in between
+    uint32_t clock, used;
+    if (open_index(file) && file.seek(4) && file.read((uint8_t*) &clock, 4) == 4 &&
+        file.seek(slot * RECORD_SIZE + sizeof(CacheKey)) && file.read((uint8_t*) &used, 4) == 4 &&
+        used != clock)
+    {
+        clock++;
+        file.seek(4);
+        file.write((const uint8_t*) &clock, 4);
+        file.seek(slot * RECORD_SIZE + sizeof(CacheKey));
+        file.write((const uint8_t*) &clock, 4);
+    }
+    file.close();
+    return true;
+}
+
+/**
+ * @brief Stores the image in the image area under the key of its file.
+ *
+ * @details The image must just have been drawn into the image area, with the area not scrolled.
+ * An empty slot is used if there is one, otherwise the slot shown least recently. Its record is
+ * cleared before the entry is written, and written last, so an entry that was cut short is never
+ * found. The entry file gets all its clusters in one run and the display memory is read back into
+ * a sector buffer in the Workspace that goes to the card with one multiple block write.
+ *
+ * @param root_dir The root directory, which holds the cache directory.
+ * @param key The key of the image file.
+ * @return True if the image was stored, false otherwise.
+ */
+bool ImageCache::store(File& root_dir, const CacheKey& key)
+{
+    File file(fs);
+    uint8_t count = slot_count();
+    if (!key.cluster || count == 0 || !open_dir(root_dir) || !open_index(file))
+    {
+        return false;
+    }
+
+    uint8_t record[RECORD_SIZE];
+    uint8_t slot = 1;
+    uint32_t oldest = UINT32_MAX;
+    file.seek(RECORD_SIZE);
+    for (uint8_t s = 1; s <= count && file.read(record, sizeof(record)) == sizeof(record); s++)
+    {
+        uint32_t used;
+        memcpy(&used, record + sizeof(CacheKey), 4);
+        if (!((CacheKey*) record)->cluster)
+        {
+            slot = s;
+            break;
+        }
+        if (used < oldest)
+        {
+            oldest = used;
+            slot = s;
+        }
+    }
+    memset(record, 0, sizeof(record));
+    bool written = file.seek(slot * RECORD_SIZE) &&
+                   file.write(record, sizeof(record)) == sizeof(record);
+    file.close();
+
+    char name[8];
+    entry_name(slot, name);
+    written = written && file.open(dir, name, File::O_RDWR | File::O_CREAT | File::O_TRUNC) &&
+              file.preallocate(ENTRY_SIZE) && file.write_start();
+    if (written)
+    {
+        typedef uint8_t Sector[512];
+        Sector& sector = Workspace::get<Sector>();
+        uint16_t n = 0;
+        ILI9341_SetWindow(0, Slide::AREA_TOP, TFT_WIDTH - 1, Slide::AREA_BOTTOM - 1);
+        ILI9341_ReadStart();
+        for (uint32_t left = ENTRY_SIZE / 2; written && left > 0; left--)
+        {
+            uint16_t color = ILI9341_PullColor565();
+            sector[n++] = color >> 8;
+            sector[n++] = color;
+            if (n == sizeof(sector) || left == 1)
+            {
+                // the last sector is padded past the end of the file
+                memset(sector + n, 0, sizeof(sector) - n);
+                written = file.write_next(sector);
+                n = 0;
+            }
+        }
+        ILI9341_ReadEnd();
+        written = file.write_stop() && written;
+    }
+    file.close();
+
+    uint32_t clock;
+    written = written && open_index(file) && file.seek(4) &&
+              file.read((uint8_t*) &clock, 4) == 4;
+    if (written)
+    {
+        clock++;
+        memcpy(record, &key, sizeof(key));
+        memcpy(record + sizeof(key), &clock, 4);
+        written = file.seek(4) && file.write((const uint8_t*) &clock, 4) == 4 &&
+                  file.seek(slot * RECORD_SIZE) &&
+                  file.write(record, sizeof(record)) == sizeof(record);
+    }
+    file.close();
+    return written;
+}
+
+/**
+ * @brief Opens the cache directory, creating it hidden if needed.
+ *
+ * @param root_dir The root directory, which holds the cache directory.
+ * @return True if the cache directory is open, false otherwise.
+ */
+bool ImageCache::open_dir(File& root_dir)
+{
+    if (dir.is_open() || dir.open(root_dir, DIR_NAME, File::O_RDONLY))
+    {
+        return true;
+    }
+    DEBUG("New image cache\n");
+    if (!dir.make_dir(root_dir, DIR_NAME, DIR_ATT_HIDDEN))
+    {
+        dir.close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Opens the index file for reading and writing, creating it with empty slots if needed.
+ *
+ * @param index The file object to open the index with.
+ * @return True if the index is open, false otherwise.
+ */
+bool ImageCache::open_index(File& index)
+{
+    if (index.open(dir, INDEX_NAME, File::O_RDWR))
+    {
+        if (index.read() == 'I' && index.read() == 'C' && index.read() == 'A' &&
+            index.read() == '1')
+        {
+            return true;
+        }
+        index.close();
+    }
+    if (!index.open(dir, INDEX_NAME, File::O_RDWR | File::O_CREAT | File::O_TRUNC))
+    {
+        return false;
+    }
+    uint8_t record[RECORD_SIZE];
+    memset(record, 0, sizeof(record));
+    for (uint8_t s = 0; s <= SLOTS; s++)
+    {
+        if (index.write(record, sizeof(record)) != sizeof(record))
+        {
+            index.close();
+            return false;
+        }
+    }
+    if (!index.seek(0) || index.write((const uint8_t*) "ICA1", 4) != 4)
+    {
+        index.close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Finds the slot of an image in the index.
+ *
+ * @param index The open index file.
+ * @param key The key of the image file.
+ * @return The slot, or -1 if the cache does not hold the image.
+ */
+int8_t ImageCache::find(File& index, const CacheKey& key)
+{
+    uint8_t record[RECORD_SIZE];
+    uint8_t count = slot_count();
+    index.seek(RECORD_SIZE);
+    for (uint8_t s = 1; s <= count && index.read(record, sizeof(record)) == sizeof(record); s++)
+    {
+        if (!memcmp(record, &key, sizeof(key)))
+        {
+            return s;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Gets the number of slots that fit IMAGE_CACHE_KB.
+ *
+ * @details An entry takes whole clusters, so the number depends on the cluster size of the volume.
+ *
+ * @return The number of slots in use, at most SLOTS.
+ */
+uint8_t ImageCache::slot_count()
+{
+    uint8_t shift = fs->get_cluster_size_shift() + 9;
+    uint32_t entry_bytes = (((ENTRY_SIZE - 1) >> shift) + 1) << shift;
+    uint32_t count = IMAGE_CACHE_KB * 1024UL / entry_bytes;
+    return count < SLOTS ? count : SLOTS;
+}
+
+/**
+ * @brief Makes the name of the entry file of a slot.
+ *
+ * @param slot The slot, 1 to SLOTS.
+ * @param name The buffer for the name, at least 8 characters.
+ */
+void ImageCache::entry_name(uint8_t slot, char* name)
+{
+    memcpy(name, "E00.RGB", 8);
+    name[1] = '0' + slot / 10;
+    name[2] = '0' + slot % 10;
+}
+
+#endif // IMAGE_CACHE_KB
@@ -7,6 +7,7 @@
  * retrieving file names, and opening files.
  */
 #include <ImgFolder.h>
+#include <avr/pgmspace.h>
 
 /**
  * @brief Constructs a new ImgFolder object with looping enabled.
@@ -14,7 +15,9 @@
  * @param fs Pointer to the FAT object.
  */
 ImgFolder::ImgFolder(FAT* fs)
-    : dir(fs), index(-1), max_index(INT8_MAX), image_count(0), loop_on_end(true)
+    : dir(fs), index(-1), max_index(INT8_MAX), image_count(0), loop_on_end(true), counting(false),
+      scan_position(0), scan_files(0), entry(0), prefetch_index(-1), prefetch_entry(0),
+      list_position(0)
 {
 }
 
@@ -26,7 +29,9 @@ ImgFolder::ImgFolder(FAT* fs)
  * end.
  */
 ImgFolder::ImgFolder(FAT* fs, bool loop)
-    : dir(fs), index(-1), max_index(INT8_MAX), image_count(0), loop_on_end(loop)
+    : dir(fs), index(-1), max_index(INT8_MAX), image_count(0), loop_on_end(loop), counting(false),
+      scan_position(0), scan_files(0), entry(0), prefetch_index(-1), prefetch_entry(0),
+      list_position(0)
 {
 }
 
@@ -44,8 +49,9 @@ ImgFolder::~ImgFolder()
  * @brief Initializes the ImgFolder object with the specified root directory and folder name.
  *
  * @details This function opens the directory specified by `root_dir` and `folder_name` in read-only
- * mode. It then counts the number of BMP files in the directory and updates the `image_count` and
- * `max_index` variables accordingly. Finally, it clears the `name_buffer` array.
+ * mode and prepares the image count. The image files are not counted here, that is done in slices
+ * by count_step() so the title screen can be shown at once. Until counting is done `max_index`
+ * stays at its maximum and navigation stops at the first missing file instead.
  *
  * @param root_dir The root directory where the folder is located.
  * @param folder_name The name of the folder to be initialized.
@@ -53,20 +59,95 @@ ImgFolder::~ImgFolder()
 void ImgFolder::init(File& root_dir, const char* folder_name)
 {
     dir.open(root_dir, folder_name, File::O_RDONLY);
-    uint8_t count = 0;
-    while (dir.ls(name_buffer, File::LS_FILE, count++))
+    image_count = 0;
+    max_index = INT8_MAX;
+    scan_position = 0;
+    scan_files = 0;
+    counting = dir.is_open();
+    memset(name_buffer, 0, sizeof(name_buffer));
+}
+
+/**
+ * @brief Counts the next few image files in the folder.
+ *
+ * @details The directory is read sequentially from where the previous call stopped, so counting
+ * the whole folder reads every directory block once. At most `COUNT_SLICE` files are examined per
+ * call. When the end of the folder is reached `max_index` is set from the final count. When the
+ * entry of the current file is passed its index is set from the files before it, which corrects an
+ * index saved before the folder changed, see resume().
+ *
+ * @return True if there are files left to count, false once counting is done.
+ */
+bool ImgFolder::count_step()
+{
+    if (!counting)
+    {
+        return false;
+    }
+    dir.seek(scan_position);
+    for (uint8_t i = 0; i < COUNT_SLICE; i++)
     {
-        if (strlen(name_buffer) == 0)
+        if (!dir.ls(name_buffer, File::LS_FILE) || strlen(name_buffer) == 0)
         {
+            counting = false;
+            max_index = image_count - 1;
             break;
         }
-        if (strcasestr(name_buffer, ".bmp") != NULL)
+        if ((dir.get_current_position() >> 5) - 1 == entry && index >= 0)
+        {
+            // the current file may have moved since its index was saved
+            index = scan_files;
+        }
+        scan_files++;
+        if (is_image(name_buffer))
         {
             image_count++;
         }
     }
-    max_index = image_count - 1;
+    scan_position = dir.get_current_position();
     memset(name_buffer, 0, sizeof(name_buffer));
+    return counting;
+}
+
+/**
+ * @brief Reopens the folder and the image file that were shown last.
+ *
+ * @details The folder is opened by its first cluster and the image by its directory entry, so no
+ * directory is searched. The files on the card may have been replaced since the position was saved,
+ * so the entry must still hold a file with an image extension. The images are counted again in the
+ * background by count_step(), which also finds the index of the entry again. Until then the saved
+ * index is shown.
+ *
+ * @param folder_cluster The first cluster of the folder.
+ * @param index The index of the image file.
+ * @param entry The directory entry of the image file.
+ * @param imgFile The `File` object used to open the image file.
+ * @return `true` if the image file was opened, `false` otherwise and the folder is left closed.
+ */
+bool ImgFolder::resume(uint32_t folder_cluster, int8_t index, uint16_t entry, File& imgFile)
+{
+    if (!dir.open_dir(folder_cluster))
+    {
+        return false;
+    }
+    memset(name_buffer, 0, sizeof(name_buffer));
+    bool found = dir.seek((uint32_t) entry << 5) && dir.ls(name_buffer, File::LS_FILE) &&
+                 dir.get_current_position() == ((uint32_t) entry + 1) << 5 &&
+                 is_image(name_buffer);
+    if (!found || !imgFile.open_entry(dir, entry, File::O_RDONLY))
+    {
+        dir.close();
+        return false;
+    }
+    this->index = index;
+    this->entry = entry;
+    image_count = 0;
+    max_index = INT8_MAX;
+    scan_position = 0;
+    scan_files = 0;
+    counting = true;
+    memset(name_buffer, 0, sizeof(name_buffer));
+    return true;
 }
 
 /**
@@ -104,7 +185,7 @@ bool ImgFolder::next_file(File& imgFile)
     {
         return false;
     }
-    return imgFile.open(dir, name_buffer, File::O_RDONLY);
+    return open_current(imgFile);
 }
 /**
  * @brief Moves to the previous file in the image folder and opens it.
@@ -125,7 +206,166 @@ bool ImgFolder::prev_file(File& imgFile)
     {
         return false;
     }
-    return imgFile.open(dir, name_buffer, File::O_RDONLY);
+    return open_current(imgFile);
+}
+
+/**
+ * @brief Opens the current image file again.
+ *
+ * @details The file is opened by its directory entry, so the folder is not searched.
+ *
+ * @param imgFile The `File` object used to open the image file.
+ * @return `true` if the file was opened, `false` otherwise.
+ */
+bool ImgFolder::reopen_current(File& imgFile)
+{
+    return imgFile.open_entry(dir, entry, File::O_RDONLY);
+}
+
+/**
+ * @brief Starts listing the files of the folder at a file.
+ *
+ * @details The directory is walked up to the file once. list_next() then continues from there, so
+ * a run of files is listed with one read per directory block, whatever else is read in between.
+ *
+ * @param index The index of the first file to list.
+ * @return `true` if the files before it exist, `false` otherwise.
+ */
+bool ImgFolder::list_start(uint8_t index)
+{
+    list_position = 0;
+    if (index > 0)
+    {
+        bool found = dir.ls(name_buffer, File::LS_FILE, index - 1);
+        memset(name_buffer, 0, sizeof(name_buffer));
+        if (!found)
+        {
+            return false;
+        }
+        list_position = dir.get_current_position();
+    }
+    return true;
+}
+
+/**
+ * @brief Lists the next file of the folder without opening it.
+ *
+ * @details The size and first cluster are taken from the directory entry, so they identify the
+ * contents of the file without a read of the file or of the FAT.
+ *
+ * @param entry The directory entry of the file.
+ * @param size The size of the file.
+ * @param cluster The first cluster of the file.
+ * @return `true` if there was a next file, `false` at the end of the folder.
+ */
+bool ImgFolder::list_next(uint16_t& entry, uint32_t& size, uint32_t& cluster)
+{
+    dir.seek(list_position);
+    dir_t* p = dir.ls_next(File::LS_FILE);
+    if (!p)
+    {
+        return false;
+    }
+    list_position = dir.get_current_position();
+    entry = (list_position >> 5) - 1;
+    size = p->fileSize;
+    cluster = (uint32_t) p->firstClusterHigh << 16 | p->firstClusterLow;
+    return true;
+}
+
+/**
+ * @brief Opens a file of the folder by its directory entry without moving to it.
+ *
+ * @param entry The directory entry of the file, see list_next().
+ * @param imgFile The `File` object used to open the file.
+ * @return `true` if the file was opened, `false` otherwise.
+ */
+bool ImgFolder::open_entry(uint16_t entry, File& imgFile)
+{
+    return imgFile.open_entry(dir, entry, File::O_RDONLY);
+}
+
+/**
+ * @brief Moves to a file of the folder and opens it.
+ *
+ * @param index The index of the file.
+ * @param entry The directory entry of the file, see list_next().
+ * @param imgFile The `File` object used to open the file.
+ * @return `true` if the file was opened, `false` otherwise and the current file stays the same.
+ */
+bool ImgFolder::go_to(int8_t index, uint16_t entry, File& imgFile)
+{
+    if (!open_entry(entry, imgFile))
+    {
+        return false;
+    }
+    this->index = index;
+    this->entry = entry;
+    return true;
+}
+
+/**
+ * @brief Opens the next file in the image folder without moving to it.
+ *
+ * @details The file that next_file() would open is opened in `imgFile`, but the current index
+ * stays unchanged until use_prefetched() is called. This lets the directory search be done while
+ * the current image is still shown.
+ *
+ * @param imgFile The `File` object used to open the next file.
+ * @return `true` if the next file was opened, `false` otherwise.
+ */
+bool ImgFolder::prefetch_next(File& imgFile)
+{
+    int8_t curr_index = index;
+    uint16_t curr_entry = entry;
+    bool opened = next_file(imgFile);
+    prefetch_index = index;
+    prefetch_entry = entry;
+    index = curr_index;
+    entry = curr_entry;
+    return opened;
+}
+
+/**
+ * @brief Moves to the file opened by the last prefetch_next() call.
+ */
+void ImgFolder::use_prefetched()
+{
+    index = prefetch_index;
+    entry = prefetch_entry;
+}
+
+/**
+ * @brief Checks if a file name has the extension of a supported image format.
+ *
+ * @param name The file name.
+ * @return true for BMP, QOI, JPEG, GIF, RGV video, TIL tiled and LZ5 compressed image files, false
+ * otherwise.
+ */
+bool ImgFolder::is_image(const char* name)
+{
+    return strcasestr_P(name, PSTR(".bmp")) != NULL || strcasestr_P(name, PSTR(".qoi")) != NULL ||
+           strcasestr_P(name, PSTR(".jpg")) != NULL || strcasestr_P(name, PSTR(".jpeg")) != NULL ||
+           strcasestr_P(name, PSTR(".gif")) != NULL || strcasestr_P(name, PSTR(".rgv")) != NULL ||
+           strcasestr_P(name, PSTR(".til")) != NULL || strcasestr_P(name, PSTR(".lz5")) != NULL;
+}
+
+/**
+ * @brief Opens the file named in `name_buffer` and remembers its directory entry.
+ *
+ * @details File::open() leaves the folder positioned right after the entry it opened.
+ *
+ * @param imgFile The `File` object used to open the image file.
+ * @return `true` if the file was opened, `false` otherwise.
+ */
+bool ImgFolder::open_current(File& imgFile)
+{
+    if (!imgFile.open(dir, name_buffer, File::O_RDONLY))
+    {
+        return false;
+    }
+    entry = (dir.get_current_position() >> 5) - 1;
+    return true;
 }
 
 /**
@@ -153,7 +393,7 @@ bool ImgFolder::next_file_name(char* buffer)
     }
     uint8_t curr_index = index;
     dir.ls(buffer, File::LS_FILE, ++index);
-    if (strlen(buffer) == 0 || strcasestr(buffer, ".bmp") == NULL)
+    if (strlen(buffer) == 0 || !is_image(buffer))
     {
         index = curr_index;
         return false;
@@ -179,7 +419,7 @@ bool ImgFolder::prev_file_name(char* buffer)
     }
     uint8_t curr_index = index;
     dir.ls(buffer, File::LS_FILE, --index);
-    if (strlen(buffer) == 0 || strcasestr(buffer, ".bmp") == NULL)
+    if (strlen(buffer) == 0 || !is_image(buffer))
     {
         index = curr_index;
         return false;
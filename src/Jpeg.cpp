@@ -0,0 +1,733 @@
+/**
+ * @file Jpeg.cpp
+ * @brief Baseline JPEG decoder with scaled output.
+ *
+ * This file contains the implementation of the Jpeg class, which decodes baseline JPEG files from
+ * the SD card and draws them on the display one MCU at a time.
+ */
+#include <Jpeg.h>
+#include <Slide.h>
+#include <Workspace.h>
+#include <avr/pgmspace.h>
+#include <config.h>
+extern "C"
+{
+#include <ili9341.h>
+}
+
+/** Natural order position of each zigzag ordered coefficient. */
+static const uint8_t ZIGZAG[64] PROGMEM = {
+    0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,  12, 19, 26, 33, 40, 48,
+    41, 34, 27, 20, 13, 6,  7,  14, 21, 28, 35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23,
+    30, 37, 44, 51, 58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63};
+
+/** 8-point IDCT basis, C(u) / 2 * cos((2x + 1)u * pi / 16) scaled by 4096, indexed [x][u]. */
+static const int16_t IDCT8[64] PROGMEM = {
+    1448, 2009,  1892,  1703,  1448,  1138,  784,   400,   1448, 1703,  784,   -400,  -1448,
+    -2009, -1892, -1138, 1448, 1138,  -784,  -2009, -1448, 400,   1892,  1703,  1448,  400,
+    -1892, -1138, 1448,  1703, -784,  -2009, 1448,  -400,  -1892, 1138,  1448,  -1703, -784,
+    2009,  1448,  -1138, -784, 2009,  -1448, -400,  1892,  -1703, 1448,  -1703, 784,   400,
+    -1448, 2009,  -1892, 1138, 1448,  -2009, 1892,  -1703, 1448,  -1138, 784,   -400};
+
+/** 4-point IDCT basis for the lowest 4x4 coefficients, same normalization as IDCT8. */
+static const int16_t IDCT4[16] PROGMEM = {1448, 1892,  1448,  784,  1448, 784,  -1448, -1892,
+                                          1448, -784, -1448, 1892, 1448, -1892, 1448, -784};
+
+/** 2-point IDCT basis for the lowest 2x2 coefficients, same normalization as IDCT8. */
+static const int16_t IDCT2[4] PROGMEM = {1448, 1448, 1448, -1448};
+
+/**
+ * @brief Limits a value to the 0 - 255 sample range.
+ */
+static inline uint8_t clamp(int16_t value)
+{
+    return value < 0 ? 0 : value > 255 ? 255 : value;
+}
+
+/**
+ * @brief Checks for the JPEG start of image marker.
+ *
+ * @details The file must be positioned at its start. On success it is left after the marker.
+ *
+ * @param file The file to check.
+ * @return True if the file starts like a JPEG file, false otherwise.
+ */
+bool Jpeg::is_jpeg(File& file)
+{
+    return file.read() == 0xFF && file.read() == 0xD8;
+}
+
+/**
+ * @brief Draws a JPEG image on the display at the specified coordinates.
+ *
+ * @details The image is drawn into the 240x300 image area, cropped if it is still larger at 1/8,
+ * see draw_area(). The file is closed afterwards.
+ *
+ * @param file The File object representing the JPEG file, positioned after the start of image
+ * marker.
+ * @param x The x-coordinate of the top-left corner of the image area on the display.
+ * @param y The y-coordinate of the top-left corner of the image area on the display.
+ * @return True if every visible MCU was drawn, false if the file is unsupported, corrupt or could
+ * not be read.
+ */
+bool Jpeg::draw(File& file, uint8_t x, uint8_t y)
+{
+    return draw_area(file, x, y, TFT_WIDTH, TFT_HEIGHT - 20, true);
+}
+
+/**
+ * @brief Draws a JPEG image into an area of the display.
+ *
+ * @details The image is decoded at the largest scale that fits the area and centered if it is
+ * smaller. An image that is still larger at 1/8 is cropped, or left undrawn if crop is false.
+ * Unsupported files are reported and left undrawn. The file is closed afterwards.
+ *
+ * @param file The File object representing the JPEG file, positioned after the start of image
+ * marker.
+ * @param x The x-coordinate of the top-left corner of the area on the display.
+ * @param y The y-coordinate of the top-left corner of the area on the display.
+ * @param area_w The width of the area.
+ * @param area_h The height of the area.
+ * @param crop True to crop an image that does not fit, false to leave it undrawn.
+ * @return True if every visible MCU was drawn, false if the file is unsupported, corrupt, could
+ * not be read or does not fit.
+ */
+bool Jpeg::draw_area(File& file, uint8_t x, uint8_t y, uint16_t area_w, uint16_t area_h,
+                     bool crop)
+{
+    Jpeg jpeg(file);
+    bool drawn = false;
+    if (!jpeg.read_markers())
+    {
+        DEBUG("Unsupported JPEG file\n");
+    }
+    else if (jpeg.fit(area_w, area_h) || crop)
+    {
+        drawn = jpeg.decode(x, y, area_w, area_h);
+    }
+    file.close();
+    return drawn;
+}
+
+/**
+ * @brief Constructs a decoder reading from the current position of a file.
+ *
+ * @param file The JPEG file.
+ */
+Jpeg::Jpeg(File& file)
+    : reader(file, read_buffer, sizeof(read_buffer)), buf(Workspace::get<Buffers>()),
+      comp_count(0), width(0), height(0), restart_interval(0), scale(8), bit_byte(0), bit_count(0),
+      marker_hit(false)
+{
+}
+
+/**
+ * @brief Reads a big-endian 16-bit value.
+ */
+uint16_t Jpeg::read16()
+{
+    uint16_t value = (uint8_t) reader.read() << 8;
+    return value | (uint8_t) reader.read();
+}
+
+/**
+ * @brief Reads the marker segments up to and including the start of scan.
+ *
+ * @details Application and comment segments, such as the EXIF data of camera photos, are skipped
+ * without being read.
+ *
+ * @return True if the entropy coded data of a supported image follows, false otherwise.
+ */
+bool Jpeg::read_markers()
+{
+    bool frame = false;
+    while (true)
+    {
+        int16_t marker;
+        if (reader.read() != 0xFF)
+        {
+            return false;
+        }
+        do
+        {
+            marker = reader.read();
+        } while (marker == 0xFF);
+        if (marker < 0 || marker == 0xD9)
+        {
+            return false;
+        }
+
+        uint16_t length = read16();
+        if (length < 2)
+        {
+            return false;
+        }
+        length -= 2;
+
+        switch (marker)
+        {
+        case 0xC0: // SOF0 - baseline
+        case 0xC1: // SOF1 - extended sequential, Huffman
+            if (!read_sof(length))
+                return false;
+            frame = true;
+            break;
+        case 0xC4: // DHT
+            if (!read_dht(length))
+                return false;
+            break;
+        case 0xDB: // DQT
+            if (!read_dqt(length))
+                return false;
+            break;
+        case 0xDD: // DRI
+            restart_interval = read16();
+            reader.skip(length - 2);
+            break;
+        case 0xDA: // SOS
+            return frame && read_sos();
+        default:
+            // Other frame types (progressive, arithmetic coding) are not supported
+            if (marker >= 0xC2 && marker <= 0xCF)
+                return false;
+            reader.skip(length);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Reads a define quantization table segment.
+ *
+ * @param length The length of the segment data.
+ * @return True if all tables are 8-bit tables 0 or 1, false otherwise.
+ */
+bool Jpeg::read_dqt(uint16_t length)
+{
+    while (length >= 65)
+    {
+        uint8_t pq_tq = reader.read();
+        if (pq_tq > 1)
+        {
+            return false;
+        }
+        reader.read(buf.quant[pq_tq], 64);
+        length -= 65;
+    }
+    return length == 0;
+}
+
+/**
+ * @brief Reads a define Huffman table segment.
+ *
+ * @param length The length of the segment data.
+ * @return True if all tables are valid baseline tables, false otherwise.
+ */
+bool Jpeg::read_dht(uint16_t length)
+{
+    while (length >= 17)
+    {
+        uint8_t tc_th = reader.read();
+        uint8_t th = tc_th & 0x0F;
+        bool ac = tc_th >> 4;
+        if (th > 1 || (tc_th >> 4) > 1)
+        {
+            return false;
+        }
+        uint8_t* bits = ac ? buf.ac_bits[th] : buf.dc_bits[th];
+        uint8_t* vals = ac ? buf.ac_vals[th] : buf.dc_vals[th];
+        uint16_t total = 0;
+        reader.read(bits, 16);
+        for (uint8_t i = 0; i < 16; i++)
+        {
+            total += bits[i];
+        }
+        if (total > (ac ? sizeof(buf.ac_vals[0]) : sizeof(buf.dc_vals[0])) ||
+            total + 17 > length)
+        {
+            return false;
+        }
+        reader.read(vals, total);
+        length -= total + 17;
+    }
+    return length == 0;
+}
+
+/**
+ * @brief Reads a start of frame segment.
+ *
+ * @param length The length of the segment data.
+ * @return True if the frame is supported, false otherwise.
+ */
+bool Jpeg::read_sof(uint16_t length)
+{
+    if (reader.read() != 8)
+    {
+        return false;
+    }
+    height = read16();
+    width = read16();
+    comp_count = reader.read();
+    if ((comp_count != 1 && comp_count != 3) || length != 6 + 3 * comp_count || width == 0 ||
+        height == 0)
+    {
+        return false;
+    }
+    for (uint8_t i = 0; i < comp_count; i++)
+    {
+        Component& comp = comps[i];
+        comp.id = reader.read();
+        uint8_t hv = reader.read();
+        comp.h = hv >> 4;
+        comp.v = hv & 0x0F;
+        comp.tq = reader.read();
+        if (comp.tq > 1)
+        {
+            return false;
+        }
+    }
+
+    if (comp_count == 1)
+    {
+        // A single component scan is not interleaved, its MCU is one block
+        comps[0].h = comps[0].v = 1;
+    }
+    else if (comps[0].h < 1 || comps[0].h > 2 || comps[0].v < 1 || comps[0].v > comps[0].h ||
+             comps[1].h != 1 || comps[1].v != 1 || comps[2].h != 1 || comps[2].v != 1)
+    {
+        return false;
+    }
+
+    comps[0].samples = buf.samples;
+    comps[1].samples = buf.samples + 64;
+    comps[2].samples = buf.samples + 80;
+    return true;
+}
+
+/**
+ * @brief Chooses the largest output scale at which the frame fits an area.
+ *
+ * @details Colour MCUs only fit the sample buffer from 1/2 down, and 1/8 is the smallest scale.
+ *
+ * @param area_w The width of the area.
+ * @param area_h The height of the area.
+ * @return True if the frame fits the area at the chosen scale, false if it is still larger.
+ */
+bool Jpeg::fit(uint16_t area_w, uint16_t area_h)
+{
+    uint8_t shift = comp_count == 1 ? 0 : 1;
+    while (shift < 3 && ((((uint32_t) width + (1 << shift) - 1) >> shift) > area_w ||
+                         (((uint32_t) height + (1 << shift) - 1) >> shift) > area_h))
+    {
+        shift++;
+    }
+    scale = 8 >> shift;
+    return (((uint32_t) width + (1 << shift) - 1) >> shift) <= area_w &&
+           (((uint32_t) height + (1 << shift) - 1) >> shift) <= area_h;
+}
+
+/**
+ * @brief Reads a start of scan segment.
+ *
+ * @return True if the scan holds all components of the frame, false otherwise.
+ */
+bool Jpeg::read_sos()
+{
+    if (reader.read() != comp_count)
+    {
+        return false;
+    }
+    for (uint8_t i = 0; i < comp_count; i++)
+    {
+        uint8_t id = reader.read();
+        uint8_t td_ta = reader.read();
+        // Scan components must come in frame order
+        if (comps[i].id != id || (td_ta >> 4) > 1 || (td_ta & 0x0F) > 1)
+        {
+            return false;
+        }
+        comps[i].td = td_ta >> 4;
+        comps[i].ta = td_ta & 0x0F;
+        comps[i].dc_pred = 0;
+    }
+    // Spectral selection and successive approximation are fixed for baseline
+    reader.skip(3);
+    return true;
+}
+
+/**
+ * @brief Decodes the entropy coded data and draws the visible MCUs.
+ *
+ * @details A slide transition reveals the image one MCU row at a time, see Slide. Data that ends
+ * at the end of the file rather than at a marker is decoded as zero bits like after a marker, but
+ * the image does not count as drawn.
+ *
+ * @param x The x-coordinate of the top-left corner of the area on the display.
+ * @param y The y-coordinate of the top-left corner of the area on the display.
+ * @param area_w The width of the area.
+ * @param area_h The height of the area.
+ * @return True if every visible MCU was decoded, false if the data is corrupt or ended early.
+ */
+bool Jpeg::decode(uint8_t x, uint8_t y, uint16_t area_w, uint16_t area_h)
+{
+    uint8_t shift = scale == 8 ? 0 : scale == 4 ? 1 : scale == 2 ? 2 : 3;
+    uint8_t mcu_w = 8 * comps[0].h; // MCU size in the image
+    uint8_t mcu_h = 8 * comps[0].v;
+    uint8_t out_w = scale * comps[0].h; // MCU size on the display
+    uint8_t out_h = scale * comps[0].v;
+    uint16_t mcus_x = ((uint32_t) width + mcu_w - 1) / mcu_w;
+    uint16_t mcus_y = ((uint32_t) height + mcu_h - 1) / mcu_h;
+    uint16_t w, h;
+    uint16_t restarts_left = restart_interval;
+
+    // Crop area to be drawn
+    w = ((uint32_t) width + (1 << shift) - 1) >> shift;
+    h = ((uint32_t) height + (1 << shift) - 1) >> shift;
+    if (w > area_w)
+        w = area_w;
+    if (h > area_h)
+        h = area_h;
+
+    // If the image is smaller than the area
+    // center vertically and horizontally
+    x += (area_w - w) / 2;
+    y += (area_h - h) / 2;
+
+    Slide::begin(x, y, w, h);
+    for (uint16_t my = 0; my < mcus_y && my * out_h < h; my++)
+    {
+        for (uint16_t mx = 0; mx < mcus_x; mx++)
+        {
+            if (restart_interval)
+            {
+                if (restarts_left == 0)
+                {
+                    restart();
+                    restarts_left = restart_interval;
+                }
+                restarts_left--;
+            }
+
+            bool visible = mx * out_w < w;
+            for (uint8_t c = 0; c < comp_count; c++)
+            {
+                Component& comp = comps[c];
+                for (uint8_t by = 0; by < comp.v; by++)
+                {
+                    for (uint8_t bx = 0; bx < comp.h; bx++)
+                    {
+                        if (!decode_block(comp, visible))
+                        {
+                            DEBUG("Corrupt JPEG data\n");
+                            return false;
+                        }
+                        if (visible)
+                        {
+                            idct(comp.samples + by * scale * comp.h * scale + bx * scale,
+                                 comp.h * scale);
+                        }
+                    }
+                }
+            }
+
+            if (visible)
+            {
+                uint16_t px = mx * out_w, py = my * out_h;
+                put_mcu(x + px, y + py, px + out_w > w ? w - px : out_w,
+                        py + out_h > h ? h - py : out_h);
+            }
+        }
+        Slide::reveal((my + 1) * out_h < h ? (my + 1) * out_h : h);
+    }
+    return !reader.failed();
+}
+
+/**
+ * @brief Decodes the coefficients of one block.
+ *
+ * @details All coefficients have to be Huffman decoded to find the next block, but only the ones
+ * used by the scaled IDCT are dequantized and stored.
+ *
+ * @param comp The component the block belongs to.
+ * @param keep True to store the coefficients for idct(), false to only skip the block.
+ * @return True on success, false if the data is corrupt.
+ */
+bool Jpeg::decode_block(Component& comp, bool keep)
+{
+    const uint8_t* q = buf.quant[comp.tq];
+    int16_t symbol;
+
+    if (keep)
+    {
+        for (uint8_t v = 0; v < scale; v++)
+        {
+            memset(buf.coef + v * 8, 0, scale * sizeof(int16_t));
+        }
+    }
+
+    // DC coefficient is coded as the difference to the previous block
+    symbol = decode_huffman(buf.dc_bits[comp.td], buf.dc_vals[comp.td]);
+    if (symbol < 0)
+    {
+        return false;
+    }
+    comp.dc_pred += receive_extend(symbol);
+    if (keep)
+    {
+        buf.coef[0] = comp.dc_pred * q[0];
+    }
+
+    // AC coefficients as run length of zeros and size
+    for (uint8_t k = 1; k < 64; k++)
+    {
+        symbol = decode_huffman(buf.ac_bits[comp.ta], buf.ac_vals[comp.ta]);
+        if (symbol < 0)
+        {
+            return false;
+        }
+        uint8_t run = symbol >> 4;
+        uint8_t size = symbol & 0x0F;
+        if (size == 0)
+        {
+            if (run != 15)
+            {
+                break; // End of block
+            }
+            k += 15; // 16 zeros
+            continue;
+        }
+        k += run;
+        if (k > 63)
+        {
+            return false;
+        }
+        int16_t value = receive_extend(size);
+        if (keep)
+        {
+            uint8_t z = pgm_read_byte(&ZIGZAG[k]);
+            if ((z & 7) < scale && (z >> 3) < scale)
+            {
+                buf.coef[z] = value * q[k];
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Transforms the stored coefficients into scale x scale samples.
+ *
+ * @details A separable integer IDCT of size `scale` over the lowest scale x scale coefficients.
+ * The row pass keeps 3 fractional bits in `coef`. At scale 1 the sample is the DC average.
+ *
+ * @param out Where the top-left sample is stored.
+ * @param stride The distance between sample rows in `out`.
+ */
+void Jpeg::idct(uint8_t* out, uint8_t stride)
+{
+    if (scale == 1)
+    {
+        out[0] = clamp(((buf.coef[0] + 4) >> 3) + 128);
+        return;
+    }
+
+    const int16_t* basis = scale == 8 ? IDCT8 : scale == 4 ? IDCT4 : IDCT2;
+    int16_t row[8];
+
+    for (uint8_t v = 0; v < scale; v++)
+    {
+        int16_t* c = buf.coef + v * 8;
+        for (uint8_t x = 0; x < scale; x++)
+        {
+            int32_t sum = 0;
+            for (uint8_t u = 0; u < scale; u++)
+            {
+                sum += (int32_t) (int16_t) pgm_read_word(&basis[x * scale + u]) * c[u];
+            }
+            row[x] = (sum + 256) >> 9;
+        }
+        memcpy(c, row, scale * sizeof(int16_t));
+    }
+
+    for (uint8_t x = 0; x < scale; x++)
+    {
+        for (uint8_t y = 0; y < scale; y++)
+        {
+            int32_t sum = 0;
+            for (uint8_t v = 0; v < scale; v++)
+            {
+                sum += (int32_t) (int16_t) pgm_read_word(&basis[y * scale + v]) *
+                       buf.coef[v * 8 + x];
+            }
+            out[y * stride + x] = clamp(((sum + 16384) >> 15) + 128);
+        }
+    }
+}
+
+/**
+ * @brief Converts the samples of the current MCU to RGB565 and writes them to the display.
+ *
+ * @param x The x-coordinate of the MCU on the display.
+ * @param y The y-coordinate of the MCU on the display.
+ * @param w The visible width of the MCU.
+ * @param h The visible height of the MCU.
+ */
+void Jpeg::put_mcu(uint16_t x, uint16_t y, uint8_t w, uint8_t h)
+{
+    uint8_t stride = comps[0].h * scale;
+    uint8_t hs = comps[0].h - 1; // chroma subsampling shifts
+    uint8_t vs = comps[0].v - 1;
+
+    ILI9341_SetWindow(x, y, x + w - 1, y + h - 1);
+    ILI9341_TransmitCmmd(ILI9341_RAMWR);
+
+    for (uint8_t row = 0; row < h; row++)
+    {
+        const uint8_t* luma = buf.samples + row * stride;
+        const uint8_t* cb = comps[1].samples + (row >> vs) * scale;
+        const uint8_t* cr = comps[2].samples + (row >> vs) * scale;
+        for (uint8_t col = 0; col < w; col++)
+        {
+            int16_t l = luma[col];
+            uint8_t r, g, b;
+            if (comp_count == 1)
+            {
+                r = g = b = l;
+            }
+            else
+            {
+                // YCbCr to RGB with 6 fractional bits
+                int16_t u = cb[col >> hs] - 128;
+                int16_t v = cr[col >> hs] - 128;
+                r = clamp(l + ((90 * v) >> 6));
+                g = clamp(l - ((22 * u + 46 * v) >> 6));
+                b = clamp(l + ((113 * u) >> 6));
+            }
+            ILI9341_Transmit16bitData((r & 0xF8) << 8 | (g & 0xFC) << 3 | b >> 3);
+        }
+    }
+}
+
+/**
+ * @brief Decodes one Huffman coded symbol.
+ *
+ * @details The codes are canonical, so the codes of each length are consecutive and follow the
+ * codes of the previous length. The code is compared against the range of each length in turn.
+ *
+ * @param bits The number of codes of each length.
+ * @param vals The symbols in code order.
+ * @return The symbol, or -1 if no code matches.
+ */
+int16_t Jpeg::decode_huffman(const uint8_t* bits, const uint8_t* vals)
+{
+    uint16_t code = 0;  // code read so far
+    uint16_t first = 0; // first code of the current length
+    uint8_t index = 0;  // symbol of the first code
+
+    for (uint8_t length = 0; length < 16; length++)
+    {
+        code = code << 1 | get_bit();
+        uint8_t count = bits[length];
+        if ((uint16_t) (code - first) < count)
+        {
+            return vals[index + code - first];
+        }
+        index += count;
+        first = (first + count) << 1;
+    }
+    return -1;
+}
+
+/**
+ * @brief Reads a value of the given bit size and extends it to its signed value.
+ *
+ * @param size The number of bits, 0 to 15.
+ * @return The signed value.
+ */
+int16_t Jpeg::receive_extend(uint8_t size)
+{
+    if (size == 0)
+    {
+        return 0;
+    }
+    int16_t value = 0;
+    for (uint8_t i = 0; i < size; i++)
+    {
+        value = value << 1 | get_bit();
+    }
+    if (value < (1 << (size - 1)))
+    {
+        value += 1 - (1 << size);
+    }
+    return value;
+}
+
+/**
+ * @brief Reads the next bit of the entropy coded data.
+ *
+ * @details Stuffed zero bytes after 0xFF are removed. A marker ends the data, after it only zero
+ * bits are returned.
+ *
+ * @return The bit.
+ */
+uint8_t Jpeg::get_bit()
+{
+    if (bit_count == 0)
+    {
+        int16_t byte = marker_hit ? 0 : reader.read();
+        if (byte == 0xFF)
+        {
+            if (reader.read() != 0)
+            {
+                marker_hit = true;
+                byte = 0;
+            }
+        }
+        else if (byte < 0)
+        {
+            marker_hit = true;
+            byte = 0;
+        }
+        bit_byte = byte;
+        bit_count = 8;
+    }
+    return (bit_byte >> --bit_count) & 1;
+}
+
+/**
+ * @brief Resynchronizes on a restart marker.
+ *
+ * @details The remaining bits of the current byte are dropped, the data is searched for the next
+ * RSTn marker unless it was already hit, and the DC predictions are reset.
+ */
+void Jpeg::restart()
+{
+    bit_count = 0;
+    if (!marker_hit)
+    {
+        int16_t byte = reader.read();
+        while (byte >= 0)
+        {
+            if (byte == 0xFF)
+            {
+                do
+                {
+                    byte = reader.read();
+                } while (byte == 0xFF);
+                if (byte >= 0xD0 && byte <= 0xD7)
+                {
+                    break;
+                }
+            }
+            else
+            {
+                byte = reader.read();
+            }
+        }
+    }
+    marker_hit = false;
+    for (uint8_t i = 0; i < comp_count; i++)
+    {
+        comps[i].dc_pred = 0;
+    }
+}
@@ -0,0 +1,174 @@
+/**
+ * @file Lz565.cpp
+ * @brief Streaming decoder for LZ compressed RGB565 images.
+ *
+ * This file contains the implementation of the Lz565 class, which decodes LZ compressed RGB565
+ * files from the SD card and draws them on the display a token at a time.
+ */
+#include <Lz565.h>
+#include <Slide.h>
+#include <StreamReader.h>
+#include <Workspace.h>
+#include <config.h>
+extern "C"
+{
+#include <ili9341.h>
+}
+
+/**
+ * @brief Parses the header of an LZ compressed RGB565 file.
+ *
+ * @details The file must be positioned at its start. On success the file is left on the first
+ * row.
+ *
+ * @param file The file to parse the header from.
+ * @param header The Lz565Header object to store the parsed header information.
+ * @return True if the file is an LZ compressed RGB565 image, false otherwise.
+ */
+bool Lz565::parse_header(File& file, Lz565Header& header)
+{
+    if (file.read() != 'L' || file.read() != '5' || file.read() != '6' || file.read() != '5')
+    {
+        return false;
+    }
+    header.width = File::read16(file);
+    header.height = File::read16(file);
+    return header.width > 0 && header.height > 0;
+}
+
+/**
+ * @brief Draws an LZ compressed RGB565 image on the display at the specified coordinates.
+ *
+ * @details The tokens are decoded in file order into a display window covering the visible part
+ * of the image. The window of a row is a ring of RING pixels indexed by the column, so a literal
+ * is read straight into it and a copy moves pixels within it, and both are pushed from there in at
+ * most two pieces. A repeat is pushed with a single run-fill and only written to the ring for later
+ * copies. Images larger than the 240x300 image area are cropped like QOI images: columns right of
+ * the area are decoded and not pushed, and decoding stops after the last visible row. Smaller
+ * images are centered. A slide transition reveals every row as it is finished, see Slide. The file
+ * is closed afterwards.
+ *
+ * The file is read a sector at a time, so the sectors bypass the FAT cache. RAM use is the 512 byte
+ * read buffer plus the 256 byte ring, both in the Workspace. A token that runs past its row or
+ * copies from before it ends the image.
+ *
+ * @param file The File object representing the image file, positioned after the header.
+ * @param header The parsed header of the file.
+ * @param x The x-coordinate of the top-left corner of the image area on the display.
+ * @param y The y-coordinate of the top-left corner of the image area on the display.
+ * @return True if every visible row was drawn, false if the data is corrupt or could not be read.
+ */
+bool Lz565::draw(File& file, const Lz565Header& header, uint8_t x, uint8_t y)
+{
+    struct Buffers
+    {
+        uint8_t buffer[512];    // read buffer, one sector
+        uint8_t ring[2 * RING]; // last pixels of the row, big-endian
+    };
+    Buffers& buffers = Workspace::get<Buffers>();
+    uint8_t* ring = buffers.ring;
+    StreamReader reader(file, buffers.buffer, sizeof(buffers.buffer));
+
+    // Crop area to be loaded
+    uint16_t w = header.width;
+    uint16_t h = header.height;
+    if (w > TFT_WIDTH)
+        w = TFT_WIDTH;
+    if (h > TFT_HEIGHT - 20)
+        h = TFT_HEIGHT - 20;
+
+    // If the image is smaller than the screen
+    // center vertically and horizontally
+    x += (TFT_WIDTH - w) / 2;
+    y += (TFT_HEIGHT - 20 - h) / 2;
+
+    Slide::begin(x, y, w, h);
+    ILI9341_SetWindow(x, y, x + w - 1, y + h - 1);
+    ILI9341_TransmitCmmd(ILI9341_RAMWR);
+
+    for (uint16_t row = 0; row < h; row++)
+    {
+        uint16_t col = 0;
+        while (col < header.width)
+        {
+            int16_t token = reader.read();
+            if (token < 0)
+            {
+                file.close();
+                return false;
+            }
+            uint8_t n;
+            uint8_t offset = 0;
+            if ((token & OP_MASK) == OP_COPY)
+            {
+                n = (token & 0x3F) + 2;
+                offset = reader.read() + 1;
+            }
+            else if (token & OP_RUN)
+            {
+                n = (token & 0x3F) + 1;
+            }
+            else
+            {
+                n = token + 1;
+            }
+            bool run = (token & OP_MASK) == OP_RUN;
+            if (n > header.width - col || offset > col || (run && col == 0))
+            {
+                DEBUG("Corrupt LZ565 row\n");
+                file.close();
+                return false;
+            }
+
+            uint8_t pos = col % RING;
+            if (run)
+            {
+                uint8_t prev = (col - 1) % RING;
+                uint8_t hi = ring[2 * prev];
+                uint8_t lo = ring[2 * prev + 1];
+                if (col < w)
+                    ILI9341_PushColor565(hi << 8 | lo, col + n > w ? w - col : n);
+                for (uint8_t i = 0; i < n; i++)
+                {
+                    uint8_t p = (pos + i) % RING;
+                    ring[2 * p] = hi;
+                    ring[2 * p + 1] = lo;
+                }
+                col += n;
+                continue;
+            }
+            if (offset)
+            {
+                // Pixel by pixel, a copy may overlap the pixels it makes
+                for (uint8_t i = 0; i < n; i++)
+                {
+                    uint8_t to = (pos + i) % RING;
+                    uint8_t from = (uint8_t) (pos + i - offset) % RING;
+                    ring[2 * to] = ring[2 * from];
+                    ring[2 * to + 1] = ring[2 * from + 1];
+                }
+            }
+            else
+            {
+                uint8_t first = n < RING - pos ? n : RING - pos;
+                reader.read(ring + 2 * pos, 2 * first);
+                reader.read(ring, 2 * (n - first));
+            }
+
+            // The pixels in view, in one piece or two if they wrap around the ring
+            if (col < w)
+            {
+                uint8_t visible = col + n > w ? w - col : n;
+                uint8_t first = visible < RING - pos ? visible : RING - pos;
+                ILI9341_PushPixels565BE(ring + 2 * pos, first);
+                if (visible > first)
+                    ILI9341_PushPixels565BE(ring, visible - first);
+            }
+            col += n;
+        }
+        Slide::reveal(row + 1);
+    }
+
+    file.close();
+    return !reader.failed();
+}
@@ -4,16 +4,28 @@
  *
  * This file contains the implementation of the PhotoAlbum class, which represents a photo album
  * application. It includes functions for initializing the album, listening for user input, drawing
- * images on the display, and handling BMP files.
+ * images on the display, and handling image files.
  */
+#include <Bmp.h>
+#include <Jpeg.h>
+#include <Lz565.h>
 #include <PhotoAlbum.h>
+#include <Qoi.h>
+#include <Resume.h>
 #include <SPI.h>
+#include <Scheduler.h>
+#include <Slide.h>
+#include <Stack.h>
+#include <StreamReader.h>
+#include <Tiles.h>
+#include <Workspace.h>
+#include <avr/pgmspace.h>
 #include <stdlib.h>
 extern "C"
 {
 #include <ili9341.h>
 }
-#if defined(DEBUG_SERIAL)
+#if defined(DEBUG_SERIAL) || defined(VIDEO_REPORT) || defined(STACK_REPORT)
 #include <serial.h>
 #endif
 /**
@@ -30,7 +42,28 @@ PhotoAlbum::PhotoAlbum()
       root_dir(&fs),
       current_file(&fs),
       image_changed(false),
-      imgFolder(&fs)
+      imgFolder(&fs),
+      header_ready(false),
+      held_button(0xFF),
+      press_time(0),
+      long_press(false),
+      slideshow(false),
+      slide_time(0),
+      next_image(&fs),
+      next_ready(false),
+      next_header_ready(false),
+      zoom(0),
+      view_tiled(false),
+      thumbs(&fs),
+      grid(false),
+      grid_cursor(0),
+      grid_filled(0),
+      grid_missing(0),
+      grid_covered(false)
+#if defined(IMAGE_CACHE_KB)
+      ,
+      cache(&fs)
+#endif
 {
 }
 
@@ -42,28 +75,84 @@ PhotoAlbum::~PhotoAlbum()
  * @brief Initializes the PhotoAlbum object.
  * @details This function performs the necessary initialization steps for the PhotoAlbum object,
  * including initializing the SD card, mounting the FAT filesystem, opening the filesystem root,
- * and initializing the image folder.
+ * and initializing the image folder. The images are counted later, by background_task().
+ *
+ * The SD card and the display are brought up together: the display init sequence is run step by
+ * step and while it waits on its reset and sleep-out delays the card is polled with ACMD41. As soon
+ * as the card is ready the filesystem is mounted, usually still within the display's delays. Boot
+ * therefore takes about as long as the slower of the two devices.
+ *
+ * If the last viewed image could be reopened from EEPROM it is shown right away instead of the
+ * title screen.
  */
 void PhotoAlbum::init()
 {
 #if defined(DEBUG_SERIAL)
     uart_init();
+#elif defined(VIDEO_REPORT) || defined(STACK_REPORT)
+    // the reports write to the UART directly, so stdio and its heap FILEs stay out
+    uart_init_tx();
 #endif
     DEBUG("Initializing SD card...\n");
-    if (disk.init())
+    bool card_busy = disk.init_start();
+    if (!card_busy)
+    {
+        DEBUG("Card initialization failed.\n");
+    }
+
+    bool lcd_busy = true;
+    uint16_t lcd_delay = 0;
+    uint32_t lcd_step_time = Millis::get();
+    while (lcd_busy || card_busy)
     {
-        DEBUG("Card connected!\n");
+        if (lcd_busy && Millis::get() - lcd_step_time > lcd_delay)
+        {
+            lcd_busy = ILI9341_InitStep(&lcd_delay);
+            lcd_step_time = Millis::get();
+        }
+        else if (card_busy)
+        {
+            SDCard::InitStatus status = disk.init_poll();
+            if (status == SDCard::InitStatus::READY)
+            {
+                DEBUG("Card connected!\n");
+                SPI::set_speed();
+                mount_filesystem();
+            }
+            else if (status == SDCard::InitStatus::FAILED)
+            {
+                DEBUG("Card initialization failed.\n");
+            }
+            card_busy = status == SDCard::InitStatus::BUSY;
+        }
+    }
+    ILI9341_ClearScreen(ILI9341_BLACK);
+
+    IMG_CTRL_DDR &= ~IMG_CTRL_MASK;
+    IMG_CTRL_PORT |= IMG_CTRL_MASK;
+
+    if (imgFolder.get_index() >= 0)
+    {
+        draw_image();
     }
     else
     {
-        DEBUG("Card initialization failed.\n");
+        draw_title_screen();
     }
-    SPI::set_speed();
+}
 
-    /* Display specific code */
-    ILI9341_Init();
-    ILI9341_ClearScreen(ILI9341_BLACK);
-    /* ********************* */
+/**
+ * @brief Mounts the FAT filesystem and opens the image folder.
+ *
+ * @details Called during boot as soon as the SD card is ready. A warm start from EEPROM is tried
+ * first, see resume().
+ */
+void PhotoAlbum::mount_filesystem()
+{
+    if (resume())
+    {
+        return;
+    }
 
     DEBUG("\nMounting FAT Filesystem...\n");
     if (fs.mount())
@@ -85,25 +174,305 @@ void PhotoAlbum::init()
         DEBUG("Unable to open root\n");
     }
 
-    IMG_CTRL_DDR &= ~(_BV(IMG_NEXT) | _BV(IMG_PREV));
-    IMG_CTRL_PORT |= _BV(IMG_NEXT) | _BV(IMG_PREV);
-
     imgFolder.init(root_dir, "img");
-    draw_title_screen();
+}
+
+/**
+ * @brief Reopens the last viewed image saved in EEPROM.
+ *
+ * @details The saved volume geometry is checked against a single boot sector read. If it matches,
+ * the image folder and the image are opened directly by cluster and directory entry, without
+ * reading the MBR or searching any directory.
+ *
+ * @return True if the last image is open in `current_file`, false if a normal mount is needed.
+ */
+bool PhotoAlbum::resume()
+{
+    ResumeData saved;
+    if (!Resume::load(saved))
+    {
+        return false;
+    }
+
+    DEBUG("\nResuming last image...\n");
+    if (fs.mount(&saved.volume) && root_dir.open_root() &&
+        imgFolder.resume(saved.folder_cluster, saved.index, saved.entry, current_file))
+    {
+        DEBUG("Resumed!\n");
+        return true;
+    }
+    root_dir.close();
+    DEBUG("Card changed.\n");
+    return false;
+}
+
+/**
+ * @brief Saves the currently shown image to EEPROM.
+ */
+void PhotoAlbum::save_position()
+{
+    ResumeData data;
+    fs.get_volume(&data.volume);
+    data.folder_cluster = imgFolder.get_folder_cluster();
+    data.index = imgFolder.get_index();
+    data.entry = imgFolder.get_entry();
+    Resume::save(data);
+}
+
+/**
+ * @brief Adds the tasks of the album to the Scheduler.
+ *
+ * @details Called after init(). The tasks run in this order: input_task() polls the joystick,
+ * slideshow_task() moves on to the next slide, draw_task() draws a changed image or the next frame
+ * of an animation or a video, and background_task() prefetches the next slide, makes thumbnails
+ * and counts the image folder. A changed image is therefore drawn right after the poll that
+ * changed it.
+ */
+void PhotoAlbum::start_tasks()
+{
+    Scheduler::add(input_task, this);
+    Scheduler::add(slideshow_task, this);
+    Scheduler::add(draw_task, this);
+    Scheduler::add(background_task, this);
+}
+
+/**
+ * @brief Task that polls the joystick every INPUT_POLL_MS, see listen_for_input().
+ *
+ * @param album The PhotoAlbum object.
+ * @param task The state of the task.
+ * @return True, the task never ends.
+ */
+bool PhotoAlbum::input_task(void* album, Task& task)
+{
+    PhotoAlbum* self = (PhotoAlbum*) album;
+    TASK_BEGIN(task);
+    while (true)
+    {
+        self->listen_for_input();
+        TASK_SLEEP(task, INPUT_POLL_MS);
+    }
+    TASK_END(task);
+}
+
+/**
+ * @brief Task that shows the next image every SLIDESHOW_INTERVAL_MS in slideshow mode.
+ *
+ * @details No slide is shown while an image is zoomed, the grid is shown or a changed image waits
+ * to be drawn. The task sleeps until the next slide is due, or for INPUT_POLL_MS while the
+ * slideshow is stopped or a slide is held back, since `slide_time` does not move then. A button
+ * press or a toggle of the slideshow moves `slide_time`, so the task checks the time again when it
+ * wakes.
+ *
+ * @param album The PhotoAlbum object.
+ * @param task The state of the task.
+ * @return True, the task never ends.
+ */
+bool PhotoAlbum::slideshow_task(void* album, Task& task)
+{
+    PhotoAlbum* self = (PhotoAlbum*) album;
+    TASK_BEGIN(task);
+    while (true)
+    {
+        if (self->slideshow && !self->zoom && !self->grid && !self->image_changed &&
+            Millis::get() - self->slide_time >= SLIDESHOW_INTERVAL_MS)
+        {
+            // keep the pace unless a slide took longer than the interval
+            self->slide_time += SLIDESHOW_INTERVAL_MS;
+            if (Millis::get() - self->slide_time >= SLIDESHOW_INTERVAL_MS)
+            {
+                self->slide_time = Millis::get();
+            }
+            self->image_changed = self->show_next();
+        }
+        if (self->slideshow && !self->zoom && !self->grid && !self->image_changed)
+        {
+            TASK_SLEEP_UNTIL(task, self->slide_time + SLIDESHOW_INTERVAL_MS);
+        }
+        else
+        {
+            TASK_SLEEP(task, INPUT_POLL_MS);
+        }
+    }
+    TASK_END(task);
+}
+
+/**
+ * @brief Task that draws the display.
+ *
+ * @details If the image has changed, it is redrawn on the display. Its position is saved to EEPROM
+ * unless the slideshow is running, since the cells only last about 100k writes and a slide is shown
+ * every SLIDESHOW_INTERVAL_MS. The slideshow saves the position when it stops. With STACK_REPORT
+ * the unused stack is reported after every image, see Stack. Otherwise the next frame of an
+ * animated GIF or a video is drawn when it is due. The task yields after every image or frame, so a
+ * long animation does not hold up the joystick.
+ *
+ * @param album The PhotoAlbum object.
+ * @param task The state of the task.
+ * @return True, the task never ends.
+ */
+bool PhotoAlbum::draw_task(void* album, Task& task)
+{
+    PhotoAlbum* self = (PhotoAlbum*) album;
+    TASK_BEGIN(task);
+    while (true)
+    {
+        TASK_WAIT_UNTIL(task, self->image_changed || self->animation.frame_due() ||
+                                  self->video.frame_due());
+        if (self->image_changed)
+        {
+            if (!self->slideshow)
+            {
+                self->save_position();
+            }
+            self->draw_image();
+            self->image_changed = false;
+#if defined(STACK_REPORT)
+            Stack::report();
+#endif
+        }
+        else if (self->animation.frame_due())
+        {
+            self->animation.draw_frame();
+        }
+        else
+        {
+            self->video.draw_frame();
+        }
+        TASK_YIELD(task);
+    }
+    TASK_END(task);
+}
+
+/**
+ * @brief Task that prefetches the next slide, makes thumbnails and counts the image folder.
+ *
+ * @details All of it is left alone while a changed image waits to be drawn. While the grid is shown
+ * the thumbnails its page misses are made one at a time, and if one of them had to be made in the
+ * image area the page is drawn again once they are done. The folder is counted a slice at a time.
+ * Between thumbnails and slices the task yields once its budget is used up and goes on with the
+ * next one the next time it runs, so the joystick is polled while they are made. Once there is
+ * nothing to do the task checks again every INPUT_POLL_MS.
+ *
+ * @param album The PhotoAlbum object.
+ * @param task The state of the task.
+ * @return True, the task never ends.
+ */
+bool PhotoAlbum::background_task(void* album, Task& task)
+{
+    PhotoAlbum* self = (PhotoAlbum*) album;
+    TASK_BEGIN(task);
+    while (true)
+    {
+        if (self->image_changed)
+        {
+            TASK_YIELD(task);
+            continue;
+        }
+        if (self->slideshow && !self->grid && !self->zoom && !self->next_ready)
+        {
+            self->prefetch_next();
+            TASK_YIELD_IF_EXPIRED(task);
+        }
+        if (self->grid && self->grid_missing)
+        {
+            while (self->grid && self->grid_missing)
+            {
+                self->make_thumbnail();
+                TASK_YIELD_IF_EXPIRED(task);
+            }
+            if (self->grid && self->grid_covered)
+            {
+                // thumbnails that could not be made are left black rather than tried again
+                self->draw_grid_page();
+            }
+        }
+        while (self->imgFolder.is_counting() && !self->image_changed)
+        {
+            if (!self->imgFolder.count_step())
+            {
+                self->draw_image_count();
+            }
+            TASK_YIELD_IF_EXPIRED(task);
+        }
+        TASK_SLEEP(task, INPUT_POLL_MS);
+    }
+    TASK_END(task);
 }
 
 /**
  * @brief Listens for input from buttons and performs actions accordingly.
  *
- * @details If the next image button is pressed, it attempts to open the next file in the image
- * folder. If the previous image button is pressed, it attempts to open the previous file in the
- * image folder. If the image has changed, it redraws the image on the display.
+ * @details A button press is handled when the button is released. If it was held for at least
+ * LONG_PRESS_MS the slideshow is toggled instead, as soon as the time has passed. A short press of
+ * the next image button opens the next file in the image folder, a short press of the previous
+ * image button opens the previous file. A push of the joystick changes the zoom level, see
+ * zoom_step(). While an image is zoomed the joystick directions move the view instead, at once and
+ * then every PAN_REPEAT_MS while the joystick is held, see pan(). Up opens the thumbnail grid,
+ * where the joystick moves the cursor the same way and a push opens the selected image, see
+ * grid_move().
+ *
+ * A new image is only opened here and `image_changed` set, draw_task() draws it.
  */
 void PhotoAlbum::listen_for_input()
 {
-    if (button_pressed(IMG_NEXT))
+    static const uint8_t buttons[] = {IMG_NEXT, IMG_PREV, IMG_UP, IMG_DOWN, IMG_ZOOM};
+    uint8_t pressed = 0xFF;
+    for (uint8_t i = 0; i < sizeof(buttons); i++)
     {
-        if (!imgFolder.next_file(current_file))
+        if (button_pressed(buttons[i]))
+        {
+            pressed = buttons[i];
+            break;
+        }
+    }
+
+    uint32_t now = Millis::get();
+    if (pressed != held_button)
+    {
+        if (held_button != 0xFF && !long_press)
+        {
+            button_action(held_button);
+        }
+        held_button = pressed;
+        press_time = now;
+        long_press = false;
+        if ((zoom || grid) && pressed != 0xFF && pressed != IMG_ZOOM)
+        {
+            // handled on press, nothing is left to do on release
+            long_press = true;
+            if (grid)
+                grid_move(pressed);
+            else
+                pan(pressed);
+        }
+    }
+    else if (held_button != 0xFF && !long_press && now - press_time >= LONG_PRESS_MS)
+    {
+        long_press = true;
+        toggle_slideshow();
+    }
+    else if ((zoom || grid) && held_button != 0xFF && held_button != IMG_ZOOM &&
+             now - press_time >= PAN_REPEAT_MS)
+    {
+        press_time = now;
+        if (grid)
+            grid_move(held_button);
+        else
+            pan(held_button);
+    }
+}
+
+/**
+ * @brief Performs the action of a short button press.
+ *
+ * @param button_pin The pin number of the released button.
+ */
+void PhotoAlbum::button_action(uint8_t button_pin)
+{
+    if (button_pin == IMG_NEXT)
+    {
+        if (!show_next())
         {
             DEBUG("Unable to open next file\n");
         }
@@ -112,9 +481,11 @@ void PhotoAlbum::listen_for_input()
             image_changed = true;
         }
     }
-
-    if (button_pressed(IMG_PREV))
+    else if (button_pin == IMG_PREV)
     {
+        animation.stop();
+        video.stop();
+        discard_prefetch();
         if (!imgFolder.prev_file(current_file))
         {
             DEBUG("Unable to open prev file\n");
@@ -124,266 +495,877 @@ void PhotoAlbum::listen_for_input()
             image_changed = true;
         }
     }
-    if (image_changed)
+    else if (button_pin == IMG_ZOOM)
     {
-        draw_image();
-        image_changed = false;
+        if (grid)
+            grid_open();
+        else
+            zoom_step();
     }
+    else if (button_pin == IMG_UP)
+    {
+        show_grid();
+    }
+    // a manual change restarts the slide interval
+    slide_time = Millis::get();
 }
 
 /**
- * @brief Draws the title screen of the photo album.
+ * @brief Starts or stops the slideshow.
  *
- * @details This function sets the position on the display and draws various strings to create the
- * title screen of the photo album. It displays the album title, the number of images found, and the
- * controls for navigating through the album.
+ * @details Starting the slideshow from the title screen shows the first image at once. Stopping it
+ * saves the position of the image shown, which is not saved for every slide. The bottom UI bar
+ * shows whether the slideshow is running.
+ */
+void PhotoAlbum::toggle_slideshow()
+{
+    slideshow = !slideshow;
+    slide_time = Millis::get();
+    if (!slideshow)
+    {
+        discard_prefetch();
+        if (imgFolder.get_index() >= 0)
+        {
+            save_position();
+        }
+    }
+    if (imgFolder.get_index() < 0 && !grid)
+    {
+        if (slideshow)
+        {
+            image_changed = show_next();
+        }
+        return;
+    }
+    draw_ui();
+}
+
+/// Rows of the image area, the scrolling area of the display.
+static const uint16_t AREA_ROWS = Slide::AREA_BOTTOM - Slide::AREA_TOP;
+
+/**
+ * @brief Limits a position of the zoomed view to the image.
  *
- * @note This function assumes that the display has been initialized and is ready for drawing.
+ * @param pos The position of the view.
+ * @param size The size of the zoomed image.
+ * @param area The size of the image area.
+ * @return The position, so that the view stays inside the image.
  */
-void PhotoAlbum::draw_title_screen()
+static uint16_t view_clamp(int32_t pos, uint32_t size, uint16_t area)
 {
-    ILI9341_SetPosition(55, 94);
-    ILI9341_DrawString("URS Fotoalbum", ILI9341_WHITE, ILI9341_Sizes::X3);
-    ILI9341_SetPosition(70, 134);
-    ILI9341_DrawString("Images found: ", ILI9341_WHITE, ILI9341_Sizes::X1);
-    char buffer[3];
-    itoa(imgFolder.get_image_count(), buffer, 10);
-    ILI9341_DrawString(buffer, ILI9341_WHITE, ILI9341_Sizes::X1);
-    ILI9341_SetPosition(70, 154);
-    ILI9341_DrawString("Controls: ", ILI9341_WHITE, ILI9341_Sizes::X1);
-    ILI9341_SetPosition(75, 164);
-    ILI9341_DrawString("--> Next", ILI9341_WHITE, ILI9341_Sizes::X1);
-    ILI9341_SetPosition(75, 174);
-    ILI9341_DrawString("<-- Prev", ILI9341_WHITE, ILI9341_Sizes::X1);
-    ILI9341_SetPosition(70, 204);
-    ILI9341_DrawString("Press --> to start", ILI9341_WHITE, ILI9341_Sizes::X1);
+    int32_t max = size > area ? size - area : 0;
+    if (pos > max)
+        pos = max;
+    if (pos < 0)
+        pos = 0;
+    return pos;
 }
 
 /**
- * @brief Draws an image on the screen.
+ * @brief Moves to the next zoom level of the current image.
  *
- * @details This function clears the screen, draws the user interface, and then draws the specified
- * image.
+ * @details Uncompressed BMP images that are larger than the image area can be shown 1:1, 1:2 and
+ * 1:4, that is one display pixel for every source pixel or for every 2x2 or 4x4 block. Levels at
+ * which the whole image would fit the area are skipped, and after the last level the fitted image
+ * is drawn again. The first level is centred on the image, later ones keep the source pixel in the
+ * centre of the view. Tiled images are zoomed the same way, through the levels the file has.
+ *
+ * The file stays open while the image is zoomed. The view is drawn into the scrolling area of the
+ * display, so that moving it up or down only draws the rows that come into view, see pan().
  */
-void PhotoAlbum::draw_image()
+void PhotoAlbum::zoom_step()
 {
-    ILI9341_ClearScreen(ILI9341_BLACK);
+    uint32_t cx, cy; // Centre of the view in source pixels
+    if (!zoom)
+    {
+        if (imgFolder.get_index() < 0 || animation.is_playing() || video.is_playing())
+        {
+            return;
+        }
+        if (!current_file.is_open() && !imgFolder.reopen_current(current_file))
+        {
+            return;
+        }
+        // the header of a prefetched slide would be overwritten
+        discard_prefetch();
+        // a colour table kept by an earlier view belongs to another image
+        Workspace::release();
+        current_file.seek(0);
+        view_tiled = Tiles::parse_header(current_file, tiles_header);
+        if (!view_tiled &&
+            (!current_file.seek(0) || !Bmp::parse_header(current_file, current_header) ||
+             current_header.compression == BI_RLE8 || current_header.compression == BI_RLE4))
+        {
+            current_file.close();
+            return;
+        }
+        zoomed_size(0, cx, cy);
+        cx /= 2;
+        cy /= 2;
+    }
+    else
+    {
+        uint8_t shift = zoom - 1;
+        cx = ((uint32_t) view_x << shift) + (TFT_WIDTH << shift) / 2;
+        cy = ((uint32_t) view_y << shift) + (AREA_ROWS << shift) / 2;
+    }
+
+    uint8_t shift = zoom;
+    uint32_t width, height;
+    zoomed_size(shift, width, height);
+    if (zoom == 3 || (view_tiled && zoom == tiles_header.levels) ||
+        (width <= TFT_WIDTH && height <= AREA_ROWS))
+    {
+        if (zoom)
+        {
+            // back to the fitted image, drawn by draw_task()
+            zoom = 0;
+            ILI9341_SetScrollStart(Slide::AREA_TOP);
+            if (view_tiled)
+            {
+                current_file.seek(0);
+            }
+            else
+            {
+                current_file.seek(Bmp::first_row_position(current_header));
+                header_ready = true;
+            }
+            image_changed = true;
+        }
+        else
+        {
+            current_file.close();
+        }
+        return;
+    }
+
+    zoom++;
+    view_x = view_clamp((int32_t) (cx >> shift) - TFT_WIDTH / 2, width, TFT_WIDTH);
+    view_y = view_clamp((int32_t) (cy >> shift) - AREA_ROWS / 2, height, AREA_ROWS);
+    view_scroll = 0;
+    ILI9341_SetScrollArea(Slide::AREA_TOP, TFT_HEIGHT - Slide::AREA_BOTTOM);
+    ILI9341_SetScrollStart(Slide::AREA_TOP);
+    draw_view(0, AREA_ROWS);
     draw_ui();
-    bmp_draw(current_file, 0, 10);
 }
 
 /**
- * @brief Draws the user interface for the photo album.
+ * @brief Moves the zoomed view by PAN_STEP display pixels.
  *
- * @details This function draws the top and bottom UI bars for the photo album.
- * The top UI bar displays the current image name, the number of images in the folder,
- * and the size of the current image file.
- * The bottom UI bar displays the previous and next image buttons.
+ * @details A move up or down scrolls the display by the rows the view moved, and only those rows
+ * are drawn. The display scrolls the memory rows of the whole area, so a move to the left or right
+ * draws the whole view again.
+ *
+ * @param button_pin The joystick pin that gives the direction.
  */
-void PhotoAlbum::draw_ui()
+void PhotoAlbum::pan(uint8_t button_pin)
 {
-    // Top UI bar - Image name and size
-    // Name
-    char buffer[16];
-    imgFolder.get_current_file_name(buffer);
-    strcat(buffer, "  ");
-    ILI9341_SetPosition(10, 1);
-    ILI9341_DrawString(buffer, ILI9341_WHITE, ILI9341_Sizes::X1);
-    // Images in folder - x/y
-    ILI9341_SetPosition(110, 1);
-    itoa(imgFolder.get_index() + 1, buffer, 10);
-    strcat(buffer, "/");
-    itoa(imgFolder.get_image_count(), buffer + strlen(buffer), 10);
-    ILI9341_DrawString(buffer, ILI9341_WHITE, ILI9341_Sizes::X1);
-    // Size
-    ILI9341_SetPosition(180, 1);
-    itoa(current_file.get_file_size() >> 10, buffer, 10);
-    strcat(buffer, " KiB");
-    ILI9341_DrawString(buffer, ILI9341_WHITE, ILI9341_Sizes::X1);
-    // Bottom UI bar - Controls
-    // Prev
-    if (imgFolder.prev_available())
+    uint32_t width, height;
+    zoomed_size(zoom - 1, width, height);
+    int32_t x = view_x;
+    int32_t y = view_y;
+    if (button_pin == IMG_NEXT)
+        x += PAN_STEP;
+    else if (button_pin == IMG_PREV)
+        x -= PAN_STEP;
+    else if (button_pin == IMG_DOWN)
+        y += PAN_STEP;
+    else if (button_pin == IMG_UP)
+        y -= PAN_STEP;
+    x = view_clamp(x, width, TFT_WIDTH);
+    y = view_clamp(y, height, AREA_ROWS);
+
+    if (x != view_x)
     {
-        ILI9341_SetPosition(50, 311);
-        ILI9341_DrawString("<-- Prev", ILI9341_WHITE, ILI9341_Sizes::X1);
+        view_x = x;
+        draw_view(0, AREA_ROWS);
+        return;
     }
-    // Split
-    ILI9341_SetPosition(95, 311);
-    ILI9341_DrawString("   |   ", ILI9341_WHITE, ILI9341_Sizes::X1);
-    // Next
-    if (imgFolder.next_available())
+    int16_t d = y - view_y;
+    if (d == 0)
     {
-        ILI9341_DrawString("Next -->", ILI9341_WHITE, ILI9341_Sizes::X1);
+        return;
     }
-    else if (imgFolder.is_looping())
+    // The rows still in view stay where they are in memory, the rows that left are drawn over
+    view_y = y;
+    view_scroll = (view_scroll + AREA_ROWS + d) % AREA_ROWS;
+    ILI9341_SetScrollStart(Slide::AREA_TOP + view_scroll);
+    if (d > 0)
+        draw_view(AREA_ROWS - d, d);
+    else
+        draw_view(0, -d);
+}
+
+/**
+ * @brief Gets the size of the current image at a zoom level.
+ *
+ * @param shift The zoom level as a power of two, 0 for 1:1.
+ * @param width The width of the zoomed image.
+ * @param height The height of the zoomed image.
+ */
+void PhotoAlbum::zoomed_size(uint8_t shift, uint32_t& width, uint32_t& height) const
+{
+    if (view_tiled)
     {
-        ILI9341_DrawString("Start -->", ILI9341_WHITE, ILI9341_Sizes::X1);
+        width = Tiles::level_width(tiles_header, shift);
+        height = Tiles::level_height(tiles_header, shift);
+        return;
     }
+    int32_t h = current_header.height;
+    width = (uint32_t) current_header.width >> shift;
+    height = (uint32_t) (h < 0 ? -h : h) >> shift;
 }
 
 /**
- * @brief Checks if a button is pressed.
+ * @brief Draws rows of the zoomed view of the current image.
  *
- * @details This function checks the state of a button connected to a specific pin.
+ * @details Each row is drawn into the memory row that the scrolling area currently shows at its
+ * place. The rows are drawn in runs that are contiguous in display memory and lie either in the
+ * image or in the black above or below it. A zoomed image smaller than the area in one direction
+ * is centred in it with black around it. Each run of image rows is drawn by Tiles::draw_view(),
+ * from the level of the zoom, or by Bmp::draw_view(), which samples the source pixels.
  *
- * @param button_pin The pin number of the button.
- * @return true if the button is pressed, false otherwise.
+ * @param first The first row of the image area to draw.
+ * @param count The number of rows to draw.
  */
-bool PhotoAlbum::button_pressed(uint8_t button_pin)
+void PhotoAlbum::draw_view(uint16_t first, uint16_t count)
 {
-    return !(IMG_CTRL_PIN & _BV(button_pin));
+    uint32_t width, height;
+    zoomed_size(zoom - 1, width, height);
+    uint16_t w = width < TFT_WIDTH ? width : TFT_WIDTH;
+    uint16_t h = height < AREA_ROWS ? height : AREA_ROWS;
+    uint16_t left = (TFT_WIDTH - w) / 2;
+    uint16_t top = (AREA_ROWS - h) / 2;
+    uint16_t wrap = AREA_ROWS - view_scroll; // First row of the area at the top of memory
+
+    uint16_t end = first + count;
+    while (first < end)
+    {
+        uint16_t run_end = end;
+        if (first < wrap && wrap < run_end)
+            run_end = wrap;
+        if (first < top && top < run_end)
+            run_end = top;
+        if (first < top + h && top + h < run_end)
+            run_end = top + h;
+        uint16_t mem_row = Slide::AREA_TOP + (view_scroll + first) % AREA_ROWS;
+        uint16_t last_row = mem_row + run_end - first - 1;
+
+        if (first < top || first >= top + h)
+        {
+            ILI9341_FillWindow(0, mem_row, TFT_WIDTH - 1, last_row, ILI9341_BLACK);
+        }
+        else
+        {
+            if (left > 0)
+                ILI9341_FillWindow(0, mem_row, left - 1, last_row, ILI9341_BLACK);
+            if (left + w < TFT_WIDTH)
+                ILI9341_FillWindow(left + w, mem_row, TFT_WIDTH - 1, last_row, ILI9341_BLACK);
+            if (view_tiled)
+                Tiles::draw_view(current_file, tiles_header, zoom - 1, view_x,
+                                 view_y + first - top, left, mem_row, w, run_end - first);
+            else
+                Bmp::draw_view(current_file, current_header, zoom - 1, view_x,
+                               view_y + first - top, left, mem_row, w, run_end - first);
+        }
+        first = run_end;
+    }
 }
 
+/// Thumbnails per row of the grid.
+static const uint8_t GRID_COLUMNS = 4;
+/// Thumbnails per page of the grid, which fills the image area.
+static const uint8_t GRID_PAGE = GRID_COLUMNS * 5;
+/// Width and height of a grid cell, a thumbnail with room for the cursor left and right of it.
+static const uint8_t GRID_CELL = 60;
+
 /**
- * Parses the BMP header of a given file.
+ * @brief Shows the thumbnail grid with the current image selected.
  *
- * @param bmp_file The file to parse the BMP header from.
- * @param header The BMPHeader object to store the parsed header information.
- * @return True if the BMP header was successfully parsed, false otherwise.
+ * @details Anything that plays is stopped and the current file is closed, the grid uses it to make
+ * missing thumbnails. Those are made by background_task(), see make_thumbnail().
  */
-bool PhotoAlbum::parse_bmp_header(File& bmp_file, BMPHeader& header)
+void PhotoAlbum::show_grid()
 {
-    // BMP Signature
-    if (File::read16(bmp_file) != 0x4D42)
+    if (!thumbs.open(root_dir, imgFolder.get_folder_cluster()))
     {
-        return false;
+        DEBUG("Unable to open thumbnail cache\n");
+        return;
     }
+    animation.stop();
+    video.stop();
+    discard_prefetch();
+    current_file.close();
+    grid = true;
+    grid_cursor = imgFolder.get_index() < 0 ? 0 : imgFolder.get_index();
+    grid_missing = draw_grid_page();
+    draw_ui();
+}
 
-    // File size
-    File::read32(bmp_file);
+/**
+ * @brief Moves the cursor of the thumbnail grid.
+ *
+ * @details Next and previous move by one image, up and down by a row. Within a page only the
+ * cursor is drawn again, a move past the page draws the page it lands on.
+ *
+ * @param button_pin The joystick pin that gives the direction.
+ */
+void PhotoAlbum::grid_move(uint8_t button_pin)
+{
+    int16_t target = grid_cursor;
+    if (button_pin == IMG_NEXT)
+        target++;
+    else if (button_pin == IMG_PREV)
+        target--;
+    else if (button_pin == IMG_DOWN)
+        target += GRID_COLUMNS;
+    else if (button_pin == IMG_UP)
+        target -= GRID_COLUMNS;
+    if (!imgFolder.is_counting() && target >= imgFolder.get_image_count())
+        target = imgFolder.get_image_count() - 1;
+    if (target < 0 || target > INT8_MAX || target == grid_cursor)
+    {
+        return;
+    }
 
-    // Read & ignore creator bytes
-    File::read32(bmp_file);
+    uint8_t first = grid_cursor - grid_cursor % GRID_PAGE;
+    if (target >= first && target < first + GRID_PAGE)
+    {
+        if (target - first >= grid_filled)
+        {
+            return;
+        }
+        // a page covered by a thumbnail being made gets its cursor when it is drawn again
+        if (!grid_covered)
+            draw_grid_cursor(ILI9341_BLACK);
+        grid_cursor = target;
+        if (!grid_covered)
+            draw_grid_cursor(ILI9341_WHITE);
+    }
+    else
+    {
+        if (target > first && grid_filled < GRID_PAGE)
+        {
+            // there is no page after a page that is not full
+            return;
+        }
+        uint8_t previous = grid_cursor;
+        grid_cursor = target;
+        grid_missing = draw_grid_page();
+        if (grid_filled == 0)
+        {
+            // the folder ended with the page before, found while it is still counted
+            grid_cursor = previous;
+            grid_missing = draw_grid_page();
+        }
+    }
+    draw_ui();
+}
 
-    // Offset to start of image data
-    header.data_offset = File::read32(bmp_file);
+/**
+ * @brief Leaves the thumbnail grid and shows the selected image.
+ */
+void PhotoAlbum::grid_open()
+{
+    ThumbKey key;
+    uint16_t entry;
+    grid = false;
+    grid_missing = 0;
+    thumbs.close();
+    if ((imgFolder.list_start(grid_cursor) && imgFolder.list_next(entry, key.size, key.cluster) &&
+         imgFolder.go_to(grid_cursor, entry, current_file)) ||
+        (imgFolder.get_index() >= 0 && imgFolder.reopen_current(current_file)))
+    {
+        image_changed = true;
+        return;
+    }
+    ILI9341_ClearScreen(ILI9341_BLACK);
+    ui.invalidate();
+    draw_title_screen();
+}
 
-    // Header Size
-    File::read32(bmp_file);
+/**
+ * @brief Draws the page of the thumbnail grid that holds the cursor.
+ *
+ * @details The files of the page are listed from the directory and each thumbnail is drawn from
+ * the cache if its key matches the file. The cells of thumbnails the cache does not hold stay
+ * black. A page that is only partly filled keeps the cursor on its last thumbnail.
+ *
+ * @return One bit per thumbnail of the page, set for those the cache does not hold.
+ */
+uint32_t PhotoAlbum::draw_grid_page()
+{
+    uint8_t first = grid_cursor - grid_cursor % GRID_PAGE;
+    uint32_t missing = 0;
+    ThumbKey key;
+    uint16_t entry;
+    ILI9341_FillWindow(0, Slide::AREA_TOP, TFT_WIDTH - 1, Slide::AREA_BOTTOM - 1, ILI9341_BLACK);
+    grid_covered = false;
+    grid_filled = 0;
+    if (imgFolder.list_start(first))
+    {
+        for (; grid_filled < GRID_PAGE && imgFolder.list_next(entry, key.size, key.cluster);
+             grid_filled++)
+        {
+            uint16_t x = grid_filled % GRID_COLUMNS * GRID_CELL + (GRID_CELL - Thumbs::WIDTH) / 2;
+            uint16_t y = Slide::AREA_TOP + grid_filled / GRID_COLUMNS * GRID_CELL;
+            if (!thumbs.draw(first + grid_filled, key, x, y))
+            {
+                missing |= (uint32_t) 1 << grid_filled;
+            }
+        }
+    }
+    if (grid_filled > 0 && grid_cursor - first >= grid_filled)
+    {
+        grid_cursor = first + grid_filled - 1;
+    }
+    if (grid_filled > 0)
+    {
+        draw_grid_cursor(ILI9341_WHITE);
+    }
+    return missing;
+}
 
-    // Width
-    header.width = File::read32(bmp_file);
+/**
+ * @brief Makes the next thumbnail of the grid page that the cache does not hold.
+ *
+ * @details The first thumbnail left in `grid_missing` is taken off it. Its image is drawn at
+ * thumbnail size straight into its cell if the decoder can scale it that far, see
+ * thumbnail_draw(), and only the cell is read back, see Thumbs::store(). Otherwise it is drawn
+ * into the image area like draw_image() does, the first frame for a GIF or a video, and shrunk as
+ * it is read back. That covers the page until it is drawn again, see `grid_covered`. An image that
+ * cannot be opened is skipped.
+ */
+void PhotoAlbum::make_thumbnail()
+{
+    uint8_t first = grid_cursor - grid_cursor % GRID_PAGE;
+    uint8_t slot = 0;
+    while (!(grid_missing & ((uint32_t) 1 << slot)))
+    {
+        slot++;
+    }
+    grid_missing &= ~((uint32_t) 1 << slot);
+    ThumbKey key;
+    uint16_t entry;
+    if (!imgFolder.list_start(first + slot) || !imgFolder.list_next(entry, key.size, key.cluster) ||
+        !imgFolder.open_entry(entry, current_file))
+    {
+        return;
+    }
+    uint8_t x = slot % GRID_COLUMNS * GRID_CELL + (GRID_CELL - Thumbs::WIDTH) / 2;
+    uint8_t y = Slide::AREA_TOP + slot / GRID_COLUMNS * GRID_CELL;
+    ILI9341_FillWindow(x, y, x + Thumbs::WIDTH - 1, y + Thumbs::HEIGHT - 1, ILI9341_BLACK);
+    if (thumbnail_draw(current_file, x, y))
+    {
+        thumbs.store(first + slot, key, x, y, 1);
+        return;
+    }
 
-    // Height
-    header.height = File::read32(bmp_file);
+    // the decoder may have closed the file
+    if (!current_file.is_open() && !imgFolder.open_entry(entry, current_file))
+    {
+        return;
+    }
+    grid_covered = true;
+    ILI9341_FillWindow(0, Slide::AREA_TOP, TFT_WIDTH - 1, Slide::AREA_BOTTOM - 1, ILI9341_BLACK);
+    current_file.seek(0);
+    if (animation.start(current_file, 0, 10))
+    {
+        animation.draw_frame();
+        animation.stop();
+    }
+    else if (current_file.seek(0) && video.start(current_file, 0, 10))
+    {
+        video.draw_frame();
+        video.stop();
+    }
+    else
+    {
+        current_file.seek(0);
+        image_draw(current_file, 0, 10);
+    }
+    current_file.close();
+    thumbs.store(first + slot, key, 0, Slide::AREA_TOP, Thumbs::SCALE);
+}
 
-    // Number of planes - must be 1
-    if (File::read16(bmp_file) != 1)
+/**
+ * @brief Draws an image at thumbnail size, if its decoder can scale it that far.
+ *
+ * @details JPEG images are decoded at down to 1/8, tiled images are drawn from the largest level
+ * that fits, and with BMP_FIT BMP images are scaled to fit, each centred in the Thumbs::WIDTH x
+ * Thumbs::HEIGHT rectangle. Landscape BMP images are not turned, unlike in the image area. Other
+ * formats and images that are still larger at the smallest scale are not drawn. The file may be
+ * closed either way.
+ *
+ * @param imgFile The File object representing the image file.
+ * @param x The x-coordinate of the top-left corner of the rectangle on the display.
+ * @param y The y-coordinate of the top-left corner of the rectangle on the display.
+ * @return True if the image was drawn, false otherwise.
+ */
+bool PhotoAlbum::thumbnail_draw(File& imgFile, uint8_t x, uint8_t y)
+{
+    imgFile.seek(0);
+    if (Jpeg::is_jpeg(imgFile))
     {
-        return false;
+        return Jpeg::draw_area(imgFile, x, y, Thumbs::WIDTH, Thumbs::HEIGHT, false);
+    }
+    imgFile.seek(0);
+    TilesHeader tiles_header;
+    if (Tiles::parse_header(imgFile, tiles_header))
+    {
+        uint8_t last = tiles_header.levels - 1;
+        return Tiles::level_width(tiles_header, last) <= Thumbs::WIDTH &&
+               Tiles::level_height(tiles_header, last) <= Thumbs::HEIGHT &&
+               Tiles::draw_area(imgFile, tiles_header, x, y, Thumbs::WIDTH, Thumbs::HEIGHT);
+    }
+#if defined(BMP_FIT)
+    imgFile.seek(0);
+    BMPHeader header;
+    if (Bmp::parse_header(imgFile, header))
+    {
+        return Bmp::draw_area(imgFile, header, x, y, Thumbs::WIDTH, Thumbs::HEIGHT);
     }
+#endif
+    return false;
+}
 
-    // Depth - Bits per pixel - only 24 supported
-    if (File::read16(bmp_file) != 24)
+/**
+ * @brief Draws or clears the cursor of the thumbnail grid.
+ *
+ * @details The cursor is a bar on each side of the selected thumbnail, in the margin of its cell.
+ *
+ * @param color The color of the bars, black to clear them.
+ */
+void PhotoAlbum::draw_grid_cursor(uint16_t color)
+{
+    uint8_t slot = grid_cursor % GRID_PAGE;
+    uint16_t x = slot % GRID_COLUMNS * GRID_CELL;
+    uint16_t y = Slide::AREA_TOP + slot / GRID_COLUMNS * GRID_CELL;
+    ILI9341_FillWindow(x + 1, y, x + 3, y + GRID_CELL - 1, color);
+    ILI9341_FillWindow(x + GRID_CELL - 4, y, x + GRID_CELL - 2, y + GRID_CELL - 1, color);
+}
+
+/**
+ * @brief Opens the next image file in `current_file`.
+ *
+ * @details If the next image has been prefetched it is used as is, including its parsed header,
+ * otherwise it is looked up in the image folder now.
+ *
+ * @return true if the next image file is open, false otherwise.
+ */
+bool PhotoAlbum::show_next()
+{
+    animation.stop();
+    video.stop();
+    if (!next_ready)
     {
-        return false;
+        header_ready = false;
+        return imgFolder.next_file(current_file);
     }
+    current_file = next_image;
+    // prefetch_next() parsed the header into current_header
+    header_ready = next_header_ready;
+    imgFolder.use_prefetched();
+    next_ready = false;
+    // current_file now owns the open file
+    next_image = File(&fs);
+    return true;
+}
 
-    // Compression - must be uncompressed (0)
-    if (File::read32(bmp_file) != 0)
+/**
+ * @brief Does the lookup work for the next slide while the current one is shown.
+ *
+ * @details The next file is opened, which resolves its directory entry and cluster run, its BMP
+ * header is parsed and the file is positioned on its first pixel row. The next transition then only
+ * has to stream pixels. The header is parsed into current_header, which the image shown no longer
+ * needs once it is drawn. Zooming parses the header of the image shown again into the same place,
+ * so it discards the prefetch and nothing is prefetched while zoomed.
+ */
+void PhotoAlbum::prefetch_next()
+{
+    if (imgFolder.get_index() < 0 || !imgFolder.prefetch_next(next_image))
     {
-        return false;
+        return;
+    }
+    next_ready = true;
+    next_header_ready = Bmp::parse_header(next_image, current_header);
+    if (next_header_ready)
+    {
+        next_image.seek(Bmp::first_row_position(current_header));
+    }
+    else
+    {
+        // not a BMP, image_draw works out the format
+        next_image.seek(0);
     }
+}
 
-    return true;
+/**
+ * @brief Closes the prefetched image file, if any.
+ */
+void PhotoAlbum::discard_prefetch()
+{
+    if (next_ready)
+    {
+        next_image.close();
+        next_ready = false;
+    }
 }
 
 /**
- * @brief Draws a BMP image on the display at the specified coordinates.
+ * @brief Draws the title screen of the photo album.
  *
- * @details This function reads a BMP file from the given File object and draws it on the display
- * starting from the specified coordinates (x, y). The image is cropped if it exceeds the
- * display boundaries. The BMP image is converted to the TFT format and each pixel is
- * drawn on the display.
+ * @details This function sets the position on the display and draws various strings to create the
+ * title screen of the photo album. It displays the album title, the number of images found, and the
+ * controls for navigating through the album. If the images are still being counted a placeholder is
+ * shown instead of the number, see draw_image_count().
  *
- * @param bmpFile The File object representing the BMP file.
- * @param x The x-coordinate of the top-left corner of the image on the display.
- * @param y The y-coordinate of the top-left corner of the image on the display.
+ * @note This function assumes that the display has been initialized and is ready for drawing.
  */
-void PhotoAlbum::bmp_draw(File& bmpFile, uint8_t x, uint8_t y)
+void PhotoAlbum::draw_title_screen()
 {
-    if ((x >= TFT_WIDTH) || (y >= TFT_HEIGHT))
+    ILI9341_SetPosition(55, 94);
+    ILI9341_DrawString_P(PSTR("URS Fotoalbum"), ILI9341_WHITE, ILI9341_Sizes::X3);
+    ILI9341_SetPosition(70, 134);
+    ILI9341_DrawString_P(PSTR("Images found: "), ILI9341_WHITE, ILI9341_Sizes::X1);
+    if (imgFolder.is_counting())
+    {
+        ILI9341_DrawString_P(PSTR("counting..."), ILI9341_WHITE, ILI9341_Sizes::X1);
+    }
+    else
+    {
+        char buffer[4];
+        itoa(imgFolder.get_image_count(), buffer, 10);
+        ILI9341_DrawString(buffer, ILI9341_WHITE, ILI9341_Sizes::X1);
+    }
+    ILI9341_SetPosition(70, 154);
+    ILI9341_DrawString_P(PSTR("Controls: "), ILI9341_WHITE, ILI9341_Sizes::X1);
+    ILI9341_SetPosition(75, 164);
+    ILI9341_DrawString_P(PSTR("--> Next"), ILI9341_WHITE, ILI9341_Sizes::X1);
+    ILI9341_SetPosition(75, 174);
+    ILI9341_DrawString_P(PSTR("<-- Prev"), ILI9341_WHITE, ILI9341_Sizes::X1);
+    ILI9341_SetPosition(75, 184);
+    ILI9341_DrawString_P(PSTR("Push: Zoom"), ILI9341_WHITE, ILI9341_Sizes::X1);
+    ILI9341_SetPosition(75, 194);
+    ILI9341_DrawString_P(PSTR("Up: Thumbnails"), ILI9341_WHITE, ILI9341_Sizes::X1);
+    ILI9341_SetPosition(70, 204);
+    ILI9341_DrawString_P(PSTR("Press --> to start"), ILI9341_WHITE, ILI9341_Sizes::X1);
+}
+
+/**
+ * @brief Shows the final image count once the image folder has been counted.
+ *
+ * @details On the title screen the "counting..." placeholder is replaced with the number. When an
+ * image is already shown the UI bars are updated, since the "x/y" counter and the next button
+ * depend on the count.
+ */
+void PhotoAlbum::draw_image_count()
+{
+    if (imgFolder.get_index() < 0 && !grid)
+    {
+        ILI9341_FillWindow(154, 134, TFT_WIDTH - 1, 141, ILI9341_BLACK);
+        ILI9341_SetPosition(154, 134);
+        char buffer[4];
+        itoa(imgFolder.get_image_count(), buffer, 10);
+        ILI9341_DrawString(buffer, ILI9341_WHITE, ILI9341_Sizes::X1);
         return;
+    }
+    draw_ui();
+}
 
-    BMPHeader header;
-    uint32_t rowSize;                    // Not always = bmpWidth; may have padding
-    uint8_t sdbuffer[3 * BUFFPIXEL];     // pixel buffer (R+G+B per pixel)
-    uint16_t buffidx = sizeof(sdbuffer); // Current position in sdbuffer
-    bool flip = true;                    // BMP is stored bottom-to-top
-    int w, h, row, col;
-    uint8_t r, g, b;
-    uint32_t pos = 0;
+/**
+ * @brief Draws an image on the screen.
+ *
+ * @details This function clears the screen, draws the user interface, and then draws the specified
+ * image. With SLIDE_TRANSITION the screen is not cleared, the changed UI fields are redrawn and the
+ * new image slides in over the old one if its decoder draws top to bottom, see Slide. A header
+ * parsed in advance by prefetch_next() is used instead of parsing it again. A GIF file is kept open
+ * and played by `animation`, a video file by `video`.
+ *
+ * With IMAGE_CACHE_KB a still image that was shown before is drawn from the image cache instead of
+ * its file, and one that was not is stored in the cache once it is drawn, see ImageCache. An image
+ * whose decoder stopped early is not stored, since the rows it did not draw are blank.
+ */
+void PhotoAlbum::draw_image()
+{
+#if defined(SLIDE_TRANSITION)
+    Slide::arm();
+#else
+    ILI9341_ClearScreen(ILI9341_BLACK);
+    ui.invalidate();
+#endif
+    draw_ui();
+#if defined(IMAGE_CACHE_KB)
+    CacheKey key;
+    ImageCache::make_key(current_file, key);
+    if (cache.draw(root_dir, key))
+    {
+        header_ready = false;
+        current_file.close();
+        Slide::end();
+        return;
+    }
+#endif
+    bool drawn = false;
+    if (header_ready)
+    {
+        header_ready = false;
+        drawn = Bmp::draw(current_file, current_header, 0, 10);
+    }
+    else if (animation.start(current_file, 0, 10))
+    {
+        // later frames are drawn by draw_task()
+        Slide::cancel();
+        animation.draw_frame();
+    }
+    else if (current_file.seek(0) && video.start(current_file, 0, 10))
+    {
+        Slide::cancel();
+        video.draw_frame();
+    }
+    else
+    {
+        current_file.seek(0);
+        drawn = image_draw(current_file, 0, 10);
+    }
+    Slide::end();
+#if defined(IMAGE_CACHE_KB)
+    if (drawn)
+    {
+        cache.store(root_dir, key);
+    }
+#endif
+}
 
-    if (!parse_bmp_header(bmpFile, header))
+/**
+ * @brief Draws an image file of any supported format.
+ *
+ * @details The format is recognised from the file contents rather than from the file name. The
+ * file is closed afterwards.
+ *
+ * @param imgFile The File object representing the image file, positioned at its start.
+ * @param x The x-coordinate of the top-left corner of the image area on the display.
+ * @param y The y-coordinate of the top-left corner of the image area on the display.
+ * @return True if the whole image was drawn, false if it is invalid, corrupt or could not be read.
+ */
+bool PhotoAlbum::image_draw(File& imgFile, uint8_t x, uint8_t y)
+{
+    QOIHeader qoi_header;
+    if (Qoi::parse_header(imgFile, qoi_header))
     {
-        DEBUG("Invalid BMP file\n");
+        DEBUG("Valid QOI file\n");
+        return Qoi::draw(imgFile, qoi_header, x, y);
+    }
+    imgFile.seek(0);
+    if (Jpeg::is_jpeg(imgFile))
+    {
+        DEBUG("Valid JPEG file\n");
+        return Jpeg::draw(imgFile, x, y);
+    }
+    imgFile.seek(0);
+    TilesHeader tiles_header;
+    if (Tiles::parse_header(imgFile, tiles_header))
+    {
+        DEBUG("Valid tiled image\n");
+        return Tiles::draw(imgFile, tiles_header, x, y);
+    }
+    imgFile.seek(0);
+    Lz565Header lz565_header;
+    if (Lz565::parse_header(imgFile, lz565_header))
+    {
+        DEBUG("Valid LZ565 file\n");
+        return Lz565::draw(imgFile, lz565_header, x, y);
+    }
+    imgFile.seek(0);
+    return Bmp::draw(imgFile, x, y);
+}
+
+/**
+ * @brief Draws the user interface for the photo album.
+ *
+ * @details This function updates the top and bottom UI bars for the photo album.
+ * The top UI bar displays the current image name, the number of images in the folder
+ * ("?" while still counting), and the size of the current image file.
+ * The bottom UI bar displays the previous and next image buttons and the slideshow state or the
+ * zoom level.
+ * In the thumbnail grid only the position of the cursor is shown, and that a push opens the image.
+ * Only the fields whose text changed are drawn, see UiBars.
+ */
+void PhotoAlbum::draw_ui()
+{
+    // Top UI bar - Image name and size
+    // Name
+    char buffer[16];
+    if (grid)
+    {
+        strcpy_P(buffer, PSTR("Thumbnails"));
+    }
+    else
+    {
+        imgFolder.get_current_file_name(buffer);
+    }
+    ui.set(UiBars::NAME, buffer);
+    // Images in folder - x/y
+    itoa((grid ? grid_cursor : imgFolder.get_index()) + 1, buffer, 10);
+    strcat(buffer, "/");
+    if (imgFolder.is_counting())
+    {
+        strcat(buffer, "?");
+    }
+    else
+    {
+        itoa(imgFolder.get_image_count(), buffer + strlen(buffer), 10);
+    }
+    ui.set(UiBars::POSITION, buffer);
+    if (grid)
+    {
+        ui.set(UiBars::SIZE, "");
+        ui.set(UiBars::PREV, "");
+        ui.set_P(UiBars::SPLIT, PSTR(" Open  "));
+        ui.set(UiBars::NEXT, "");
         return;
     }
-    DEBUG("Valid BMP file\n");
-
-    // BMP rows are padded (if needed) to 4-byte boundary
-    rowSize = (header.width * 3 + 3) & ~3;
-
-    // If bmpHeight is negative, image is in top-down order.
-    // This is not canon but has been observed in the wild.
-    if (header.height < 0)
-    {
-        header.height = -header.height;
-        flip = false;
-    }
-
-    // Crop area to be loaded
-    w = header.width;
-    h = header.height;
-    if ((x + w - 1) >= TFT_WIDTH)
-        w = TFT_WIDTH - x;
-    if ((y + h - 1) >= TFT_HEIGHT - 20)
-        h = TFT_HEIGHT - 10 - y;
-
-    // If the image is smaller than the screen
-    // center vertically and horizontally
-    x += (TFT_WIDTH - w) / 2;
-    y += (TFT_HEIGHT - 20 - h) / 2;
-
-    for (row = 0; row < h; row++)
-    { // For each scanline...
-
-        // Seek to start of scan line.  It might seem labor-
-        // intensive to be doing this on every line, but this
-        // method covers a lot of gritty details like cropping
-        // and scanline padding.  Also, the seek only takes
-        // place if the file position actually needs to change
-        // (avoids a lot of cluster math in SD library).
-        if (flip) // Bitmap is stored bottom-to-top order (normal BMP)
-            pos = header.data_offset + (header.height - 1 - row) * rowSize;
-        else // Bitmap is stored top-to-bottom
-            pos = header.data_offset + row * rowSize;
-        if (bmpFile.get_current_position() != pos)
-        { // Need seek?
-            bmpFile.seek(pos);
-            buffidx = sizeof(sdbuffer); // Force buffer reload
-        }
-
-        for (col = 0; col < w; col++)
-        { // For each pixel...
-            // Time to read more pixel data?
-            if (buffidx >= sizeof(sdbuffer))
-            { // Indeed
-                bmpFile.read(sdbuffer, sizeof(sdbuffer));
-                buffidx = 0; // Set index to beginning
-            }
+    // Size
+    itoa(current_file.get_file_size() >> 10, buffer, 10);
+    strcat_P(buffer, PSTR(" KiB"));
+    ui.set(UiBars::SIZE, buffer);
+    // Bottom UI bar - Controls
+    // Prev
+    ui.set_P(UiBars::PREV, imgFolder.prev_available() ? PSTR("<-- Prev") : PSTR(""));
+    // Split - shows the zoom level or a play mark while the slideshow runs
+    if (zoom)
+    {
+        static const char levels[][8] PROGMEM = {"  1:1  ", "  1:2  ", "  1:4  "};
+        ui.set_P(UiBars::SPLIT, levels[zoom - 1]);
+    }
+    else
+    {
+        ui.set_P(UiBars::SPLIT, slideshow ? PSTR("  |>|  ") : PSTR("   |   "));
+    }
+    // Next
+    if (imgFolder.next_available())
+    {
+        ui.set_P(UiBars::NEXT, PSTR("Next -->"));
+    }
+    else if (imgFolder.is_looping())
+    {
+        ui.set_P(UiBars::NEXT, PSTR("Start -->"));
+    }
+    else
+    {
+        ui.set(UiBars::NEXT, "");
+    }
+}
 
-            // Convert pixel from BMP to TFT format, push to display
-            b = sdbuffer[buffidx++];
-            g = sdbuffer[buffidx++];
-            r = sdbuffer[buffidx++];
-            uint16_t color565 = (r & 0xF8) << 8 | (g & 0xFC) << 3 | b >> 3;
-            ILI9341_DrawPixel(col + x, row + y, color565);
-        } // end pixel
-    }     // end scanline
-    // } // end goodBmp
-    //     }
-    // }
-
-    bmpFile.close();
+/**
+ * @brief Checks if a button is pressed.
+ *
+ * @details This function checks the state of a button connected to a specific pin.
+ *
+ * @param button_pin The pin number of the button.
+ * @return true if the button is pressed, false otherwise.
+ */
+bool PhotoAlbum::button_pressed(uint8_t button_pin)
+{
+    return !(IMG_CTRL_PIN & _BV(button_pin));
 }
@@ -0,0 +1,188 @@
+/**
+ * @file Qoi.cpp
+ * @brief Streaming decoder for QOI images.
+ *
+ * This file contains the implementation of the Qoi class, which decodes "Quite OK Image" files
+ * from the SD card and draws them on the display without buffering any part of the image.
+ */
+#include <Qoi.h>
+#include <Slide.h>
+#include <StreamReader.h>
+#include <Workspace.h>
+#include <config.h>
+extern "C"
+{
+#include <ili9341.h>
+}
+
+/**
+ * @brief Reads a big-endian 32-bit value.
+ *
+ * @param f The file to read from.
+ * @return The value read.
+ */
+static uint32_t read32_be(File& f)
+{
+    uint32_t result = 0;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        result = result << 8 | (uint8_t) f.read();
+    }
+    return result;
+}
+
+/**
+ * @brief Parses the header of a QOI file.
+ *
+ * @details The file must be positioned at its start. On success the file is left on the first data
+ * chunk.
+ *
+ * @param file The file to parse the header from.
+ * @param header The QOIHeader object to store the parsed header information.
+ * @return True if the file is a QOI image, false otherwise.
+ */
+bool Qoi::parse_header(File& file, QOIHeader& header)
+{
+    // Signature "qoif"
+    if (read32_be(file) != 0x716F6966)
+    {
+        return false;
+    }
+
+    header.width = read32_be(file);
+    header.height = read32_be(file);
+
+    // Channels - 3 or 4, alpha is ignored when drawing
+    uint8_t channels = file.read();
+    if (channels != 3 && channels != 4)
+    {
+        return false;
+    }
+
+    // Colour space - not used
+    file.read();
+
+    return header.width > 0 && header.height > 0;
+}
+
+/**
+ * @brief Draws a QOI image on the display at the specified coordinates.
+ *
+ * @details The data chunks are decoded in file order and every pixel is converted to RGB565 and
+ * pushed into a display window covering the visible part of the image. Runs are written with a
+ * single run-fill. Images larger than the 240x300 image area are cropped: pixels right of the area
+ * are decoded and discarded, and decoding stops after the last visible row. Smaller images are
+ * centered. A slide transition reveals every row as it is finished, see Slide. The file is read in
+ * sector sized chunks and closed afterwards.
+ *
+ * RAM use is the 512 byte read buffer plus the 256 byte colour index, both in the Workspace. The
+ * index keeps the alpha channel because it is part of the index hash.
+ *
+ * @param file The File object representing the QOI file, positioned after the header.
+ * @param header The parsed QOI header of the file.
+ * @param x The x-coordinate of the top-left corner of the image area on the display.
+ * @param y The y-coordinate of the top-left corner of the image area on the display.
+ * @return True if every visible row was drawn, false if the data ended early or could not be read.
+ */
+bool Qoi::draw(File& file, const QOIHeader& header, uint8_t x, uint8_t y)
+{
+    struct Buffers
+    {
+        uint8_t buffer[512];  // read buffer, one sector
+        uint8_t index[64][4]; // recently seen pixels as R, G, B, A
+    };
+    Buffers& buffers = Workspace::get<Buffers>();
+    uint8_t(*index)[4] = buffers.index;
+    uint8_t px[4] = {0, 0, 0, 255};
+    uint32_t row = 0, col = 0;
+    uint32_t w, h;
+    int16_t b1, b2;
+
+    memset(buffers.index, 0, sizeof(buffers.index));
+    StreamReader reader(file, buffers.buffer, sizeof(buffers.buffer));
+
+    // Crop area to be loaded
+    w = header.width;
+    h = header.height;
+    if (w > TFT_WIDTH)
+        w = TFT_WIDTH;
+    if (h > TFT_HEIGHT - 20)
+        h = TFT_HEIGHT - 20;
+
+    // If the image is smaller than the screen
+    // center vertically and horizontally
+    x += (TFT_WIDTH - w) / 2;
+    y += (TFT_HEIGHT - 20 - h) / 2;
+
+    Slide::begin(x, y, w, h);
+    ILI9341_SetWindow(x, y, x + w - 1, y + h - 1);
+    ILI9341_TransmitCmmd(ILI9341_RAMWR);
+
+    while (row < h)
+    {
+        uint8_t run = 1;
+        b1 = reader.read();
+        if (b1 < 0)
+            break;
+
+        if (b1 == OP_RGB)
+        {
+            px[0] = reader.read();
+            px[1] = reader.read();
+            px[2] = reader.read();
+        }
+        else if (b1 == OP_RGBA)
+        {
+            px[0] = reader.read();
+            px[1] = reader.read();
+            px[2] = reader.read();
+            px[3] = reader.read();
+        }
+        else if ((b1 & OP_MASK) == OP_INDEX)
+        {
+            memcpy(px, index[b1], 4);
+        }
+        else if ((b1 & OP_MASK) == OP_DIFF)
+        {
+            px[0] += ((b1 >> 4) & 0x03) - 2;
+            px[1] += ((b1 >> 2) & 0x03) - 2;
+            px[2] += (b1 & 0x03) - 2;
+        }
+        else if ((b1 & OP_MASK) == OP_LUMA)
+        {
+            b2 = reader.read();
+            int8_t vg = (b1 & 0x3F) - 32;
+            px[0] += vg - 8 + ((b2 >> 4) & 0x0F);
+            px[1] += vg;
+            px[2] += vg - 8 + (b2 & 0x0F);
+        }
+        else
+        {
+            run = (b1 & 0x3F) + 1;
+        }
+        memcpy(index[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) & 0x3F], px, 4);
+
+        uint16_t color565 = (px[0] & 0xF8) << 8 | (px[1] & 0xFC) << 3 | px[2] >> 3;
+
+        // A run may continue on the following rows
+        while (run > 0 && row < h)
+        {
+            uint32_t n = header.width - col;
+            if (n > run)
+                n = run;
+            if (col < w)
+                ILI9341_PushColor565(color565, col + n > w ? w - col : n);
+            col += n;
+            run -= n;
+            if (col == header.width)
+            {
+                col = 0;
+                row++;
+                Slide::reveal(row);
+            }
+        }
+    }
+
+    file.close();
+    return row == h && !reader.failed();
+}
@@ -0,0 +1,39 @@
+/**
+ * @file Resume.cpp
+ * @brief Last viewed image kept in EEPROM for a fast warm start.
+ *
+ * This file contains the implementation of the Resume class, which keeps a single ResumeData
+ * record in the EEPROM of the microcontroller.
+ */
+#include <Resume.h>
+#include <avr/eeprom.h>
+
+/** The record in EEPROM. */
+static ResumeData EEMEM resume_record;
+
+/**
+ * @brief Reads the record from EEPROM.
+ *
+ * @param data The structure to read the record into.
+ * @return True if a valid record was found, false otherwise (e.g. erased EEPROM).
+ */
+bool Resume::load(ResumeData& data)
+{
+    eeprom_read_block(&data, &resume_record, sizeof(ResumeData));
+    return data.magic == RESUME_MAGIC;
+}
+
+/**
+ * @brief Writes the record to EEPROM.
+ *
+ * @details Only the bytes that differ from the stored record are written, so saving after a
+ * manual image change usually costs a few bytes of EEPROM wear. The index and entry bytes still
+ * change with every image, so the album does not save every slide of a slideshow.
+ *
+ * @param data The record to store. Its magic field is set by this function.
+ */
+void Resume::save(ResumeData& data)
+{
+    data.magic = RESUME_MAGIC;
+    eeprom_update_block(&data, &resume_record, sizeof(ResumeData));
+}
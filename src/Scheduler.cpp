@@ -0,0 +1,111 @@
+/**
+ * @file Scheduler.cpp
+ * @brief Cooperative scheduler of stackless tasks, paced with Millis.
+ *
+ * This file contains the implementation of the Scheduler class, which runs the tasks of the album
+ * in turn and idles the CPU while none of them is due.
+ */
+#include <Scheduler.h>
+#include <avr/sleep.h>
+#include <config.h>
+#include <stddef.h>
+
+Task Scheduler::tasks[Scheduler::MAX_TASKS];
+uint32_t Scheduler::budget_end = 0;
+
+/**
+ * @brief Adds a task, which is first run by the next step().
+ *
+ * @param function The body of the task.
+ * @param context The pointer passed to the body.
+ * @return True if the task was added, false if every slot is taken.
+ */
+bool Scheduler::add(TaskFunction function, void* context)
+{
+    Millis::init();
+    for (uint8_t i = 0; i < MAX_TASKS; i++)
+    {
+        if (tasks[i].function == NULL)
+        {
+            tasks[i].function = function;
+            tasks[i].context = context;
+            tasks[i].line = 0;
+            tasks[i].wake = Millis::get();
+            return true;
+        }
+    }
+    DEBUG("No task slot left\n");
+    return false;
+}
+
+/**
+ * @brief Runs the tasks forever.
+ *
+ * @details The CPU is put in idle sleep whenever a step found no task due. Timer 2 keeps running in
+ * idle and its Millis interrupt wakes the CPU again, as do the other interrupts.
+ */
+void Scheduler::run()
+{
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    while (true)
+    {
+        if (!step())
+        {
+            sleep_mode();
+        }
+    }
+}
+
+/**
+ * @brief Runs every due task once, in the order they were added.
+ *
+ * @details Each task is given a budget of TASK_SLICE_MS before it runs. A task that ends is
+ * removed.
+ *
+ * @return True if a task was run, false if none was due.
+ */
+bool Scheduler::step()
+{
+    bool ran = false;
+    for (uint8_t i = 0; i < MAX_TASKS; i++)
+    {
+        Task& task = tasks[i];
+        if (task.function == NULL || (int32_t) (Millis::get() - task.wake) < 0)
+        {
+            continue;
+        }
+        ran = true;
+        start_budget(TASK_SLICE_MS);
+        if (!task.function(task.context, task))
+        {
+            task.function = NULL;
+        }
+    }
+    return ran;
+}
+
+/**
+ * @brief Starts a time budget for the running task.
+ *
+ * @details The scheduler starts a budget of TASK_SLICE_MS for every task it runs. A task may start
+ * a shorter or longer one for a part of its work.
+ *
+ * @param ms The budget in milliseconds.
+ */
+void Scheduler::start_budget(uint16_t ms)
+{
+    budget_end = Millis::get() + ms;
+}
+
+/**
+ * @brief Checks whether the budget of the running task is used up.
+ *
+ * @details A task that gets true back should yield at the next point where it can go on later, see
+ * TASK_YIELD_IF_EXPIRED().
+ *
+ * @return True once the budget is used up, false while time is left.
+ */
+bool Scheduler::budget_expired()
+{
+    return (int32_t) (Millis::get() - budget_end) >= 0;
+}
@@ -0,0 +1,126 @@
+/**
+ * @file Slide.cpp
+ * @brief Slide transition between images with hardware vertical scrolling.
+ *
+ * This file contains the implementation of the Slide class, which follows the rows drawn by a
+ * decoder with the vertical scrolling start address of the display.
+ */
+#include <Slide.h>
+#include <config.h>
+extern "C"
+{
+#include <ili9341.h>
+}
+
+bool Slide::armed = false;
+bool Slide::active = false;
+uint8_t Slide::image_x;
+uint16_t Slide::image_y;
+uint16_t Slide::image_w;
+uint16_t Slide::image_end;
+uint16_t Slide::next_row;
+
+/**
+ * @brief Lets the next image that is drawn slide in.
+ */
+void Slide::arm()
+{
+    armed = true;
+}
+
+/**
+ * @brief Starts sliding in an image.
+ *
+ * @details The scrolling area is set to the image area and the black rows above the image are
+ * revealed at once. The display window is left open on the image rectangle.
+ *
+ * @param x The x-coordinate of the top-left corner of the image on the display.
+ * @param y The y-coordinate of the top-left corner of the image on the display.
+ * @param w The width of the image on the display.
+ * @param h The height of the image on the display.
+ */
+void Slide::begin(uint8_t x, uint8_t y, uint16_t w, uint16_t h)
+{
+    if (!armed)
+    {
+        return;
+    }
+    armed = false;
+    active = true;
+    image_x = x;
+    image_y = y;
+    image_w = w;
+    image_end = y + h;
+    next_row = AREA_TOP;
+    ILI9341_SetScrollArea(AREA_TOP, TFT_HEIGHT - AREA_BOTTOM);
+    show(y);
+}
+
+/**
+ * @brief Finishes the transition once the image is drawn.
+ *
+ * @details The rows below the last one revealed are blanked and revealed, which also covers image
+ * rows a decoder did not get to because of an error. If no decoder started the transition, the
+ * image area is cleared like cancel() does.
+ */
+void Slide::end()
+{
+    if (!active)
+    {
+        cancel();
+        return;
+    }
+    image_end = next_row;
+    show(AREA_BOTTOM);
+    active = false;
+}
+
+/**
+ * @brief Drops an armed transition and clears the image area, for images that cannot slide in.
+ */
+void Slide::cancel()
+{
+    if (armed)
+    {
+        armed = false;
+        ILI9341_FillWindow(0, AREA_TOP, TFT_WIDTH - 1, AREA_BOTTOM - 1, ILI9341_BLACK);
+    }
+}
+
+/**
+ * @brief Reveals the display rows above a row.
+ *
+ * @details The part of every row outside the image is filled black, then the scroll start is set
+ * to the row. Setting the scroll start ends the memory write, so if the row is still inside the
+ * image the window is opened again on the rest of the image, and a decoder streaming into one
+ * window carries on where it stopped.
+ *
+ * @param row The first display row not to reveal.
+ */
+void Slide::show(uint16_t row)
+{
+    for (; next_row < row; next_row++)
+    {
+        if (next_row < image_y || next_row >= image_end)
+        {
+            ILI9341_FillWindow(0, next_row, TFT_WIDTH - 1, next_row, ILI9341_BLACK);
+            continue;
+        }
+        if (image_x > 0)
+        {
+            ILI9341_FillWindow(0, next_row, image_x - 1, next_row, ILI9341_BLACK);
+        }
+        if (image_x + image_w < TFT_WIDTH)
+        {
+            ILI9341_FillWindow(image_x + image_w, next_row, TFT_WIDTH - 1, next_row,
+                               ILI9341_BLACK);
+        }
+    }
+
+    ILI9341_SetScrollStart(row < AREA_BOTTOM ? row : AREA_TOP);
+    if (row >= image_y && row < image_end)
+    {
+        ILI9341_SetWindow(image_x, row, image_x + image_w - 1, image_end - 1);
+        ILI9341_TransmitCmmd(ILI9341_RAMWR);
+    }
+}
@@ -0,0 +1,61 @@
+/**
+ * @file Stack.cpp
+ * @brief Measurement of the RAM the stack has never reached.
+ *
+ * This file contains the implementation of the Stack class, which paints the free RAM at start-up
+ * and counts the bytes the stack has not overwritten since.
+ */
+#include <Stack.h>
+#include <avr/io.h>
+#include <config.h>
+#if defined(STACK_REPORT)
+#include <avr/pgmspace.h>
+#include <serial.h>
+#endif
+
+extern uint8_t __heap_start; ///< End of the static variables, from the linker script.
+
+/**
+ * @brief Fills the RAM from the end of the static variables up to RAMEND with Stack::PAINT.
+ *
+ * @details Runs from the .init3 section, after the stack pointer has been set and before the
+ * static variables are initialized and main() is called. Nothing is on the stack yet, so the whole
+ * of it can be painted. The function is naked and falls through to the next init section.
+ */
+static void __attribute__((naked, used, section(".init3"))) paint()
+{
+    for (uint8_t* p = &__heap_start; p <= (uint8_t*) RAMEND; p++)
+    {
+        *p = Stack::PAINT;
+    }
+}
+
+/**
+ * @brief Counts the painted bytes above the static variables.
+ *
+ * @return The bytes between the static variables and the deepest point the stack has reached.
+ */
+uint16_t Stack::unused()
+{
+    const uint8_t* p = &__heap_start;
+    while (p <= (const uint8_t*) RAMEND && *p == PAINT)
+    {
+        p++;
+    }
+    return p - &__heap_start;
+}
+
+/**
+ * @brief Writes the unused stack to the UART.
+ *
+ * @details Written directly, without printf(), like the video report. Nothing is reported unless
+ * STACK_REPORT is defined.
+ */
+void Stack::report()
+{
+#if defined(STACK_REPORT)
+    uart_print_P(PSTR("Stack: "));
+    uart_print(unused());
+    uart_print_P(PSTR(" bytes never used\n"));
+#endif
+}
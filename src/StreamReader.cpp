@@ -0,0 +1,116 @@
+/**
+ * @file StreamReader.cpp
+ * @brief Buffered sequential byte reader on top of a File.
+ *
+ * This file contains the implementation of the StreamReader class, which lets image decoders read
+ * their input byte by byte without calling File::read() for every byte.
+ */
+#include <StreamReader.h>
+
+/**
+ * @brief Constructs a new StreamReader reading from the current position of a file.
+ *
+ * @param file The file to read from.
+ * @param buffer The buffer used to read the file in chunks.
+ * @param size The size of the buffer.
+ */
+StreamReader::StreamReader(File& file, uint8_t* buffer, uint16_t size)
+    : file(file), buffer(buffer), size(size), length(0), index(0), ran_out(false)
+{
+}
+
+/**
+ * @brief Reads a number of bytes.
+ *
+ * @param dst The destination for the bytes.
+ * @param count The number of bytes to read.
+ * @return The number of bytes read, less than `count` at the end of the file.
+ */
+uint16_t StreamReader::read(uint8_t* dst, uint16_t count)
+{
+    uint16_t done = 0;
+    while (done < count)
+    {
+        if (index >= length && !fill())
+        {
+            break;
+        }
+        uint16_t n = length - index;
+        if (n > count - done)
+        {
+            n = count - done;
+        }
+        memcpy(dst + done, buffer + index, n);
+        index += n;
+        done += n;
+    }
+    return done;
+}
+
+/**
+ * @brief Skips a number of bytes.
+ *
+ * @details Bytes past the buffered ones are skipped with a seek, so they are never read.
+ *
+ * @param count The number of bytes to skip.
+ */
+void StreamReader::skip(uint32_t count)
+{
+    uint16_t buffered = length - index;
+    if (count <= buffered)
+    {
+        index += count;
+        return;
+    }
+    file.seek(file.get_current_position() + count - buffered);
+    index = length = 0;
+}
+
+/**
+ * @brief Moves to a position in the file.
+ *
+ * @details A position inside the buffered bytes is reached without reading the file again.
+ *
+ * @param pos The file position of the next byte read.
+ */
+void StreamReader::seek(uint32_t pos)
+{
+    uint32_t end = file.get_current_position();
+    if (pos <= end && end - pos <= length)
+    {
+        index = length - (end - pos);
+        return;
+    }
+    file.seek(pos);
+    index = length = 0;
+}
+
+/**
+ * @brief Gets the file position of the next byte read.
+ *
+ * @return The position in the file.
+ */
+uint32_t StreamReader::position()
+{
+    return file.get_current_position() - (length - index);
+}
+
+/**
+ * @brief Reads the next chunk of the file into the buffer.
+ *
+ * @details Called only when a read needs more bytes, so a chunk that comes back empty is
+ * remembered, see failed().
+ *
+ * @return true if at least one byte was read, false at the end of the file or on a read error.
+ */
+bool StreamReader::fill()
+{
+    int16_t n = file.read(buffer, size);
+    index = 0;
+    length = n > 0 ? n : 0;
+    if (length == 0)
+    {
+        ran_out = true;
+    }
+    return length > 0;
+}
@@ -0,0 +1,216 @@
+/**
+ * @file Thumbs.cpp
+ * @brief Thumbnails of the image folder, cached in a file on the card.
+ *
+ * This file contains the implementation of the Thumbs class, which keeps one record per image of
+ * the folder in a cache file and draws the thumbnails from it.
+ */
+#include <Thumbs.h>
+#include <Workspace.h>
+#include <config.h>
+#include <string.h>
+extern "C"
+{
+#include <ili9341.h>
+}
+
+/// Name of the cache file in the root directory.
+static const char CACHE_NAME[] = "THUMBS.DAT";
+
+/**
+ * @brief Constructs a closed cache.
+ *
+ * @param fs Pointer to the FAT object.
+ */
+Thumbs::Thumbs(FAT* fs) : file(fs), root(NULL)
+{
+}
+
+/**
+ * @brief Opens the cache file of a folder, creating it if needed.
+ *
+ * @param root_dir The root directory, which holds the cache file.
+ * @param folder_cluster The first cluster of the image folder.
+ * @return True if the cache file is open, false otherwise.
+ */
+bool Thumbs::open(File& root_dir, uint32_t folder_cluster)
+{
+    root = &root_dir;
+    close();
+    if (file.open(root_dir, CACHE_NAME, File::O_RDONLY))
+    {
+        if (file.read() == 'T' && file.read() == 'H' && file.read() == 'M' && file.read() == '1' &&
+            File::read32(file) == folder_cluster)
+        {
+            return true;
+        }
+        file.close();
+    }
+
+    // A new cache, or the cache of another folder, starts without records
+    DEBUG("New thumbnail cache\n");
+    if (!file.open(root_dir, CACHE_NAME, File::O_RDWR | File::O_CREAT | File::O_TRUNC))
+    {
+        return false;
+    }
+    bool written = file.write((const uint8_t*) "THM1", 4) == 4 &&
+                   file.write((const uint8_t*) &folder_cluster, 4) == 4 && pad(512);
+    file.close();
+    return written && file.open(root_dir, CACHE_NAME, File::O_RDONLY);
+}
+
+/**
+ * @brief Closes the cache file.
+ */
+void Thumbs::close()
+{
+    if (file.is_open())
+    {
+        file.close();
+    }
+}
+
+/**
+ * @brief Draws the thumbnail of an image if the cache holds it.
+ *
+ * @details The record is read a sector at a time straight into a buffer, so the FAT cache is left
+ * alone and the directory block in it stays cached for the next ImgFolder::list_next().
+ *
+ * @param index The index of the image in the folder.
+ * @param key The key of the image file.
+ * @param x The x-coordinate of the thumbnail on the display.
+ * @param y The y-coordinate of the thumbnail on the display.
+ * @return True if the thumbnail was drawn, false if its record is missing or stale.
+ */
+bool Thumbs::draw(uint8_t index, const ThumbKey& key, uint16_t x, uint16_t y)
+{
+    typedef uint8_t Sector[512];
+    Sector& sector = Workspace::get<Sector>();
+    if (!file.is_open() || !file.seek(record_position(index)) ||
+        file.read(sector, sizeof(sector)) != sizeof(sector) || memcmp(sector, &key, sizeof(key)))
+    {
+        return false;
+    }
+
+    ILI9341_SetWindow(x, y, x + WIDTH - 1, y + HEIGHT - 1);
+    ILI9341_TransmitCmmd(ILI9341_RAMWR);
+    uint8_t* pixels = sector + sizeof(key);
+    uint16_t count = (sizeof(sector) - sizeof(key)) / 2;
+    uint16_t left = WIDTH * HEIGHT;
+    while (true)
+    {
+        if (count > left)
+            count = left;
+        ILI9341_PushPixels565BE(pixels, count);
+        left -= count;
+        if (left == 0)
+        {
+            return true;
+        }
+        if (file.read(sector, sizeof(sector)) != sizeof(sector))
+        {
+            return false;
+        }
+        pixels = sector;
+        count = sizeof(sector) / 2;
+    }
+}
+
+/**
+ * @brief Makes the thumbnail of an image from a rectangle of the display.
+ *
+ * @details The image must just have been drawn into the rectangle, with the image area not
+ * scrolled. Only the WIDTH x HEIGHT blocks of scale x scale pixels at (x, y) are read back, a row
+ * of blocks at a time, and every block is averaged into one thumbnail pixel. The cache file is
+ * opened for writing only here, since a file open for writing does not get the contiguous read
+ * path. Records missing before this one are written with a zero key, and the key of this one is
+ * written last, so a record that was cut short stays stale.
+ *
+ * @param index The index of the image in the folder.
+ * @param key The key of the image file.
+ * @param x The x-coordinate of the rectangle on the display.
+ * @param y The y-coordinate of the rectangle on the display.
+ * @param scale The display pixels per thumbnail pixel each way, 1 for an image drawn at thumbnail
+ * size and SCALE for one drawn into the image area.
+ * @return True if the record was written, false otherwise.
+ */
+bool Thumbs::store(uint8_t index, const ThumbKey& key, uint16_t x, uint16_t y, uint8_t scale)
+{
+    typedef uint16_t Sums[3 * WIDTH]; // Red, green and blue sums of a row of blocks
+    Sums& acc = Workspace::get<Sums>();
+    if (root == NULL)
+    {
+        return false;
+    }
+    close();
+    if (!file.open(*root, CACHE_NAME, File::O_RDWR))
+    {
+        return false;
+    }
+
+    uint32_t pos = record_position(index);
+    bool written = file.seek(file.get_file_size()) && pad(pos) && file.seek(pos) &&
+                   pad(pos + sizeof(ThumbKey));
+    ILI9341_SetWindow(x, y, x + WIDTH * scale - 1, y + HEIGHT * scale - 1);
+    ILI9341_ReadStart();
+    for (uint8_t ty = 0; written && ty < HEIGHT; ty++)
+    {
+        memset(acc, 0, sizeof(acc));
+        for (uint8_t r = 0; r < scale; r++)
+        {
+            uint16_t* sum = acc;
+            for (uint8_t tx = 0; tx < WIDTH; tx++, sum += 3)
+            {
+                for (uint8_t c = 0; c < scale; c++)
+                {
+                    uint16_t color = ILI9341_PullColor565();
+                    sum[0] += color >> 11;
+                    sum[1] += color >> 5 & 0x3F;
+                    sum[2] += color & 0x1F;
+                }
+            }
+        }
+
+        // The pixels replace the sums front to back, each after its sums are used
+        uint8_t* row = (uint8_t*) acc;
+        const uint8_t n = scale * scale;
+        for (uint8_t tx = 0; tx < WIDTH; tx++)
+        {
+            uint16_t color = (acc[3 * tx] + n / 2) / n << 11 | (acc[3 * tx + 1] + n / 2) / n << 5 |
+                             (acc[3 * tx + 2] + n / 2) / n;
+            row[2 * tx] = color >> 8;
+            row[2 * tx + 1] = color;
+        }
+        written = file.write(row, 2 * WIDTH) == 2 * WIDTH;
+    }
+    ILI9341_ReadEnd();
+
+    written = written && pad(pos + RECORD_SECTORS * 512UL) && file.seek(pos) &&
+              file.write((const uint8_t*) &key, sizeof(key)) == sizeof(key);
+    file.close();
+    file.open(*root, CACHE_NAME, File::O_RDONLY);
+    return written;
+}
+
+/**
+ * @brief Writes zeros from the current position of the cache file up to a position.
+ *
+ * @param end The position to stop at.
+ * @return True if all zeros were written, false otherwise.
+ */
+bool Thumbs::pad(uint32_t end)
+{
+    uint8_t zeros[32];
+    memset(zeros, 0, sizeof(zeros));
+    while (file.get_current_position() < end)
+    {
+        uint32_t n = end - file.get_current_position();
+        if (n > sizeof(zeros))
+            n = sizeof(zeros);
+        if (file.write(zeros, n) != n)
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file Tiles.cpp
+ * @brief Reader of tiled, mipmapped RGB565 album images.
+ *
+ * This file contains the implementation of the Tiles class, which draws rectangles of a tiled
+ * image file from the tiles that intersect them.
+ */
+#include <Slide.h>
+#include <Tiles.h>
+#include <config.h>
+extern "C"
+{
+#include <ili9341.h>
+}
+
+/**
+ * @brief Parses the header of a tiled image file.
+ *
+ * @details The file must be positioned at its start.
+ *
+ * @param file The file to parse the header from.
+ * @param header The TilesHeader object to store the parsed header information.
+ * @return True if the file is a tiled image, false otherwise.
+ */
+bool Tiles::parse_header(File& file, TilesHeader& header)
+{
+    if (file.read() != 'T' || file.read() != 'I' || file.read() != 'L' || file.read() != '1')
+    {
+        return false;
+    }
+    header.width = File::read16(file);
+    header.height = File::read16(file);
+    header.levels = file.read();
+    if (header.width == 0 || header.height == 0 || header.levels == 0 ||
+        header.levels > MAX_LEVELS)
+    {
+        DEBUG("Unsupported tiled image\n");
+        return false;
+    }
+    file.seek(12);
+    for (uint8_t i = 0; i < MAX_LEVELS; i++)
+    {
+        header.first_sector[i] = File::read32(file);
+    }
+    return true;
+}
+
+/**
+ * @brief Draws a tiled image into the image area.
+ *
+ * @details See draw_area(). The file is closed afterwards.
+ *
+ * @param file The tiled image file.
+ * @param header The parsed header of the file.
+ * @param x The x-coordinate of the top-left corner of the image area on the display.
+ * @param y The y-coordinate of the top-left corner of the image area on the display.
+ * @return True if the whole view was drawn, false on a read error.
+ */
+bool Tiles::draw(File& file, const TilesHeader& header, uint8_t x, uint8_t y)
+{
+    return draw_area(file, header, x, y, TFT_WIDTH - x, TFT_HEIGHT - 10 - y);
+}
+
+/**
+ * @brief Draws a tiled image into an area of the display.
+ *
+ * @details The largest level that fits the area is drawn, centred. If even the smallest level is
+ * larger, its centre is drawn cropped to the area. Levels are never enlarged. The tiles are drawn
+ * a row of tiles at a time from the top, so the image can slide in, see Slide. The file is closed
+ * afterwards.
+ *
+ * @param file The tiled image file.
+ * @param header The parsed header of the file.
+ * @param x The x-coordinate of the top-left corner of the area on the display.
+ * @param y The y-coordinate of the top-left corner of the area on the display.
+ * @param area_w The width of the area.
+ * @param area_h The height of the area.
+ * @return True if the whole view was drawn, false on a read error.
+ */
+bool Tiles::draw_area(File& file, const TilesHeader& header, uint16_t x, uint16_t y,
+                      uint16_t area_w, uint16_t area_h)
+{
+    uint8_t level = 0;
+    while (level + 1 < header.levels &&
+           (level_width(header, level) > area_w || level_height(header, level) > area_h))
+    {
+        level++;
+    }
+    uint16_t level_w = level_width(header, level);
+    uint16_t level_h = level_height(header, level);
+    uint16_t w = level_w < area_w ? level_w : area_w;
+    uint16_t h = level_h < area_h ? level_h : area_h;
+
+    // If the level is smaller than the area
+    // center vertically and horizontally
+    x += (area_w - w) / 2;
+    y += (area_h - h) / 2;
+
+    Slide::begin(x, y, w, h);
+    bool drawn = draw_view(file, header, level, (level_w - w) / 2, (level_h - h) / 2, x, y, w, h);
+    file.close();
+    return drawn;
+}
+
+/**
+ * @brief Draws a rectangle of a level.
+ *
+ * @details Every tile that intersects the rectangle gets a display window on its part of it. The
+ * rows of the tile in view are read whole, from the sector that holds the first of them, and the
+ * columns in view are pushed to the display as they are. Tiles of a row of tiles follow each other
+ * in the file, so a view that spans whole tiles is read without a seek. Slide::reveal() is called
+ * after every row of tiles.
+ *
+ * @param file The tiled image file.
+ * @param header The parsed header of the file.
+ * @param level The level to draw from.
+ * @param vx The left edge of the rectangle in the level.
+ * @param vy The top edge of the rectangle in the level.
+ * @param x The x-coordinate of the rectangle on the display.
+ * @param y The y-coordinate of the rectangle on the display.
+ * @param w The width of the rectangle, within the level.
+ * @param h The height of the rectangle, within the level.
+ * @return True if the rectangle was drawn, false on a read error.
+ */
+bool Tiles::draw_view(File& file, const TilesHeader& header, uint8_t level, uint16_t vx,
+                      uint16_t vy, uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+    uint8_t row[TILE_SIZE * 2]; // One row of a tile
+    uint16_t tiles_x = (level_width(header, level) + TILE_SIZE - 1) / TILE_SIZE;
+    uint16_t tx_first = vx / TILE_SIZE;
+    uint16_t tx_last = (vx + w - 1) / TILE_SIZE;
+    uint16_t ty_first = vy / TILE_SIZE;
+    uint16_t ty_last = (vy + h - 1) / TILE_SIZE;
+
+    for (uint16_t ty = ty_first; ty <= ty_last; ty++)
+    {
+        // Rows of the tiles in view
+        uint8_t r0 = ty == ty_first ? vy % TILE_SIZE : 0;
+        uint8_t r1 = ty == ty_last ? (vy + h - 1) % TILE_SIZE + 1 : TILE_SIZE;
+        for (uint16_t tx = tx_first; tx <= tx_last; tx++)
+        {
+            // Columns of the tile in view
+            uint8_t c0 = tx == tx_first ? vx % TILE_SIZE : 0;
+            uint8_t c1 = tx == tx_last ? (vx + w - 1) % TILE_SIZE + 1 : TILE_SIZE;
+            uint16_t left = x + tx * TILE_SIZE + c0 - vx;
+            uint16_t top = y + ty * TILE_SIZE + r0 - vy;
+            ILI9341_SetWindow(left, top, left + c1 - c0 - 1, top + r1 - r0 - 1);
+            ILI9341_TransmitCmmd(ILI9341_RAMWR);
+
+            uint32_t tile = (uint32_t) ty * tiles_x + tx;
+            uint32_t sector = header.first_sector[level] + tile * TILE_SECTORS;
+            uint32_t pos = sector * 512 + r0 * sizeof(row);
+            if (file.get_current_position() != pos)
+            {
+                file.seek(pos);
+            }
+            for (uint8_t r = r0; r < r1; r++)
+            {
+                if (file.read(row, sizeof(row)) != sizeof(row))
+                {
+                    DEBUG("Tile read error\n");
+                    return false;
+                }
+                ILI9341_PushPixels565BE(row + 2 * c0, c1 - c0);
+            }
+        }
+        Slide::reveal(ty == ty_last ? h : (ty + 1) * TILE_SIZE - vy);
+    }
+    return true;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file UiBars.cpp
+ * @brief Text fields of the UI bars, redrawn only when they change.
+ *
+ * This file contains the layout of the UI bars and the implementation of the UiBars class.
+ */
+#include <UiBars.h>
+#include <avr/pgmspace.h>
+#include <string.h>
+extern "C"
+{
+#include <ili9341.h>
+}
+
+/**
+ * @struct FieldLayout
+ * @brief Position and width of a field.
+ */
+struct FieldLayout
+{
+    uint8_t x;      ///< Display column of the first cell.
+    uint16_t y;     ///< Display row of the top of the cells.
+    uint8_t cells;  ///< Number of character cells, 6 pixels wide each.
+    uint8_t offset; ///< Position of the field in UiBars::text.
+};
+
+// The button fields of the bottom bar follow each other without a gap
+static const FieldLayout LAYOUT[UiBars::FIELD_COUNT] PROGMEM = {
+    {10, 1, 12, 0},    // NAME, an 8.3 name
+    {110, 1, 11, 12},  // POSITION, "65535/65535"
+    {180, 1, 10, 23},  // SIZE, up to the right edge
+    {47, 311, 8, 33},  // PREV, "<-- Prev"
+    {95, 311, 7, 41},  // SPLIT, "  |>|  "
+    {137, 311, 9, 48}, // NEXT, "Start -->"
+};
+
+/**
+ * @brief Constructs the model of bars that have not been drawn yet.
+ */
+UiBars::UiBars()
+{
+    invalidate();
+}
+
+/**
+ * @brief Shows a text in a field.
+ *
+ * @details The text is padded with spaces or cut to the width of the field. The field is only drawn
+ * if that differs from what it shows.
+ *
+ * @param field The field.
+ * @param str The text.
+ */
+void UiBars::set(Field field, const char* str)
+{
+    FieldLayout layout;
+    memcpy_P(&layout, &LAYOUT[field], sizeof(layout));
+
+    char* cells = text + layout.offset;
+    const char* p = str;
+    bool changed = false;
+    for (uint8_t i = 0; i < layout.cells; i++)
+    {
+        char c = *p ? *p++ : ' ';
+        if (cells[i] != c)
+        {
+            cells[i] = c;
+            changed = true;
+        }
+    }
+    if (!changed)
+    {
+        return;
+    }
+    ILI9341_SetPosition(layout.x, layout.y);
+    ILI9341_DrawStringCells(str, layout.cells, ILI9341_WHITE, ILI9341_BLACK);
+}
+
+/**
+ * @brief Shows a text kept in program memory in a field, see set().
+ *
+ * @param field The field.
+ * @param str The text, in program memory.
+ */
+void UiBars::set_P(Field field, const char* str)
+{
+    // the widest field has 12 cells
+    char buffer[13];
+    strncpy_P(buffer, str, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+    set(field, buffer);
+}
+
+/**
+ * @brief Forgets what the fields show, so that set() draws every field again.
+ *
+ * @details Needed after the bars have been drawn over, for example by clearing the screen.
+ */
+void UiBars::invalidate()
+{
+    // no text contains a 0 byte, so every cell differs
+    memset(text, 0, sizeof(text));
+}
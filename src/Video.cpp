@@ -0,0 +1,201 @@
+/**
+ * @file Video.cpp
+ * @brief Player of raw RGB565 frame sequences.
+ *
+ * This file contains the implementation of the Video class, which streams uncompressed frames
+ * from the SD card to the display and paces them with Millis.
+ */
+#include <Millis.h>
+#include <Video.h>
+#include <Workspace.h>
+#include <config.h>
+extern "C"
+{
+#include <ili9341.h>
+}
+#if defined(VIDEO_REPORT)
+#include <avr/pgmspace.h>
+#include <serial.h>
+#endif
+
+/**
+ * @brief Constructs a player that is not playing.
+ */
+Video::Video()
+    : file(NULL), x(0), y(0), frame_count(0), fps(0), next_frame(0), start_time(0), shown(0),
+      dropped(0)
+{
+}
+
+/**
+ * @brief Starts playing a video file.
+ *
+ * @details The header is checked and the number of frames is limited to the frames the file
+ * really holds. The file stays open until stop() is called, which has to happen before the File
+ * object is reused. The first frame is due at once.
+ *
+ * @param file The video file, positioned at its start.
+ * @param x The x-coordinate of the top-left corner of the image area on the display.
+ * @param y The y-coordinate of the top-left corner of the image area on the display.
+ * @return True if the file is a video of the supported frame size, false otherwise.
+ */
+bool Video::start(File& file, uint8_t x, uint8_t y)
+{
+    if (file.read() != 'R' || file.read() != 'G' || file.read() != 'V' || file.read() != '1')
+    {
+        return false;
+    }
+    if (File::read16(file) != FRAME_WIDTH || File::read16(file) != FRAME_HEIGHT)
+    {
+        DEBUG("Unsupported video frame size\n");
+        return false;
+    }
+    frame_count = File::read16(file);
+    fps = file.read();
+
+    uint32_t size = file.get_file_size();
+    uint32_t frames = size > HEADER_SIZE ? (size - HEADER_SIZE) / FRAME_SIZE : 0;
+    if (frames < frame_count)
+    {
+        frame_count = frames;
+    }
+    if (frame_count == 0 || fps == 0)
+    {
+        return false;
+    }
+
+    this->x = x;
+    this->y = y;
+    this->file = &file;
+    next_frame = 0;
+    shown = 0;
+    dropped = 0;
+    start_time = Millis::get();
+    return true;
+}
+
+/**
+ * @brief Stops playing and closes the video file.
+ */
+void Video::stop()
+{
+    if (file != NULL)
+    {
+        report();
+        file->close();
+        file = NULL;
+    }
+}
+
+/**
+ * @brief Checks if the next frame should be drawn.
+ *
+ * @return True if a video is playing and its next frame is due, false otherwise.
+ */
+bool Video::frame_due()
+{
+    return file != NULL && (int32_t) (Millis::get() - frame_time(next_frame)) >= 0;
+}
+
+/**
+ * @brief Draws the next frame of the video.
+ *
+ * @details Frames whose successor is already due are skipped. The frame is written through one
+ * window and one RAMWR, a sector at a time through the Workspace. The padding of the last sector
+ * is read but not drawn, which keeps the multi-block read going into the next frame. At the end of
+ * the file playback loops to the first frame.
+ *
+ * @return True if a frame was drawn, false if playback stopped on a read error.
+ */
+bool Video::draw_frame()
+{
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    if (next_frame >= frame_count)
+    {
+        report();
+        // the next pass starts when the last frame is over, or now if that has already passed
+        uint32_t end_time = frame_time(frame_count);
+        start_time = Millis::get();
+        if ((int32_t) (end_time - start_time) > 0)
+        {
+            start_time = end_time;
+        }
+        next_frame = 0;
+        shown = 0;
+        dropped = 0;
+    }
+
+    uint32_t now = Millis::get();
+    while (next_frame + 1 < frame_count && (int32_t) (now - frame_time(next_frame + 1)) >= 0)
+    {
+        next_frame++;
+        dropped++;
+    }
+
+    typedef uint8_t Sector[512];
+    Sector& buffer = Workspace::get<Sector>();
+    file->seek(HEADER_SIZE + next_frame * FRAME_SIZE);
+    ILI9341_SetWindow(x, y, x + FRAME_WIDTH - 1, y + FRAME_HEIGHT - 1);
+    ILI9341_TransmitCmmd(ILI9341_RAMWR);
+    uint32_t pixels = (uint32_t) FRAME_WIDTH * FRAME_HEIGHT;
+    while (pixels)
+    {
+        if (file->read(buffer, sizeof(buffer)) != sizeof(buffer))
+        {
+            DEBUG("Video read error\n");
+            stop();
+            return false;
+        }
+        uint16_t n = pixels < sizeof(buffer) / 2 ? pixels : sizeof(buffer) / 2;
+        ILI9341_PushPixels565BE(buffer, n);
+        pixels -= n;
+    }
+
+    shown++;
+    next_frame++;
+    return true;
+}
+
+/**
+ * @brief Gets the time at which a frame of the current pass is due.
+ *
+ * @param frame The index of the frame.
+ * @return Millis at which the frame is due.
+ */
+uint32_t Video::frame_time(uint16_t frame)
+{
+    return start_time + (uint32_t) frame * 1000 / fps;
+}
+
+/**
+ * @brief Reports the frames shown and dropped in the current pass and the achieved frame rate.
+ *
+ * @details The report is written to the UART directly, without printf(), so it costs little flash
+ * and is there without DEBUG_SERIAL. Nothing is reported unless VIDEO_REPORT is defined.
+ */
+void Video::report()
+{
+#if defined(VIDEO_REPORT)
+    uint32_t elapsed = Millis::get() - start_time;
+    if (shown == 0 || elapsed == 0)
+    {
+        return;
+    }
+    uint16_t fps10 = (uint32_t) shown * 10000 / elapsed;
+    uart_print_P(PSTR("Video: "));
+    uart_print(shown);
+    uart_print_P(PSTR(" shown, "));
+    uart_print(dropped);
+    uart_print_P(PSTR(" dropped, "));
+    uart_print(fps10 / 10);
+    uart_write('.');
+    uart_print(fps10 % 10);
+    uart_print_P(PSTR(" fps of "));
+    uart_print(fps);
+    uart_write('\n');
+#endif
+}
@@ -0,0 +1,10 @@
+/**
+ * @file Workspace.cpp
+ * @brief RAM shared by the image decoders.
+ *
+ * This file contains the storage of the Workspace class.
+ */
+#include <Workspace.h>
+
+uint16_t Workspace::buffer[Workspace::SIZE / 2];
+uint8_t Workspace::owner = Workspace::NOBODY;
@@ -29,6 +29,7 @@
 
 #include <FAT.h>
 #include <stdio.h>
+#include <string.h>
 
 FAT::FAT(SDCard *dev)
 {
@@ -36,6 +37,7 @@ FAT::FAT(SDCard *dev)
     cache_block_no = 0XFFFFFFFF;
     cache_dirty = false;
     cache_mirror_block = 0;
+    mirror_dirty_cnt = 0;
     alloc_search_start = 2;
 }
 
@@ -44,6 +46,8 @@ bool FAT::mount()
     uint32_t start_block = 0;
     uint8_t part = 1; // For now only first partition
 
+    mirror_dirty_cnt = 0;
+
     if (!cache_raw_block(start_block, CACHE_FOR_READ))
         return false;
 
@@ -55,8 +59,43 @@ bool FAT::mount()
         printf("p->boot: %x, p->totalSectors: %lu, p->firstSector: %lu\n", p->boot & 0x7f, p->totalSectors, p->firstSector);
         return false;
     }
-    start_block = p->firstSector;
+    return mount_volume(p->firstSector);
+}
 
+bool FAT::mount(const fat_volume_t *volume)
+{
+    mirror_dirty_cnt = 0;
+
+    // only the boot sector is read, the MBR is skipped
+    if (!mount_volume(volume->boot_block))
+        return false;
+
+    // same card and unchanged volume
+    fat_volume_t current;
+    get_volume(&current);
+    return !memcmp(&current, volume, sizeof(fat_volume_t));
+}
+
+void FAT::get_volume(fat_volume_t *volume)
+{
+    // keep padding defined, volumes are compared with memcmp
+    memset(volume, 0, sizeof(fat_volume_t));
+    volume->boot_block = boot_block;
+    volume->serial = volume_serial;
+    volume->blocks_per_fat = blocks_per_fat;
+    volume->fat_start_block = fat_start_block;
+    volume->root_dir_start = root_dir_start;
+    volume->data_start_block = data_start_block;
+    volume->cluster_count = cluster_count;
+    volume->root_dir_entry_cnt = root_dir_entry_cnt;
+    volume->fat_count = fat_count;
+    volume->blocks_per_cluster = blocks_per_cluster;
+    volume->cluster_size_shift = cluster_size_shift;
+    volume->fat_type = (uint8_t)fat_type;
+}
+
+bool FAT::mount_volume(uint32_t start_block)
+{
     if (!cache_raw_block(start_block, CACHE_FOR_READ))
         return false;
 
@@ -113,6 +152,13 @@ bool FAT::mount()
         fat_type = Type::F32;
     }
 
+    // extended boot record - FAT16 keeps it right after the common BPB
+    boot_block = start_block;
+    if (fat_type == Type::F32)
+        volume_serial = buffer.fbs.volumeSerialNumber;
+    else
+        memcpy(&volume_serial, buffer.data + 39, sizeof(volume_serial));
+
     return true;
 }
 
@@ -169,6 +215,25 @@ bool FAT::get_chain_size(uint32_t cluster, uint32_t *size)
     return true;
 }
 
+bool FAT::is_contiguous(uint32_t cluster, uint32_t size)
+{
+    uint32_t cluster_bytes = 512UL << cluster_size_shift;
+
+    // only the clusters holding size bytes have to be in one run
+    while (size > cluster_bytes) {
+        uint32_t next;
+        if (!get_fat(cluster, &next))
+            return false;
+
+        if (next != cluster + 1)
+            return false;
+
+        cluster = next;
+        size -= cluster_bytes;
+    }
+    return true;
+}
+
 bool FAT::get_fat(uint32_t cluster, uint32_t *value)
 {
     if (cluster > (cluster_count + 1))
@@ -218,6 +283,11 @@ bool FAT::read_data(uint32_t block, uint16_t offset, uint16_t count, uint8_t *bu
     return dev->read_data(block, offset, count, buffer);
 }
 
+bool FAT::read_start(uint32_t block)
+{
+    return dev->read_start(block);
+}
+
 uint8_t* FAT::get_buffer_data_ptr()
 {
     return buffer.data;
@@ -234,14 +304,57 @@ bool FAT::flush_cache()
         if (!dev->write_block(cache_block_no, buffer.data)) 
             return false;
 
-        // mirror FAT tables
+        cache_dirty = false;
+
+        // mirror FAT tables - deferred until sync()
         if (cache_mirror_block) {
-            if (!dev->write_block(cache_mirror_block, buffer.data)) 
-                return false;
-            
             cache_mirror_block = 0;
+            if (!defer_mirror(cache_block_no))
+                return false;
         }
-        cache_dirty = false;
+    }
+    return true;
+}
+
+bool FAT::sync()
+{
+    if (!flush_cache())
+        return false;
+
+    return flush_mirrors();
+}
+
+bool FAT::defer_mirror(uint32_t block)
+{
+    // already pending - the primary on the card holds the newest data
+    for (uint8_t i = 0; i < mirror_dirty_cnt; i++) {
+        if (mirror_dirty[i] == block)
+            return true;
+    }
+
+    // bounded - write everything pending before taking a new block
+    if (mirror_dirty_cnt == FAT_MIRROR_DEFER_MAX) {
+        if (!flush_mirrors())
+            return false;
+    }
+    mirror_dirty[mirror_dirty_cnt++] = block;
+    return true;
+}
+
+bool FAT::flush_mirrors()
+{
+    // newest first, it is most likely still in the cache and needs no read
+    while (mirror_dirty_cnt) {
+        uint32_t lba = mirror_dirty[mirror_dirty_cnt - 1];
+
+        if (!cache_raw_block(lba, CACHE_FOR_READ))
+            return false;
+
+        for (uint8_t i = 1; i < fat_count; i++) {
+            if (!dev->write_block(lba + i * blocks_per_fat, buffer.data))
+                return false;
+        }
+        mirror_dirty_cnt--;
     }
     return true;
 }
@@ -406,4 +519,19 @@ void FAT::set_cache_block_no(uint32_t block_no)
 bool FAT::write_block(uint32_t block, const uint8_t *dst)
 {
     return dev->write_block(block, dst);
+}
+
+bool FAT::write_start(uint32_t block, uint32_t count)
+{
+    return dev->write_start(block, count);
+}
+
+bool FAT::write_data(const uint8_t *src)
+{
+    return dev->write_data(src);
+}
+
+bool FAT::write_stop()
+{
+    return dev->write_stop();
 }
\ No newline at end of file
@@ -68,16 +68,22 @@ bool File::open_root()
 
 bool File::ls(char *buffer, uint8_t options)
 {
-    dir_t* p = nullptr;
     buffer[0]=0;
+    dir_t* p = ls_next(options);
+    return p ? fill_name(p, buffer, options) : false;
+}
+
+dir_t* File::ls_next(uint8_t options)
+{
+    dir_t* p = nullptr;
 
     if(!(options & (LS_FILE | LS_FOLDER)))
-        return false;
+        return nullptr;
 
     while((p = read_dir_cache())){
         // done if past last used entry
         if(p->name[0] == DIR_NAME_FREE)
-            return false; // Or true?
+            return nullptr;
         
         if (p->name[0] == DIR_NAME_DELETED || p->name[0] == '.' || p->name[0] == 0x80)
             continue;
@@ -90,8 +96,8 @@ bool File::ls(char *buffer, uint8_t options)
         
         break;
     }
-
-    return p ? fill_name(p, buffer, options) : false;
+    // entry stays valid until the cache is used again
+    return p;
 }
 
 bool File::ls(char *buffer, uint8_t options, uint8_t index)
@@ -199,6 +205,13 @@ int16_t File::read(uint8_t *buffer, uint16_t size)
         uint16_t offset = current_position & 0X1FF;  // offset in block
         if (type == Type::ROOT16) {
             block = fs->get_root_start() + (current_position >> 9);
+        } else if (is_contiguous()) {
+            // one cluster run - block follows from the position alone
+            block = fs->get_start_block(first_cluster) + (current_position >> 9);
+
+            // stream sequential blocks with CMD18
+            if (block != fs->get_cache_block_no() && !fs->read_start(block))
+                return -1;
         } else {
             uint8_t blockOfCluster = fs->get_block(current_position);
             if (offset == 0 && blockOfCluster == 0) {
@@ -263,6 +276,11 @@ uint8_t File::is_unbuffered_read()
     return flags & Flags::F_FILE_UNBUFFERED_READ;
 }
 
+uint8_t File::is_contiguous()
+{
+    return flags & Flags::F_FILE_CONTIGUOUS;
+}
+
 bool File::is_open()
 {
     return ((uint8_t)type != (uint8_t)Type::CLOSED);
@@ -296,7 +314,7 @@ bool File::sync()
         // clear directory dirty
         flags &= ~F_FILE_DIR_DIRTY;
     }
-    return fs->flush_cache();
+    return fs->sync();
 }
 
 dir_t* File::cache_dir_entry(uint8_t action)
@@ -394,6 +412,46 @@ bool File::open(File &dir, const char *filename, uint8_t oflag)
     return open_cached_entry(dir_index, oflag);
 }
 
+bool File::open_entry(File &dir, uint16_t entry, uint8_t oflag)
+{
+    // error if already open
+    if (is_open())
+        return false;
+
+    if (!dir.seek((uint32_t)entry << 5))
+        return false;
+
+    dir_t* p = dir.read_dir_cache();
+    if (!p || p->name[0] == DIR_NAME_FREE || p->name[0] == DIR_NAME_DELETED)
+        return false;
+
+    // entry block is in cache
+    return open_cached_entry(0XF & entry, oflag);
+}
+
+bool File::open_dir(uint32_t cluster)
+{
+    if(is_open())
+        return false;
+
+    first_cluster = cluster;
+    if(!fs->get_chain_size(first_cluster, &file_size))
+        return false;
+
+    type = Type::SUBDIR;
+
+    // read only - there is no directory entry to update
+    flags = Flags::O_READ;
+
+    // set to start of file
+    current_cluster = 0;
+    current_position = 0;
+
+    dir_block = 0;
+    dir_index = 0;
+    return true;
+}
+
 bool File::add_dir_cluster()
 {
     if(!add_cluster())
@@ -466,6 +524,11 @@ uint32_t File::get_file_size()
     return file_size;
 }
 
+uint32_t File::get_first_cluster()
+{
+    return first_cluster;
+}
+
 
 bool File::open_cached_entry(uint8_t dir_index, uint8_t oflag)
 {
@@ -499,6 +562,12 @@ bool File::open_cached_entry(uint8_t dir_index, uint8_t oflag)
     // save open flags for read/write
     flags = oflag & (O_ACCMODE | O_SYNC | O_APPEND);
 
+    // read only files stored in one cluster run skip the FAT on read and seek
+    if (type == Type::NORMAL && first_cluster && !(oflag & O_WRITE)) {
+        if (fs->is_contiguous(first_cluster, file_size))
+            flags |= F_FILE_CONTIGUOUS;
+    }
+
     // set to start of file
     current_cluster = 0;
     current_position = 0;
@@ -577,7 +646,7 @@ bool File::seek_set(uint32_t pos)
     if (!is_open() || pos > file_size)
         return false;
 
-    if (type == Type::ROOT16) {
+    if (type == Type::ROOT16 || is_contiguous()) {
         current_position = pos;
         return true;
     }
@@ -721,6 +790,129 @@ uint32_t File::available()
     return n > 0x7FFF ? 0x7FFF : n;
 }
 
+bool File::preallocate(uint32_t size)
+{
+    // only an empty file open for write gets its clusters in one run
+    if(!is_file() || !(flags & O_WRITE) || first_cluster || !size)
+        return false;
+
+    uint8_t shift = fs->get_cluster_size_shift() + 9;
+    uint32_t count = (size + (1UL << shift) - 1) >> shift;
+    current_cluster = 0;
+    if(!fs->alloc_contiguous(count, &current_cluster))
+        return false;
+
+    first_cluster = current_cluster;
+    file_size = size;
+    flags |= F_FILE_DIR_DIRTY;
+
+    // set to start of file - write() follows the chain from first_cluster
+    current_cluster = 0;
+    current_position = 0;
+    return sync();
+}
+
+bool File::write_start()
+{
+    // whole blocks of a file in one cluster run only
+    if(!is_file() || !(flags & O_WRITE) || (current_position & 0X1FF) ||
+       current_position >= file_size || !fs->is_contiguous(first_cluster, file_size))
+        return false;
+
+    uint32_t block = fs->get_start_block(first_cluster) + (current_position >> 9);
+    uint32_t count = (file_size - current_position + 511) >> 9;
+
+    // the cache must not be written while the card takes the stream
+    if(!fs->flush_cache())
+        return false;
+    uint32_t cached = fs->get_cache_block_no();
+    if(cached >= block && cached < block + count)
+        fs->set_cache_block_no(0XFFFFFFFF);
+
+    return fs->write_start(block, count);
+}
+
+bool File::write_next(const uint8_t *block)
+{
+    if(current_position >= file_size || !fs->write_data(block))
+        return false;
+
+    // the last block may run past the end of file
+    current_position += 512;
+    if(current_position > file_size)
+        current_position = file_size;
+    return true;
+}
+
+bool File::write_stop()
+{
+    // position is past the blocks written - write() must find its cluster again
+    uint32_t pos = current_position;
+    current_position = current_cluster = 0;
+    return fs->write_stop() && seek_set(pos);
+}
+
+uint32_t File::get_modified()
+{
+    if(!is_file())
+        return 0;
+
+    dir_t* d = cache_dir_entry(FAT::CACHE_FOR_READ);
+    if(!d)
+        return 0;
+    return (uint32_t)d->lastWriteDate << 16 | d->lastWriteTime;
+}
+
+bool File::make_dir(File &dir, const char *name, uint8_t attributes)
+{
+    // create a normal file
+    if(!open(dir, name, O_CREAT | O_EXCL | O_RDWR))
+        return false;
+
+    // convert file to directory
+    flags = O_READ;
+    type = Type::SUBDIR;
+
+    // allocate and zero first cluster
+    if(!add_dir_cluster())
+        return false;
+
+    // force entry to SD
+    if(!sync())
+        return false;
+
+    dir_t* p = cache_dir_entry(FAT::CACHE_FOR_WRITE);
+    if(!p)
+        return false;
+    p->attributes = DIR_ATT_DIRECTORY | attributes;
+
+    // make entry for '.'
+    dir_t d;
+    memcpy(&d, p, sizeof(d));
+    for(uint8_t i = 1; i < 11; i++) d.name[i] = ' ';
+    d.name[0] = '.';
+
+    // first block of the directory holds '.' and '..'
+    if(!fs->cache_raw_block(fs->get_start_block(first_cluster), FAT::CACHE_FOR_WRITE))
+        return false;
+    memcpy(fs->get_buffer_dir_ptr(), &d, sizeof(d));
+
+    // make entry for '..' - cluster zero stands for the root
+    d.name[1] = '.';
+    if(dir.get_type() == Type::ROOT16 || dir.get_type() == Type::ROOT32){
+        d.firstClusterLow = 0;
+        d.firstClusterHigh = 0;
+    } else {
+        d.firstClusterLow = dir.get_first_cluster() & 0XFFFF;
+        d.firstClusterHigh = dir.get_first_cluster() >> 16;
+    }
+    memcpy(fs->get_buffer_dir_ptr() + 1, &d, sizeof(d));
+
+    // set position after '..'
+    current_position = 2 * sizeof(d);
+    return fs->flush_cache();
+}
+
 bool File::rm()
 {
     // free any clusters - will fail if read-only or directory
@@ -33,6 +33,7 @@ void Millis::init()
     TCNT2 = 0;
     OCR2 = 115; // 1KHz or 1ms
     TIMSK |= (1 << OCIE2); // Interrupt to OCR2A
+    sei(); // The counter only runs with global interrupts enabled
 }
 
 uint32_t Millis::get()
@@ -38,6 +38,7 @@ SDCard::SDCard(volatile uint8_t *PORT_CS, volatile uint8_t *DDR_CS, uint8_t PIN_
     status = 0;
     block = 0;
     partial_block_read = 0;
+    multi_block = 0;
 
     this->PORT_CS = PORT_CS;
     this->DDR_CS = DDR_CS;
@@ -48,12 +49,23 @@ SDCard::SDCard(volatile uint8_t *PORT_CS, volatile uint8_t *DDR_CS, uint8_t PIN_
 }
 
 bool SDCard::init()
+{
+    if(!init_start())
+        return false;
+
+    InitStatus result;
+    while((result = init_poll()) == InitStatus::BUSY);
+
+    return result == InitStatus::READY;
+}
+
+bool SDCard::init_start()
 {
     Millis::init();
     error = Error::OK;
-    in_block = partial_block_read = 0;
+    in_block = partial_block_read = multi_block = 0;
 
-    uint32_t then = Millis::get();
+    init_then = Millis::get();
     
     deselect();
 
@@ -76,7 +88,7 @@ bool SDCard::init()
 
     // Put SD Card in idle mode
     while ((status = send_cmd(CMD0, 0)) != R1_IDLE_STATE) {
-        uint16_t diff = Millis::get() - then;
+        uint16_t diff = Millis::get() - init_then;
         if (diff > SD_INIT_TIMEOUT) {
             error = Error::CMD0;
             deselect();
@@ -100,18 +112,23 @@ bool SDCard::init()
 
         type = Type::SDv2;
     }
+    return true;
+}
 
+SDCard::InitStatus SDCard::init_poll()
+{
     // initialize card and send host supports SDHC if SD2
     uint32_t arg = type == Type::SDv2 ? 0X40000000 : 0;
 
-    while ((status = send_acmd(ACMD41, arg)) != R1_READY_STATE) {
+    if ((status = send_acmd(ACMD41, arg)) != R1_READY_STATE) {
         // Check for timeout
-        uint16_t diff = Millis::get() - then;
+        uint16_t diff = Millis::get() - init_then;
         if (diff > SD_INIT_TIMEOUT) {
             error = Error::ACMD41;
             deselect();
-            return false;
+            return InitStatus::FAILED;
         }
+        return InitStatus::BUSY;
     }
 
     // if SD2 read OCR register to check for SDHC card
@@ -119,7 +136,7 @@ bool SDCard::init()
         if (send_cmd(CMD58, 0)) {
             error = Error::CMD58;
             deselect();
-            return false;
+            return InitStatus::FAILED;
         }
         if ((SPI::read() & 0XC0) == 0XC0) type = Type::SDHC;
         // discard rest of ocr - contains allowed voltage range
@@ -127,7 +144,7 @@ bool SDCard::init()
     }
 
     deselect();
-    return true;
+    return InitStatus::READY;
 }
 
 void SDCard::deselect()
@@ -146,7 +163,8 @@ uint8_t SDCard::send_cmd(uint8_t cmd, uint32_t arg)
 
     select();
 
-    wait_busy(300);
+    // CMD12 is sent while the card may still be streaming data
+    if(cmd != CMD12) wait_busy(300);
 
     SPI::write(cmd | 0x40);
 
@@ -158,6 +176,9 @@ uint8_t SDCard::send_cmd(uint8_t cmd, uint32_t arg)
     else if(cmd == CMD8) crc = 0x87;
     SPI::write(crc);
 
+    // discard stuff byte
+    if(cmd == CMD12) SPI::read();
+
     for (uint8_t i = 0; ((status = SPI::read()) & 0X80) && i != 0XFF; i++);
     return status;
 }
@@ -166,7 +187,8 @@ void SDCard::end_read()
 {
     if(in_block){
         while(offset++ < 514) SPI::read();
-        deselect();
+        // stay selected between the blocks of a CMD18 stream
+        if(!multi_block) deselect();
         in_block = 0;
     }
 }
@@ -206,6 +228,9 @@ bool SDCard::write_block(uint32_t block_no, const uint8_t* src)
         return false;
     }
 
+    if(!read_stop())
+        return false;
+
     // use address if not SDHC card
     if(type != Type::SDHC) block_no <<= 9;
 
@@ -250,10 +275,84 @@ bool SDCard::write_data(uint8_t token, const uint8_t* src)
 
     status = SPI::read();
     if((status & DATA_RES_MASK) != DATA_RES_ACCEPTED){
+        // callers deselect, a CMD25 has to be stopped first
         error = Error::WRITE;
+        return false;
+    }
+    return true;
+}
+
+bool SDCard::write_start(uint32_t block_no, uint32_t count)
+{
+    // don't allow write to first block
+    if (!block_no) {
+        error = Error::WRITE_BLOCK_ZERO;
+        deselect();
+        return false;
+    }
+
+    if(!read_stop())
+        return false;
+
+    // let the card erase the blocks ahead of the data
+    if(send_acmd(ACMD23, count)){
+        error = Error::ACMD23;
+        deselect();
+        return false;
+    }
+
+    // use address if not SDHC card
+    if(type != Type::SDHC) block_no <<= 9;
+
+    if(send_cmd(CMD25, block_no)){
+        error = Error::CMD25;
         deselect();
         return false;
     }
+    // card stays selected until write_stop()
+    return true;
+}
+
+bool SDCard::write_data(const uint8_t* src)
+{
+    // wait for the previous block to be programmed
+    if(!wait_busy(SD_WRITE_TIMEOUT)){
+        error = Error::WRITE_MULTIPLE;
+        write_abort();
+        return false;
+    }
+    if(!write_data(WRITE_MULTIPLE_TOKEN, src)){
+        write_abort();
+        return false;
+    }
+    return true;
+}
+
+void SDCard::write_abort()
+{
+    // end the CMD25 so the card takes commands again, error is kept
+    wait_busy(SD_WRITE_TIMEOUT);
+    SPI::write(STOP_TRAN_TOKEN);
+    wait_busy(SD_WRITE_TIMEOUT);
+    deselect();
+}
+
+bool SDCard::write_stop()
+{
+    if(!wait_busy(SD_WRITE_TIMEOUT)){
+        error = Error::STOP_TRAN;
+        deselect();
+        return false;
+    }
+    SPI::write(STOP_TRAN_TOKEN);
+
+    // wait for the last block to be programmed
+    if(!wait_busy(SD_WRITE_TIMEOUT)){
+        error = Error::STOP_TRAN;
+        deselect();
+        return false;
+    }
+    deselect();
     return true;
 }
 
@@ -272,7 +371,22 @@ bool SDCard::read_data(uint32_t block, uint16_t offset, uint16_t count, uint8_t
         return false;
     }
 
-    if(!in_block || block != this->block || offset < this->offset){
+    if(multi_block && !in_block && block == this->block + 1){
+        // next block of the open CMD18 stream - no command needed
+        if(!wait_start_block()) {
+            // end the CMD18 so the card takes commands again, error is kept
+            send_cmd(CMD12, 0);
+            deselect();
+            multi_block = 0;
+            return false;
+        }
+        this->block = block;
+        this->offset = 0;
+        in_block = 1;
+    } else if(!in_block || block != this->block || offset < this->offset){
+        if(!read_stop())
+            return false;
+
         this->block = block;
             // use address if not SDHC card
         if(type != Type::SDHC) block <<= 9;
@@ -325,4 +439,40 @@ bool SDCard::wait_start_block()
     return true;
 }
 
+bool SDCard::read_start(uint32_t block)
+{
+    // stream is already positioned on this block
+    if(multi_block && !in_block && block == this->block + 1)
+        return true;
+
+    if(!read_stop())
+        return false;
+
+    // read_data() expects the block after this->block
+    this->block = block - 1;
 
+    // use address if not SDHC card
+    if(type != Type::SDHC) block <<= 9;
+    if(send_cmd(CMD18, block)){
+        error = Error::CMD18;
+        deselect();
+        return false;
+    }
+    multi_block = 1;
+    return true;
+}
+
+bool SDCard::read_stop()
+{
+    if(!multi_block)
+        return true;
+
+    multi_block = 0;
+    if(send_cmd(CMD12, 0)){
+        error = Error::CMD12;
+        deselect();
+        return false;
+    }
+    deselect();
+    return true;
+}
@@ -50,7 +50,7 @@ const uint8_t INIT_ILI9341[] PROGMEM = {
   1,   0, ILI9341_VCCR2, 0xC0,                                  // 0xC7 -> VCOM Control 2
 
   // -------------------------------------------- 
-  1,   0, ILI9341_MADCTL, 0x48,                                 // 0x36 -> Memory Access Control
+  1,   0, ILI9341_MADCTL, PORTRAIT,                             // 0x36 -> Memory Access Control
   1,   0, ILI9341_COLMOD, 0x55,                                 // 0x3A -> Pixel Format Set
   2,   0, ILI9341_FRMCRN1, 0x00, 0x1B,                          // 0xB1 -> Frame Rate Control
 /*
@@ -77,6 +77,18 @@ unsigned short int _ili9341_cache_index_row = 0;
 /** @var array Chache memory char index column */
 unsigned short int _ili9341_cache_index_col = 0;
 
+/** @var Columns max counter of the current orientation */
+static uint16_t _ili9341_size_x = ILI9341_SIZE_X;
+/** @var Rows max counter of the current orientation */
+static uint16_t _ili9341_size_y = ILI9341_SIZE_Y;
+
+/** @var Init step - 0 reset, 1 reset released, 2 commands */
+static uint8_t _ili9341_init_step = 0;
+/** @var Next init command in INIT_ILI9341 */
+static const uint8_t *_ili9341_init_command;
+/** @var Number of init commands left */
+static uint8_t _ili9341_init_remaining;
+
 /**
  * @desc    LCD init
  *
@@ -86,45 +98,76 @@ unsigned short int _ili9341_cache_index_col = 0;
  */
 void ILI9341_Init (void)
 {
-  // variables
-  const uint8_t *commands = INIT_ILI9341;
-  // number of commands
-  unsigned short int no_of_commands = pgm_read_byte(commands++);
-  // arguments
-  char no_of_arguments;
-  // command
-  char command;
   // delay
-  unsigned short int delay;
+  uint16_t delay;
 
-  // Init ports
-  ILI9341_InitPorts();
+  // loop through init steps
+  while (ILI9341_InitStep(&delay)) {
+    // delay
+    ILI9341_Delay(delay);
+  }
+}
 
-  // Init hardware reset
-  ILI9341_HWReset();
+/**
+ * @desc    LCD Init step by step
+ *
+ * @param   uint16_t * -> delay in ms required before the next step
+ *
+ * @return  char -> 1 if more steps follow, 0 when init is done
+ */
+char ILI9341_InitStep (uint16_t *delay)
+{
+  // arguments
+  uint8_t no_of_arguments;
 
-  // loop throuh commands
-  while (no_of_commands--) {
+  // start of hardware reset
+  if (_ili9341_init_step == 0) {
+    // Init ports
+    ILI9341_InitPorts();
+    // set RESET as Output
+    SETBIT(ILI9341_DDR_CONTROL, ILI9341_PIN_RST);
+    // set Reset LOW
+    CLRBIT(ILI9341_PORT_CONTROL, ILI9341_PIN_RST);
+    // delay LOW > 10us
+    *delay = 10;
+    _ili9341_init_step = 1;
+    return 1;
+  }
+  // end of hardware reset
+  if (_ili9341_init_step == 1) {
+    // set Reset HIGH
+    SETBIT(ILI9341_PORT_CONTROL, ILI9341_PIN_RST);
+    // delay HIGH > 120ms
+    *delay = 200;
+    // command list
+    _ili9341_init_command = INIT_ILI9341;
+    // number of commands
+    _ili9341_init_remaining = pgm_read_byte(_ili9341_init_command++);
+    _ili9341_init_step = 2;
+    return 1;
+  }
+  // one command of init sequence
+  if (_ili9341_init_remaining) {
+    _ili9341_init_remaining--;
     // number of arguments
-    no_of_arguments = pgm_read_byte(commands++);
+    no_of_arguments = pgm_read_byte(_ili9341_init_command++);
     // delay
-    delay = pgm_read_byte(commands++);
-    // command
-    command = pgm_read_byte(commands++);
+    *delay = pgm_read_byte(_ili9341_init_command++);
     // send command
-    // -------------------------    
-    ILI9341_TransmitCmmd(command);
+    ILI9341_TransmitCmmd(pgm_read_byte(_ili9341_init_command++));
     // send arguments
-    // -------------------------
     while (no_of_arguments--) {
       // send arguments
-      ILI9341_Transmit8bitData(pgm_read_byte(commands++));
+      ILI9341_Transmit8bitData(pgm_read_byte(_ili9341_init_command++));
     }
-    // delay
-    ILI9341_Delay(delay);
+    return 1;
   }
   // set window -> after this function display show RAM content
   ILI9341_SetWindow(0, 0, ILI9341_MAX_X-1, ILI9341_MAX_Y-1);
+  // ready for next init
+  _ili9341_init_step = 0;
+  *delay = 0;
+  return 0;
 }
 
 /**
@@ -363,8 +406,8 @@ void ILI9341_Transmit32bitData (uint32_t data)
 char ILI9341_SetWindow (uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye)
 {
   // check if coordinates is out of range
-  if ((xs > xe) || (xe > ILI9341_SIZE_X) ||
-      (ys > ye) || (ye > ILI9341_SIZE_Y)) 
+  if ((xs > xe) || (xe > _ili9341_size_x) ||
+      (ys > ye) || (ye > _ili9341_size_y)) 
   { 
     // out of range
     return ILI9341_ERROR;
@@ -418,11 +461,201 @@ void ILI9341_SendColor565 (uint16_t color, uint32_t count)
 {
   // access to RAM
   ILI9341_TransmitCmmd(ILI9341_RAMWR);
+  // write pixels
+  ILI9341_PushColor565(color, count);
+}
+
+/**
+ * @desc    LCD Write Color Pixels - continue memory write
+ *
+ * @param   uint16_t
+ * @param   uint32_t
+ *
+ * @return  void
+ */
+void ILI9341_PushColor565 (uint16_t color, uint32_t count)
+{
+  // D/C -> HIGH
+  SETBIT(ILI9341_PORT_CONTROL, ILI9341_PIN_RS);
+  // enable chip select -> LOW
+  CLRBIT(ILI9341_PORT_CONTROL, ILI9341_PIN_CS);
   // counter
   while (count--) {
     // write color - first colors byte
-    ILI9341_Transmit16bitData(color);
+    ILI9341_PORT_DATA = (uint8_t) (color >> 8);
+    // Write impulse
+    WR_IMPULSE();
+    // write color - second colors byte
+    ILI9341_PORT_DATA = (uint8_t) color;
+    // Write impulse
+    WR_IMPULSE();
+  }
+  // disable chip select -> HIGH
+  SETBIT(ILI9341_PORT_CONTROL, ILI9341_PIN_CS);
+}
+
+/**
+ * @desc    LCD Write Pixels - continue memory write with
+ *          little-endian RGB565 pixels
+ *
+ * @param   const uint8_t *
+ * @param   uint16_t
+ *
+ * @return  void
+ */
+void ILI9341_PushPixels565LE (const uint8_t * data, uint16_t count)
+{
+  // D/C -> HIGH
+  SETBIT(ILI9341_PORT_CONTROL, ILI9341_PIN_RS);
+  // enable chip select -> LOW
+  CLRBIT(ILI9341_PORT_CONTROL, ILI9341_PIN_CS);
+  // counter
+  while (count--) {
+    // write color - high byte is stored second
+    ILI9341_PORT_DATA = data[1];
+    // Write impulse
+    WR_IMPULSE();
+    // write color - low byte
+    ILI9341_PORT_DATA = data[0];
+    // Write impulse
+    WR_IMPULSE();
+    data += 2;
+  }
+  // disable chip select -> HIGH
+  SETBIT(ILI9341_PORT_CONTROL, ILI9341_PIN_CS);
+}
+
+/**
+ * @desc    LCD Write Pixels - continue memory write with
+ *          big-endian RGB565 pixels, the panel byte order
+ *
+ * @param   const uint8_t *
+ * @param   uint16_t
+ *
+ * @return  void
+ */
+void ILI9341_PushPixels565BE (const uint8_t * data, uint16_t count)
+{
+  // D/C -> HIGH
+  SETBIT(ILI9341_PORT_CONTROL, ILI9341_PIN_RS);
+  // enable chip select -> LOW
+  CLRBIT(ILI9341_PORT_CONTROL, ILI9341_PIN_CS);
+  // counter
+  while (count--) {
+    // write color - high byte
+    ILI9341_PORT_DATA = *data++;
+    // Write impulse
+    WR_IMPULSE();
+    // write color - low byte
+    ILI9341_PORT_DATA = *data++;
+    // Write impulse
+    WR_IMPULSE();
+  }
+  // disable chip select -> HIGH
+  SETBIT(ILI9341_PORT_CONTROL, ILI9341_PIN_CS);
+}
+
+/**
+ * @desc    LCD Read byte from the data bus
+ *
+ * @param   void
+ *
+ * @return  uint8_t
+ */
+static uint8_t ILI9341_ReadByte (void)
+{
+  uint8_t data;
+
+  // Read data timing diagram
+  // --------------------------------------------
+  //                ___
+  // D0 - D7:  ____/   \__
+  //          __      __
+  //      RD:   \____/
+
+  // Read impulse - data is valid before RD rises
+  RD_LOW();
+  data = ILI9341_PIN_DATA;
+  RD_HIGH();
+  return data;
+}
+
+/**
+ * @desc    LCD Start memory read of the window set before
+ *
+ * @param   void
+ *
+ * @return  void
+ */
+void ILI9341_ReadStart (void)
+{
+  // access to RAM
+  ILI9341_TransmitCmmd(ILI9341_RAMRD);
+  // data pins as input without pull-ups
+  ILI9341_DDR_DATA = 0x00;
+  ILI9341_PORT_DATA = 0x00;
+  // D/C -> HIGH
+  SETBIT(ILI9341_PORT_CONTROL, ILI9341_PIN_RS);
+  // enable chip select -> LOW
+  CLRBIT(ILI9341_PORT_CONTROL, ILI9341_PIN_CS);
+  // the first read after RAMRD is a dummy
+  ILI9341_ReadByte();
+}
+
+/**
+ * @desc    LCD Read Pixel - continue memory read
+ *
+ * @param   void
+ *
+ * @return  uint16_t
+ */
+uint16_t ILI9341_PullColor565 (void)
+{
+  // memory is read as 18 bits per pixel,
+  // 6 bits of red, green and blue in the high bits of a byte each
+  uint8_t r = ILI9341_ReadByte();
+  uint8_t g = ILI9341_ReadByte();
+  uint8_t b = ILI9341_ReadByte();
+  return (uint16_t) (r & 0xF8) << 8 | (uint16_t) (g & 0xFC) << 3 | b >> 3;
+}
+
+/**
+ * @desc    LCD End memory read
+ *
+ * @param   void
+ *
+ * @return  void
+ */
+void ILI9341_ReadEnd (void)
+{
+  // disable chip select -> HIGH
+  SETBIT(ILI9341_PORT_CONTROL, ILI9341_PIN_CS);
+  // data pins back to output
+  ILI9341_DDR_DATA = 0xFF;
+}
+
+/**
+ * @desc    LCD Fill window with one color
+ *
+ * @param   uint16_t - x start position
+ * @param   uint16_t - y start position
+ * @param   uint16_t - x end position
+ * @param   uint16_t - y end position
+ * @param   uint16_t - color
+ *
+ * @return  char
+ */
+char ILI9341_FillWindow (uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye, uint16_t color)
+{
+  // set window
+  if (ILI9341_SetWindow(xs, ys, xe, ye) != ILI9341_SUCCESS) {
+    // out of range
+    return ILI9341_ERROR;
   }
+  // draw pixels by 565 mode
+  ILI9341_SendColor565(color, (uint32_t) (xe - xs + 1) * (ye - ys + 1));
+  // success
+  return ILI9341_SUCCESS;
 }
 
 /**
@@ -440,6 +673,71 @@ void ILI9341_ClearScreen (uint16_t color)
   ILI9341_SendColor565(color, ILI9341_CACHE_MEM);
 }
 
+/**
+ * @desc    LCD Set vertical scrolling area between
+ *          fixed top and bottom areas
+ *
+ * @param   uint16_t - rows of the fixed top area
+ * @param   uint16_t - rows of the fixed bottom area
+ *
+ * @return  char
+ */
+char ILI9341_SetScrollArea (uint16_t top, uint16_t bottom)
+{
+  // check if the fixed areas fit on the screen
+  if (top + bottom > ILI9341_MAX_Y) {
+    // out of range
+    return ILI9341_ERROR;
+  }
+  // vertical scroll definition
+  ILI9341_TransmitCmmd(ILI9341_VSCRDEF);
+  // top fixed area, scrolling area
+  ILI9341_Transmit32bitData(((uint32_t) top << 16) | (ILI9341_MAX_Y - top - bottom));
+  // bottom fixed area
+  ILI9341_Transmit16bitData(bottom);
+  // success
+  return ILI9341_SUCCESS;
+}
+
+/**
+ * @desc    LCD Set memory row shown at the top of
+ *          the vertical scrolling area
+ *
+ * @param   uint16_t - row within the scrolling area
+ *
+ * @return  void
+ */
+void ILI9341_SetScrollStart (uint16_t row)
+{
+  // vertical scrolling start address
+  ILI9341_TransmitCmmd(ILI9341_VSSAD);
+  // row -> high byte first
+  ILI9341_Transmit16bitData(row);
+}
+
+/**
+ * @desc    LCD Set orientation of the memory address space
+ *
+ * @param   ILI9341_Orientations
+ *
+ * @return  void
+ */
+void ILI9341_SetOrientation (ILI9341_Orientations orientation)
+{
+  // memory access control
+  ILI9341_TransmitCmmd(ILI9341_MADCTL);
+  // address order and exchange
+  ILI9341_Transmit8bitData(orientation);
+  // columns and rows swap places with the exchange
+  if (orientation & ILI9341_MADCTL_MV) {
+    _ili9341_size_x = ILI9341_SIZE_Y;
+    _ili9341_size_y = ILI9341_SIZE_X;
+  } else {
+    _ili9341_size_x = ILI9341_SIZE_X;
+    _ili9341_size_y = ILI9341_SIZE_Y;
+  }
+}
+
 /**
  * @desc    LCD Inverse Screen
  *
@@ -784,6 +1082,82 @@ void ILI9341_DrawString (char *str, uint16_t color, ILI9341_Sizes size)
   }
 }
 
+/**
+ * @desc    Draw string from program memory
+ *
+ * @param   const char* -> string in program memory
+ * @param   uint16_t -> color
+ * @param   ILI9341_Sizes -> size
+ *
+ * @return  void
+ */
+void ILI9341_DrawString_P (const char *str, uint16_t color, ILI9341_Sizes size)
+{
+  // variables
+  char character;
+  char buffer[2] = {0, 0};
+
+  // one character at a time, read from ROM memory
+  while ((character = pgm_read_byte(str++)) != '\0') {
+    buffer[0] = character;
+    ILI9341_DrawString(buffer, color, size);
+  }
+}
+
+/**
+ * @desc    Draw string into a fixed number of character
+ *          cells with background, in one window
+ *
+ * @param   const char* -> string, padded or cut to the cells
+ * @param   uint8_t -> number of cells
+ * @param   uint16_t -> color
+ * @param   uint16_t -> background color
+ *
+ * @return  void
+ */
+void ILI9341_DrawStringCells (const char *str, uint8_t cells, uint16_t color, uint16_t background)
+{
+  // variables
+  const char *p;
+  char character;
+  uint8_t cell, idxCol, idxRow, letter;
+  uint16_t width = cells * (CHARS_COLS_LENGTH + 1);
+
+  // one window for the whole field, font size X1
+  if (ILI9341_SetWindow(_ili9341_cache_index_col,
+                        _ili9341_cache_index_row,
+                        _ili9341_cache_index_col + width - 1,
+                        _ili9341_cache_index_row + CHARS_ROWS_LENGTH - 1) != ILI9341_SUCCESS) {
+    // out of range
+    return;
+  }
+  // access to RAM
+  ILI9341_TransmitCmmd(ILI9341_RAMWR);
+  // loop through 8 rows of the cells
+  for (idxRow = 0; idxRow < CHARS_ROWS_LENGTH; idxRow++) {
+    p = str;
+    // loop through cells, spaces after the end of string
+    for (cell = 0; cell < cells; cell++) {
+      character = *p ? *p++ : ' ';
+      // characters out of range are blank
+      if ((character < 0x20) || (character > 0x7f)) {
+        character = ' ';
+      }
+      // loop through 5 columns
+      for (idxCol = 0; idxCol < CHARS_COLS_LENGTH; idxCol++) {
+        // read from ROM memory
+        letter = pgm_read_byte(&FONTS[character - 32][idxCol]);
+        // foreground or background pixel
+        ILI9341_Transmit16bitData((letter & (1 << idxRow)) ? color : background);
+      }
+      // space between characters
+      ILI9341_Transmit16bitData(background);
+    }
+  }
+  // update x position
+  _ili9341_cache_index_col += width;
+}
+
 /**
  * @desc    Check text position x, y
  *
@@ -5,13 +5,37 @@
  */
 
 #include <serial.h>
+#include <avr/pgmspace.h>
 
-int uart_putchar(char c, FILE *stream) {
+void uart_write(char c) {
     if(c == '\n')
-        uart_putchar('\r', stream);
-    
+        uart_write('\r');
+
     loop_until_bit_is_set(UCSRA, UDRE);
     UDR = c;
+}
+
+/* Writes a string from program memory */
+void uart_print_P(const char* text) {
+    char c;
+    while((c = pgm_read_byte(text++)))
+        uart_write(c);
+}
+
+/* Writes a number in decimal */
+void uart_print(uint16_t value) {
+    char digits[5];
+    uint8_t n = 0;
+    do {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while(value);
+    while(n)
+        uart_write(digits[--n]);
+}
+
+int uart_putchar(char c, FILE *stream) {
+    uart_write(c);
     return 0;
 }
 
@@ -21,7 +45,8 @@ int uart_getchar(FILE *stream)
     return UDR;
 }
 
-void uart_init()
+/* Sets up the UART to send only, without stdio */
+void uart_init_tx()
 {
     UBRRH = UBRRH_VALUE;
     UBRRL = UBRRL_VALUE;
@@ -33,7 +58,13 @@ void uart_init()
 #endif
 
     UCSRC = _BV(UCSZ1) | _BV(UCSZ0); /* 8-bit data */
-    UCSRB = _BV(RXEN) | _BV(TXEN);   /* Enable RX and TX */
+    UCSRB = _BV(TXEN);               /* Enable TX */
+}
+
+void uart_init()
+{
+    uart_init_tx();
+    UCSRB |= _BV(RXEN);              /* Enable RX as well */
 
     stdout = fdevopen(uart_putchar, NULL);
     stdin  = fdevopen(NULL, uart_getchar);
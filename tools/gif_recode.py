@@ -0,0 +1,202 @@
+#!/usr/bin/env python3
+"""Rewrite a GIF so that the album's LZW decoder can play every frame.
+
+The decoder on the ATmega32 shares a small pool between the RGB565 colour table and the LZW
+dictionary (see Gif::max_codes()), so it only holds a few hundred codes instead of 4096. This
+tool decodes the image data of every frame and encodes it again, emitting a clear code whenever
+the dictionary would grow past what the decoder can hold. All other blocks are copied as they
+are, and the result is a valid GIF for any viewer.
+
+Usage: gif_recode.py in.gif out.gif [--pool BYTES]
+"""
+import argparse
+import struct
+import sys
+
+POOL_SIZE = 736  # Gif::POOL_SIZE, Workspace::SIZE - Gif::STACK_SIZE
+
+
+def max_codes(colors, min_code_size, pool=POOL_SIZE):
+    """Same as Gif::max_codes(): the first code the decoder cannot hold."""
+    first_free = (1 << min_code_size) + 2
+    entries = ((pool - 2 * colors) * 8 - 7) // 17
+    return min(first_free + entries, 512)
+
+
+def read_sub_blocks(data, pos):
+    """Returns the concatenated sub-block data and the position after the terminator."""
+    out = bytearray()
+    while True:
+        size = data[pos]
+        pos += 1
+        if size == 0:
+            return bytes(out), pos
+        out += data[pos:pos + size]
+        pos += size
+
+
+def write_sub_blocks(payload):
+    out = bytearray()
+    for i in range(0, len(payload), 255):
+        chunk = payload[i:i + 255]
+        out.append(len(chunk))
+        out += chunk
+    out.append(0)
+    return bytes(out)
+
+
+def lzw_decode(payload, min_code_size, pixels):
+    clear = 1 << min_code_size
+    bits = 0
+    count = 0
+    pos = 0
+    size = min_code_size + 1
+    table = None
+    prev = None
+    out = bytearray()
+    while len(out) < pixels:
+        while count < size:
+            if pos >= len(payload):
+                return bytes(out)
+            bits |= payload[pos] << count
+            pos += 1
+            count += 8
+        code = bits & ((1 << size) - 1)
+        bits >>= size
+        count -= size
+        if code == clear or table is None:
+            table = [bytes([i]) for i in range(clear)] + [b"", b""]
+            size = min_code_size + 1
+            prev = None
+            if code == clear:
+                continue
+        if code == clear + 1:
+            break
+        if code < len(table):
+            entry = table[code]
+        elif code == len(table) and prev is not None:
+            entry = prev + prev[:1]
+        else:
+            raise ValueError("corrupt LZW data")
+        out += entry
+        if prev is not None and len(table) < 4096:
+            table.append(prev + entry[:1])
+            if len(table) == (1 << size) and size < 12:
+                size += 1
+        prev = entry
+    return bytes(out[:pixels])
+
+
+def lzw_encode(indices, min_code_size, cap):
+    clear = 1 << min_code_size
+    first_free = clear + 2
+    out = bytearray()
+    bits = 0
+    count = 0
+
+    def emit(code, size):
+        nonlocal bits, count
+        bits |= code << count
+        count += size
+        while count >= 8:
+            out.append(bits & 0xFF)
+            bits >>= 8
+            count -= 8
+
+    # size and next_code follow the decoder, which adds an entry one code later than the encoder
+    size = min_code_size + 1
+    emit(clear, size)
+    table = {}
+    enc_next = first_free
+    dec_next = first_free
+    first = True
+    w = None
+    for k in indices:
+        if w is None:
+            w = (k,)
+            continue
+        wk = w + (k,)
+        if wk in table or (len(wk) == 1):
+            w = wk
+            continue
+        code = table[w] if len(w) > 1 else w[0]
+        emit(code, size)
+        if not first:
+            dec_next += 1
+            if dec_next == (1 << size) and size < 12:
+                size += 1
+        first = False
+        table[wk] = enc_next
+        enc_next += 1
+        w = (k,)
+        if enc_next >= cap:
+            emit(clear, size)
+            size = min_code_size + 1
+            table = {}
+            enc_next = first_free
+            dec_next = first_free
+            first = True
+    if w is not None:
+        emit(table[w] if len(w) > 1 else w[0], size)
+        if not first:
+            dec_next += 1
+            if dec_next == (1 << size) and size < 12:
+                size += 1
+    emit(clear + 1, size)
+    if count:
+        out.append(bits & 0xFF)
+    return bytes(out)
+
+
+def recode(data, pool=POOL_SIZE):
+    if data[:4] != b"GIF8":
+        raise ValueError("not a GIF file")
+    packed = data[10]
+    global_colors = 2 << (packed & 7) if packed & 0x80 else 0
+    pos = 13 + 3 * global_colors
+    out = bytearray(data[:pos])
+    while pos < len(data):
+        block = data[pos]
+        if block == 0x21:
+            _, end = read_sub_blocks(data, pos + 2)
+            out += data[pos:end]
+            pos = end
+        elif block == 0x2C:
+            width, height, fpacked = struct.unpack("<HHB", data[pos + 5:pos + 10])
+            colors = global_colors
+            header_end = pos + 10
+            if fpacked & 0x80:
+                colors = 2 << (fpacked & 7)
+                header_end += 3 * colors
+            out += data[pos:header_end]
+            min_code_size = data[header_end]
+            payload, pos = read_sub_blocks(data, header_end + 1)
+            indices = lzw_decode(payload, min_code_size, width * height)
+            cap = max_codes(colors, min_code_size, pool)
+            out.append(min_code_size)
+            out += write_sub_blocks(lzw_encode(indices, min_code_size, cap))
+        elif block == 0x3B:
+            out.append(0x3B)
+            break
+        else:
+            raise ValueError("unexpected block 0x%02X at %d" % (block, pos))
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input")
+    parser.add_argument("output")
+    parser.add_argument("--pool", type=int, default=POOL_SIZE,
+                        help="Gif::POOL_SIZE of the firmware (default %(default)s)")
+    args = parser.parse_args()
+    with open(args.input, "rb") as f:
+        data = f.read()
+    result = recode(data, args.pool)
+    with open(args.output, "wb") as f:
+        f.write(result)
+    print("%s: %d -> %d bytes" % (args.output, len(data), len(result)), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,88 @@
+/**
+ * @file File.h
+ * @brief Host stand-in for the FAT File class, used by the tools in this directory.
+ *
+ * Reads a file of the host filesystem through stdio and counts the bytes read, so the decoders
+ * of the album can be run and measured on a PC.
+ */
+#ifndef _FILE_H_
+#define _FILE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+class File
+{
+public:
+    File() : file(NULL), bytes_read(0)
+    {
+    }
+
+    bool open(const char* path)
+    {
+        file = fopen(path, "rb");
+        bytes_read = 0;
+        return file != NULL;
+    }
+
+    int16_t read()
+    {
+        int c = fgetc(file);
+        if (c < 0)
+            return -1;
+        bytes_read++;
+        return c;
+    }
+
+    int16_t read(void* buf, uint16_t nbyte)
+    {
+        size_t n = fread(buf, 1, nbyte, file);
+        bytes_read += n;
+        return n;
+    }
+
+    uint8_t seek(uint32_t pos)
+    {
+        return fseek(file, pos, SEEK_SET) == 0;
+    }
+
+    uint32_t get_current_position()
+    {
+        return ftell(file);
+    }
+
+    uint32_t get_file_size()
+    {
+        long pos = ftell(file);
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, pos, SEEK_SET);
+        return size;
+    }
+
+    uint8_t close()
+    {
+        if (file)
+            fclose(file);
+        file = NULL;
+        return 1;
+    }
+
+    static uint16_t read16(File& f)
+    {
+        uint16_t lo = (uint8_t) f.read();
+        return lo | (uint8_t) f.read() << 8;
+    }
+
+    static uint32_t read32(File& f)
+    {
+        uint32_t lo = read16(f);
+        return lo | (uint32_t) read16(f) << 16;
+    }
+
+    FILE* file;          ///< The host file.
+    uint32_t bytes_read; ///< Bytes read since open(), what the SD card would have to transfer.
+};
+
+#endif // _FILE_H_
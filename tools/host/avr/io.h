@@ -0,0 +1 @@
+/* Host stand-in for avr/io.h, the tools never touch the hardware registers. */
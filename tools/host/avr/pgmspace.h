@@ -0,0 +1,14 @@
+/* Host stand-in for avr/pgmspace.h, program memory is ordinary memory on a PC. */
+#ifndef HOST_PGMSPACE_H
+#define HOST_PGMSPACE_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t*) (p))
+#define pgm_read_word(p) (*(const uint16_t*) (p))
+#define pgm_read_dword(p) (*(const uint32_t*) (p))
+#define memcpy_P memcpy
+
+#endif
@@ -0,0 +1,144 @@
+/**
+ * @file lcd.cpp
+ * @brief Host stand-in for the ILI9341 driver, used by the tools in this directory.
+ *
+ * Pixels written through the window functions land in a 240x320 RGB565 frame buffer, and the
+ * number of pixels sent over the bus is counted. In landscape orientation the window coordinates are
+ * mapped onto the portrait frame buffer like the display does. Scrolling only records the
+ * registers. Memory reads return the frame buffer in portrait orientation.
+ */
+#include <stdint.h>
+#include <stdio.h>
+
+uint16_t lcd_frame[320][240]; ///< The emulated display memory.
+uint32_t lcd_pixels;          ///< Pixels written since start.
+uint16_t lcd_scroll_top;      ///< Rows of the fixed top area.
+uint16_t lcd_scroll_bottom;   ///< Rows of the fixed bottom area.
+uint16_t lcd_scroll_start;    ///< Memory row shown at the top of the scrolling area.
+
+static uint16_t win_x0, win_y0, win_x1, win_y1, cur_x, cur_y;
+static bool landscape;
+
+static void put(uint16_t color)
+{
+    // Landscape column x is portrait row x, landscape row y is portrait column 239 - y
+    uint16_t x = landscape ? 239 - cur_y : cur_x;
+    uint16_t y = landscape ? cur_x : cur_y;
+    if (cur_y <= win_y1 && y < 320 && x < 240)
+        lcd_frame[y][x] = color;
+    lcd_pixels++;
+    if (++cur_x > win_x1)
+    {
+        cur_x = win_x0;
+        cur_y++;
+    }
+}
+
+extern "C"
+{
+void ILI9341_SetWindow(uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye)
+{
+    win_x0 = cur_x = xs;
+    win_y0 = cur_y = ys;
+    win_x1 = xe;
+    win_y1 = ye;
+}
+
+void ILI9341_TransmitCmmd(uint8_t)
+{
+    cur_x = win_x0;
+    cur_y = win_y0;
+}
+
+void ILI9341_Transmit16bitData(uint16_t color)
+{
+    put(color);
+}
+
+void ILI9341_PushColor565(uint16_t color, uint32_t count)
+{
+    while (count--)
+        put(color);
+}
+
+void ILI9341_PushPixels565LE(const uint8_t* data, uint16_t count)
+{
+    for (; count--; data += 2)
+        put(data[0] | data[1] << 8);
+}
+
+void ILI9341_PushPixels565BE(const uint8_t* data, uint16_t count)
+{
+    for (; count--; data += 2)
+        put(data[0] << 8 | data[1]);
+}
+
+void ILI9341_ReadStart(void)
+{
+    cur_x = win_x0;
+    cur_y = win_y0;
+}
+
+uint16_t ILI9341_PullColor565(void)
+{
+    uint16_t color = cur_y < 320 && cur_x < 240 ? lcd_frame[cur_y][cur_x] : 0;
+    if (++cur_x > win_x1)
+    {
+        cur_x = win_x0;
+        cur_y++;
+    }
+    return color;
+}
+
+void ILI9341_ReadEnd(void)
+{
+}
+
+char ILI9341_FillWindow(uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye, uint16_t color)
+{
+    ILI9341_SetWindow(xs, ys, xe, ye);
+    ILI9341_PushColor565(color, (uint32_t) (xe - xs + 1) * (ye - ys + 1));
+    return 0;
+}
+
+char ILI9341_SetScrollArea(uint16_t top, uint16_t bottom)
+{
+    lcd_scroll_top = top;
+    lcd_scroll_bottom = bottom;
+    return 0;
+}
+
+void ILI9341_SetScrollStart(uint16_t row)
+{
+    lcd_scroll_start = row;
+}
+
+void ILI9341_SetOrientation(uint8_t orientation)
+{
+    landscape = orientation & 0x20; // MADCTL row / column exchange
+}
+}
+
+/**
+ * @brief Writes the frame buffer as a binary PPM file.
+ *
+ * @param path The file to write.
+ */
+void lcd_save_ppm(const char* path)
+{
+    FILE* f = fopen(path, "wb");
+    if (!f)
+        return;
+    fprintf(f, "P6\n240 320\n255\n");
+    for (int y = 0; y < 320; y++)
+    {
+        for (int x = 0; x < 240; x++)
+        {
+            uint16_t c = lcd_frame[y][x];
+            uint8_t rgb[3] = {(uint8_t) (c >> 8 & 0xF8), (uint8_t) (c >> 3 & 0xFC),
+                              (uint8_t) (c << 3)};
+            fwrite(rgb, 1, 3, f);
+        }
+    }
+    fclose(f);
+}
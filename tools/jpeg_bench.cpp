@@ -0,0 +1,175 @@
+/**
+ * @file jpeg_bench.cpp
+ * @brief Host benchmark of the JPEG decoder against the 24 bpp BMP path.
+ *
+ * Decodes a JPEG with the album's Jpeg class on a PC and reports the bytes read from the file,
+ * which is what the SD card has to transfer, and the decode time. The same is measured for a
+ * 24 bpp BMP of the displayed size, either one given on the command line or one generated from
+ * the decoded JPEG, read with the loop of Bmp::draw_area(). Host times only compare the CPU
+ * cost of the two paths, they are not AVR times.
+ *
+ * Build from the repository root:
+ *
+ *     g++ -O2 -Itools/host -Iinclude -Iinclude/lib tools/jpeg_bench.cpp tools/host/lcd.cpp \
+ *         src/Jpeg.cpp src/Slide.cpp src/StreamReader.cpp src/Workspace.cpp -o jpeg_bench
+ *
+ * Usage: jpeg_bench photo.jpg [photo.bmp] [screen.ppm]
+ *
+ * Pass "" as the BMP to generate it while still saving the screen.
+ */
+#include <File.h>
+#include <Jpeg.h>
+#include <config.h>
+#include <stdlib.h>
+#include <time.h>
+
+extern uint16_t lcd_frame[320][240];
+extern uint32_t lcd_pixels;
+void lcd_save_ppm(const char* path);
+extern "C" void ILI9341_SetWindow(uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye);
+extern "C" void ILI9341_TransmitCmmd(uint8_t cmd);
+extern "C" void ILI9341_Transmit16bitData(uint16_t color);
+
+static const int RUNS = 10;
+
+/**
+ * @brief Writes the non-black bounding box of the frame buffer as a 24 bpp BMP.
+ */
+static void save_bmp(const char* path)
+{
+    int x0 = 240, y0 = 320, x1 = -1, y1 = -1;
+    for (int y = 10; y < 310; y++)
+        for (int x = 0; x < 240; x++)
+            if (lcd_frame[y][x])
+            {
+                x0 = x < x0 ? x : x0;
+                x1 = x > x1 ? x : x1;
+                y0 = y < y0 ? y : y0;
+                y1 = y > y1 ? y : y1;
+            }
+    if (x1 < 0)
+        x0 = y0 = x1 = y1 = 0;
+    int w = x1 - x0 + 1, h = y1 - y0 + 1;
+    uint32_t row = (w * 3 + 3) & ~3;
+    uint32_t size = 54 + row * h;
+    uint8_t header[54] = {'B', 'M'};
+    header[2] = size, header[3] = size >> 8, header[4] = size >> 16, header[5] = size >> 24;
+    header[10] = 54, header[14] = 40;
+    header[18] = w, header[19] = w >> 8, header[22] = h, header[23] = h >> 8;
+    header[26] = 1, header[28] = 24;
+    FILE* f = fopen(path, "wb");
+    fwrite(header, 1, sizeof(header), f);
+    for (int y = y1; y >= y0; y--)
+    {
+        uint8_t line[3 * 240 + 3] = {0};
+        for (int x = 0; x < w; x++)
+        {
+            uint16_t c = lcd_frame[y][x0 + x];
+            line[3 * x] = c << 3;
+            line[3 * x + 1] = c >> 3 & 0xFC;
+            line[3 * x + 2] = c >> 8 & 0xF8;
+        }
+        fwrite(line, 1, row, f);
+    }
+    fclose(f);
+}
+
+/**
+ * @brief The 24 bpp loop of Bmp::draw_area(), reading through the same File interface.
+ */
+static void bmp_draw24(File& bmpFile, uint8_t x, uint8_t y)
+{
+    uint8_t buffer[3 * BUFFPIXEL];
+    uint16_t buffidx = sizeof(buffer);
+    bmpFile.seek(10);
+    uint32_t offset = File::read32(bmpFile);
+    File::read32(bmpFile);
+    int32_t width = File::read32(bmpFile);
+    int32_t height = File::read32(bmpFile);
+    uint32_t rowSize = (width * 3 + 3) & ~3;
+    int w = width > (int32_t) TFT_WIDTH ? TFT_WIDTH : width;
+    int h = height > (int32_t) TFT_HEIGHT - 20 ? TFT_HEIGHT - 20 : height;
+    x += (TFT_WIDTH - w) / 2;
+    y += (TFT_HEIGHT - 20 - h) / 2;
+
+    ILI9341_SetWindow(x, y, x + w - 1, y + h - 1);
+    ILI9341_TransmitCmmd(0x2C);
+    for (int row = 0; row < h; row++)
+    {
+        uint32_t pos = offset + (height - 1 - row) * rowSize;
+        if (bmpFile.get_current_position() != pos)
+        {
+            bmpFile.seek(pos);
+            buffidx = sizeof(buffer);
+        }
+        for (int col = 0; col < w; col++)
+        {
+            if (buffidx >= sizeof(buffer))
+            {
+                bmpFile.read(buffer, sizeof(buffer));
+                buffidx = 0;
+            }
+            uint8_t b = buffer[buffidx++];
+            uint8_t g = buffer[buffidx++];
+            uint8_t r = buffer[buffidx++];
+            ILI9341_Transmit16bitData((r & 0xF8) << 8 | (g & 0xFC) << 3 | b >> 3);
+        }
+    }
+    bmpFile.close();
+}
+
+/**
+ * @brief Draws a file RUNS times and reports bytes read and the mean time.
+ */
+static void bench(const char* label, const char* path, bool jpeg)
+{
+    uint32_t bytes = 0, pixels = 0;
+    clock_t start = clock();
+    for (int i = 0; i < RUNS; i++)
+    {
+        File file;
+        if (!file.open(path))
+        {
+            fprintf(stderr, "cannot open %s\n", path);
+            exit(1);
+        }
+        lcd_pixels = 0;
+        if (jpeg)
+        {
+            if (!Jpeg::is_jpeg(file))
+            {
+                fprintf(stderr, "%s is not a JPEG file\n", path);
+                exit(1);
+            }
+            Jpeg::draw(file, 0, 10);
+        }
+        else
+        {
+            bmp_draw24(file, 0, 10);
+        }
+        bytes = file.bytes_read;
+        pixels = lcd_pixels;
+    }
+    double ms = 1000.0 * (clock() - start) / CLOCKS_PER_SEC / RUNS;
+    printf("%-5s %10lu bytes read %8lu pixels %9.3f ms\n", label, (unsigned long) bytes,
+           (unsigned long) pixels, ms);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s photo.jpg [photo.bmp] [screen.ppm]\n", argv[0]);
+        return 1;
+    }
+    bench("JPEG", argv[1], true);
+    if (argc > 3)
+        lcd_save_ppm(argv[3]);
+
+    // Without a BMP, one of the displayed size is made from the decoded image
+    const char* bmp = argc > 2 && argv[2][0] ? argv[2] : "jpeg_bench.bmp";
+    if (bmp != argv[2])
+        save_bmp(bmp);
+    bench("BMP", bmp, false);
+    return 0;
+}
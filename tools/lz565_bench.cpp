@@ -0,0 +1,235 @@
+/**
+ * @file lz565_bench.cpp
+ * @brief Host benchmark of the LZ565 decoder against uncompressed RGB565.
+ *
+ * Decodes an LZ565 image with the album's Lz565 class on a PC and reports the bytes and sectors
+ * read from the file, which is what the SD card has to transfer, and the decode time. The same is
+ * measured for the decoded image stored as uncompressed big-endian RGB565, drawn a sector at a time
+ * like ImageCache::draw() does. Host times only compare the CPU cost of the two paths, so an AVR
+ * cycle count is also estimated for both from the bytes read and the tokens of the file, with the
+ * per-operation costs below. They are rough estimates of the loops involved, not measurements.
+ *
+ * Build from the repository root:
+ *
+ *     g++ -O2 -Itools/host -Iinclude -Iinclude/lib tools/lz565_bench.cpp tools/host/lcd.cpp \
+ *         src/Lz565.cpp src/Slide.cpp src/StreamReader.cpp src/Workspace.cpp -o lz565_bench
+ *
+ * Usage: lz565_bench image.lz5 [screen.ppm]
+ */
+#include <File.h>
+#include <Lz565.h>
+#include <config.h>
+#include <stdlib.h>
+#include <time.h>
+
+extern uint16_t lcd_frame[320][240];
+extern uint32_t lcd_pixels;
+void lcd_save_ppm(const char* path);
+extern "C" void ILI9341_SetWindow(uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye);
+extern "C" void ILI9341_TransmitCmmd(uint8_t cmd);
+extern "C" void ILI9341_PushPixels565BE(const uint8_t* data, uint16_t count);
+
+static const int RUNS = 10;
+static const double F_CPU_HZ = 7372800.0;
+
+// Estimated AVR cycles per operation
+static const double SD_BYTE = 20;     ///< SPI::read() at F_CPU/2, 16 cycles a byte plus the loop.
+static const double SD_SECTOR = 400;  ///< Data token, CRC and block bookkeeping of a sector.
+static const double BYTE_COPY = 6;    ///< A byte copied out of the read buffer or in the ring.
+static const double PUSH_PIXEL = 14;  ///< A pixel of ILI9341_PushPixels565BE().
+static const double FILL_PIXEL = 10;  ///< A pixel of ILI9341_PushColor565().
+static const double TOKEN = 60;       ///< Reading and dispatching a token.
+
+/**
+ * @brief Counts of what decoding a file does, for the cycle estimate.
+ */
+struct Counts
+{
+    uint32_t tokens;      ///< Tokens of the displayed rows.
+    uint32_t literal;     ///< Literal pixels pushed from the ring.
+    uint32_t copied;      ///< Copied pixels pushed from the ring.
+    uint32_t repeated;    ///< Repeated pixels, run-filled.
+    uint32_t ring_pixels; ///< Pixels moved within the ring by copies and repeats.
+};
+
+/**
+ * @brief Gets the displayed size of an image like Lz565::draw() crops it.
+ */
+static void displayed_size(const Lz565Header& header, uint16_t& w, uint16_t& h)
+{
+    w = header.width > TFT_WIDTH ? TFT_WIDTH : header.width;
+    h = header.height > TFT_HEIGHT - 20 ? TFT_HEIGHT - 20 : header.height;
+}
+
+/**
+ * @brief Walks the tokens of the displayed rows of a file without drawing.
+ */
+static bool count_tokens(const char* path, Counts& counts)
+{
+    File file;
+    Lz565Header header;
+    if (!file.open(path) || !Lz565::parse_header(file, header))
+        return false;
+    uint16_t w, h;
+    displayed_size(header, w, h);
+    memset(&counts, 0, sizeof(counts));
+    for (uint16_t row = 0; row < h; row++)
+    {
+        for (uint16_t col = 0; col < header.width;)
+        {
+            int16_t token = file.read();
+            if (token < 0)
+                return false;
+            uint16_t n;
+            uint32_t* pushed;
+            if ((token & 0xC0) == 0xC0)
+            {
+                n = (token & 0x3F) + 2;
+                file.read();
+                pushed = &counts.copied;
+                counts.ring_pixels += n;
+            }
+            else if (token & 0x80)
+            {
+                n = (token & 0x3F) + 1;
+                pushed = &counts.repeated;
+                counts.ring_pixels += n;
+            }
+            else
+            {
+                n = token + 1;
+                file.seek(file.get_current_position() + 2 * n);
+                pushed = &counts.literal;
+            }
+            if (col < w)
+                *pushed += col + n > w ? w - col : n;
+            counts.tokens++;
+            col += n;
+        }
+    }
+    file.close();
+    return true;
+}
+
+/**
+ * @brief Draws an uncompressed big-endian RGB565 image a sector at a time.
+ */
+static void raw_draw(File& file, uint16_t w, uint16_t h)
+{
+    uint8_t sector[512];
+    uint8_t x = (TFT_WIDTH - w) / 2;
+    uint8_t y = 10 + (TFT_HEIGHT - 20 - h) / 2;
+    int16_t n;
+    ILI9341_SetWindow(x, y, x + w - 1, y + h - 1);
+    ILI9341_TransmitCmmd(0x2C);
+    while ((n = file.read(sector, sizeof(sector))) > 0)
+        ILI9341_PushPixels565BE(sector, n / 2);
+    file.close();
+}
+
+/**
+ * @brief Writes the displayed image from the frame buffer as uncompressed big-endian RGB565.
+ */
+static void save_raw(const char* path, uint16_t w, uint16_t h)
+{
+    uint8_t x = (TFT_WIDTH - w) / 2;
+    uint8_t y = 10 + (TFT_HEIGHT - 20 - h) / 2;
+    FILE* f = fopen(path, "wb");
+    for (int row = 0; row < h; row++)
+        for (int col = 0; col < w; col++)
+        {
+            uint16_t c = lcd_frame[y + row][x + col];
+            fputc(c >> 8, f);
+            fputc(c & 0xFF, f);
+        }
+    fclose(f);
+}
+
+/**
+ * @brief Draws a file RUNS times and reports bytes and sectors read, the mean host time and the
+ * estimated AVR time.
+ */
+static void bench(const char* label, const char* path, uint16_t w, uint16_t h,
+                  const Counts* counts)
+{
+    uint32_t bytes = 0, pixels = 0;
+    clock_t start = clock();
+    for (int i = 0; i < RUNS; i++)
+    {
+        File file;
+        if (!file.open(path))
+        {
+            fprintf(stderr, "cannot open %s\n", path);
+            exit(1);
+        }
+        lcd_pixels = 0;
+        Lz565Header header;
+        if (counts)
+        {
+            if (!Lz565::parse_header(file, header))
+            {
+                fprintf(stderr, "%s is not an LZ565 file\n", path);
+                exit(1);
+            }
+            Lz565::draw(file, header, 0, 10);
+        }
+        else
+        {
+            raw_draw(file, w, h);
+        }
+        bytes = file.bytes_read;
+        pixels = lcd_pixels;
+    }
+    double ms = 1000.0 * (clock() - start) / CLOCKS_PER_SEC / RUNS;
+
+    uint32_t sectors = (bytes + 511) / 512;
+    double cycles = bytes * SD_BYTE + sectors * SD_SECTOR;
+    if (counts)
+    {
+        // Bytes go through the read buffer, pixels of copies and repeats through the ring
+        cycles += bytes * BYTE_COPY + counts->tokens * TOKEN +
+                  (counts->literal + counts->copied) * PUSH_PIXEL +
+                  counts->repeated * FILL_PIXEL + counts->ring_pixels * 2 * BYTE_COPY;
+    }
+    else
+    {
+        cycles += pixels * PUSH_PIXEL;
+    }
+    printf("%-5s %8lu bytes %5lu sectors %7lu pixels %8.3f ms host %10.0f cycles %7.1f ms AVR\n",
+           label, (unsigned long) bytes, (unsigned long) sectors, (unsigned long) pixels, ms,
+           cycles, 1000.0 * cycles / F_CPU_HZ);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s image.lz5 [screen.ppm]\n", argv[0]);
+        return 1;
+    }
+    File file;
+    Lz565Header header;
+    Counts counts;
+    if (!file.open(argv[1]) || !Lz565::parse_header(file, header) ||
+        !count_tokens(argv[1], counts))
+    {
+        fprintf(stderr, "%s is not a valid LZ565 file\n", argv[1]);
+        return 1;
+    }
+    file.close();
+    uint16_t w, h;
+    displayed_size(header, w, h);
+
+    bench("LZ565", argv[1], w, h, &counts);
+    if (argc > 2)
+        lcd_save_ppm(argv[2]);
+    printf("      %lu tokens: %lu literal, %lu copied, %lu repeated pixels\n",
+           (unsigned long) counts.tokens, (unsigned long) counts.literal,
+           (unsigned long) counts.copied, (unsigned long) counts.repeated);
+
+    // The uncompressed image is the displayed part of the decoded one
+    const char* raw = "lz565_bench.565";
+    save_raw(raw, w, h);
+    bench("565", raw, w, h, NULL);
+    return 0;
+}
@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""Pack an image into the LZ compressed RGB565 format drawn by the album (see Lz565.h).
+
+Every row is compressed on its own into literals, repeats of the previous pixel and copies from
+at most 128 pixels back within the row, chosen greedily. The image is read with ffmpeg, and with
+--fit shrunk to fit the 240x300 image area first. Instead of an image, a raw rgb24 image can be
+given with --raw WxH.
+
+Usage: lz565_pack.py in.jpg out.lz5 [--fit] [--raw WxH]
+"""
+import argparse
+import struct
+import subprocess
+import sys
+
+RING = 128  # Lz565::RING
+MAX_LITERAL = 128
+MAX_RUN = 64
+MAX_COPY = 65
+MIN_COPY = 2
+AREA_WIDTH = 240
+AREA_HEIGHT = 300
+MAX_SIZE = 0xFFFF
+
+
+def image_size(path):
+    cmd = ["ffprobe", "-v", "error", "-select_streams", "v:0", "-show_entries",
+           "stream=width,height", "-of", "csv=p=0", path]
+    width, height = subprocess.check_output(cmd).decode().strip().split(",")[:2]
+    return int(width), int(height)
+
+
+def from_ffmpeg(path, fit):
+    width, height = image_size(path)
+    if fit and (width > AREA_WIDTH or height > AREA_HEIGHT):
+        scale = min(AREA_WIDTH / width, AREA_HEIGHT / height)
+        width, height = max(1, round(width * scale)), max(1, round(height * scale))
+    cmd = ["ffmpeg", "-v", "error", "-i", path, "-vf", "scale=%d:%d:flags=area" % (width, height),
+           "-frames:v", "1", "-f", "rawvideo", "-pix_fmt", "rgb24", "-"]
+    return width, height, subprocess.check_output(cmd)
+
+
+def to_565(rgb):
+    """Converts rgb24 to RGB565 values like the album's decoders do, by truncating."""
+    return [(rgb[i] & 0xF8) << 8 | (rgb[i + 1] & 0xFC) << 3 | rgb[i + 2] >> 3
+            for i in range(0, len(rgb), 3)]
+
+
+def longest_copy(row, i, recent):
+    """Finds the longest copy for position i among the positions that held the same pixel."""
+    best_len, best_offset = 0, 0
+    limit = min(MAX_COPY, len(row) - i)
+    for start in reversed(recent.get(row[i], ())):
+        offset = i - start
+        if offset > RING:
+            break
+        n = 1
+        while n < limit and row[start + n] == row[i + n]:
+            n += 1
+        if n > best_len:
+            best_len, best_offset = n, offset
+            if n == limit:
+                break
+    return best_len, best_offset
+
+
+def encode_row(row):
+    out = bytearray()
+    literals = []
+    recent = {}  # pixel value -> positions in the row, oldest first
+
+    def flush():
+        for k in range(0, len(literals), MAX_LITERAL):
+            chunk = literals[k:k + MAX_LITERAL]
+            out.append(len(chunk) - 1)
+            for p in chunk:
+                out.extend(struct.pack(">H", p))
+        literals.clear()
+
+    i = 0
+    while i < len(row):
+        run = 0
+        if i > 0:
+            while run < MAX_RUN and i + run < len(row) and row[i + run] == row[i - 1]:
+                run += 1
+        copy, offset = longest_copy(row, i, recent)
+
+        # A repeat costs one byte and a copy two, a literal two per pixel
+        if run and run + 1 >= copy:
+            flush()
+            out.append(0x80 | (run - 1))
+            n = run
+        elif copy >= MIN_COPY:
+            flush()
+            out += bytes((0xC0 | (copy - MIN_COPY), offset - 1))
+            n = copy
+        else:
+            literals.append(row[i])
+            n = 1
+        for k in range(i, i + n):
+            recent.setdefault(row[k], []).append(k)
+        i += n
+    flush()
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input")
+    parser.add_argument("output")
+    parser.add_argument("--fit", action="store_true",
+                        help="shrink the image to fit the %dx%d image area" % (AREA_WIDTH,
+                                                                              AREA_HEIGHT))
+    parser.add_argument("--raw", metavar="WxH",
+                        help="the input is a raw rgb24 image of this size")
+    args = parser.parse_args()
+
+    if args.raw:
+        width, height = (int(v) for v in args.raw.lower().split("x"))
+        with open(args.input, "rb") as f:
+            rgb = f.read(width * height * 3)
+        if len(rgb) != width * height * 3:
+            parser.error("%s is not a %dx%d rgb24 image" % (args.input, width, height))
+    else:
+        width, height, rgb = from_ffmpeg(args.input, args.fit)
+    if not 0 < width <= MAX_SIZE or not 0 < height <= MAX_SIZE:
+        parser.error("the image must be 1 to %d pixels wide and high" % MAX_SIZE)
+
+    pixels = to_565(rgb)
+    with open(args.output, "wb") as f:
+        f.write(b"L565" + struct.pack("<HH", width, height))
+        for y in range(height):
+            f.write(encode_row(pixels[y * width:(y + 1) * width]))
+        size = f.tell()
+    print("%s: %dx%d, %d bytes, %.1f%% of RGB565" % (args.output, width, height, size,
+                                                     100.0 * size / (width * height * 2)),
+          file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
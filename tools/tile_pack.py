@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Pack an image into the tiled, mipmapped RGB565 format drawn by the album (see Tiles.h).
+
+The image is kept at its full size as level 0 and shrunk by 2, 4 and 8 for the next levels, each
+cut into 32x32 tiles of big-endian RGB565 pixels that fill whole sectors. The levels are made by
+ffmpeg with area averaging. Instead of an image, a raw rgb24 image can be given with --raw WxH;
+its levels are then averaged here.
+
+Usage: tile_pack.py in.jpg out.til [--levels N] [--raw WxH]
+"""
+import argparse
+import struct
+import subprocess
+import sys
+
+TILE_SIZE = 32  # Tiles::TILE_SIZE
+TILE_BYTES = TILE_SIZE * TILE_SIZE * 2  # Tiles::TILE_SECTORS sectors
+HEADER_SIZE = 512  # Tiles::HEADER_SIZE
+MAX_LEVELS = 4  # Tiles::MAX_LEVELS
+MAX_SIZE = 0xFFFF
+
+
+def level_size(width, height, level):
+    return (width + (1 << level) - 1) >> level, (height + (1 << level) - 1) >> level
+
+
+def image_size(path):
+    cmd = ["ffprobe", "-v", "error", "-select_streams", "v:0", "-show_entries",
+           "stream=width,height", "-of", "csv=p=0", path]
+    width, height = subprocess.check_output(cmd).decode().strip().split(",")[:2]
+    return int(width), int(height)
+
+
+def levels_from_ffmpeg(path, width, height, count):
+    for level in range(count):
+        w, h = level_size(width, height, level)
+        cmd = ["ffmpeg", "-v", "error", "-i", path, "-vf", "scale=%d:%d:flags=area" % (w, h),
+               "-frames:v", "1", "-f", "rawvideo", "-pix_fmt", "rgb565be", "-"]
+        data = subprocess.check_output(cmd)
+        if len(data) != w * h * 2:
+            raise RuntimeError("ffmpeg gave %d bytes for %dx%d" % (len(data), w, h))
+        yield w, h, data
+
+
+def shrink(rgb, width, height):
+    """Averages each 2x2 block of an rgb24 image, the blocks at odd edges are smaller."""
+    w, h = level_size(width, height, 1)
+    out = bytearray(w * h * 3)
+    for y in range(h):
+        rows = [r for r in (2 * y, 2 * y + 1) if r < height]
+        for x in range(w):
+            cols = [c for c in (2 * x, 2 * x + 1) if c < width]
+            n = len(rows) * len(cols)
+            for ch in range(3):
+                total = sum(rgb[(r * width + c) * 3 + ch] for r in rows for c in cols)
+                out[(y * w + x) * 3 + ch] = (total + n // 2) // n
+    return out, w, h
+
+
+def to_565(rgb):
+    out = bytearray(len(rgb) // 3 * 2)
+    for i in range(len(rgb) // 3):
+        r, g, b = rgb[3 * i], rgb[3 * i + 1], rgb[3 * i + 2]
+        struct.pack_into(">H", out, 2 * i, (r & 0xF8) << 8 | (g & 0xFC) << 3 | b >> 3)
+    return bytes(out)
+
+
+def levels_from_raw(path, width, height, count):
+    with open(path, "rb") as f:
+        rgb = f.read(width * height * 3)
+    if len(rgb) != width * height * 3:
+        raise RuntimeError("%s is not a %dx%d rgb24 image" % (path, width, height))
+    w, h = width, height
+    for level in range(count):
+        if level:
+            rgb, w, h = shrink(rgb, w, h)
+        yield w, h, to_565(rgb)
+
+
+def tiles(width, height, data):
+    """Cuts a level into tiles, row after row of tiles, padding the edges with black."""
+    stride = width * 2
+    for ty in range((height + TILE_SIZE - 1) // TILE_SIZE):
+        for tx in range((width + TILE_SIZE - 1) // TILE_SIZE):
+            tile = bytearray(TILE_BYTES)
+            x0 = tx * TILE_SIZE
+            cols = min(TILE_SIZE, width - x0)
+            for r in range(min(TILE_SIZE, height - ty * TILE_SIZE)):
+                start = (ty * TILE_SIZE + r) * stride + x0 * 2
+                tile[r * TILE_SIZE * 2:r * TILE_SIZE * 2 + cols * 2] = data[start:start + cols * 2]
+            yield tile
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input")
+    parser.add_argument("output")
+    parser.add_argument("--levels", type=int, default=MAX_LEVELS,
+                        help="number of levels, 1 to %d (default %%(default)s)" % MAX_LEVELS)
+    parser.add_argument("--raw", metavar="WxH",
+                        help="the input is a raw rgb24 image of this size")
+    args = parser.parse_args()
+    if not 1 <= args.levels <= MAX_LEVELS:
+        parser.error("--levels must be between 1 and %d" % MAX_LEVELS)
+
+    if args.raw:
+        width, height = (int(v) for v in args.raw.lower().split("x"))
+        levels = levels_from_raw(args.input, width, height, args.levels)
+    else:
+        width, height = image_size(args.input)
+        levels = levels_from_ffmpeg(args.input, width, height, args.levels)
+    if not 0 < width <= MAX_SIZE or not 0 < height <= MAX_SIZE:
+        parser.error("the image must be 1 to %d pixels wide and high" % MAX_SIZE)
+
+    first_sectors = [0] * MAX_LEVELS
+    with open(args.output, "wb") as f:
+        f.write(bytes(HEADER_SIZE))
+        for level, (w, h, data) in enumerate(levels):
+            first_sectors[level] = f.tell() // 512
+            for tile in tiles(w, h, data):
+                f.write(tile)
+        size = f.tell()
+        f.seek(0)
+        f.write(b"TIL1" + struct.pack("<HHB3x4I", width, height, args.levels, *first_sectors))
+    print("%s: %dx%d in %d levels, %d bytes" % (args.output, width, height, args.levels, size),
+          file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
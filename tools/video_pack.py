@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+"""Pack a video into the raw RGB565 format played by the album (see Video.h).
+
+The video is scaled to fit 240x300 with black bars, converted to big-endian RGB565 by ffmpeg and
+written frame by frame, each frame padded to whole sectors. Instead of a video, a raw stream of
+240x300 rgb565be frames can be given with --raw, for example from another converter.
+
+Copy the result to a freshly formatted card or defragment it, so that the file is contiguous and
+is read with multi-block reads.
+
+Usage: video_pack.py in.mp4 out.rgv [--fps N] [--raw]
+"""
+import argparse
+import struct
+import subprocess
+import sys
+
+WIDTH = 240  # Video::FRAME_WIDTH
+HEIGHT = 300  # Video::FRAME_HEIGHT
+HEADER_SIZE = 512  # Video::HEADER_SIZE
+FRAME_BYTES = WIDTH * HEIGHT * 2
+FRAME_SIZE = (FRAME_BYTES + 511) // 512 * 512  # Video::FRAME_SIZE
+MAX_FRAMES = 0xFFFF
+
+
+def frames_from_ffmpeg(path, fps):
+    vf = ("fps=%d,scale=%d:%d:force_original_aspect_ratio=decrease,"
+          "pad=%d:%d:(ow-iw)/2:(oh-ih)/2" % (fps, WIDTH, HEIGHT, WIDTH, HEIGHT))
+    cmd = ["ffmpeg", "-v", "error", "-i", path, "-vf", vf, "-f", "rawvideo", "-pix_fmt", "rgb565be",
+           "-"]
+    proc = subprocess.Popen(cmd, stdout=subprocess.PIPE)
+    while True:
+        frame = proc.stdout.read(FRAME_BYTES)
+        if len(frame) < FRAME_BYTES:
+            break
+        yield frame
+    if proc.wait() != 0:
+        raise RuntimeError("ffmpeg failed")
+
+
+def frames_from_raw(path):
+    with open(path, "rb") as f:
+        while True:
+            frame = f.read(FRAME_BYTES)
+            if len(frame) < FRAME_BYTES:
+                break
+            yield frame
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input")
+    parser.add_argument("output")
+    parser.add_argument("--fps", type=int, default=10,
+                        help="frame rate of the packed video, 1 to 255 (default %(default)s)")
+    parser.add_argument("--raw", action="store_true",
+                        help="the input is a raw stream of 240x300 rgb565be frames")
+    args = parser.parse_args()
+    if not 1 <= args.fps <= 255:
+        parser.error("--fps must be between 1 and 255")
+
+    frames = frames_from_raw(args.input) if args.raw else frames_from_ffmpeg(args.input, args.fps)
+    padding = bytes(FRAME_SIZE - FRAME_BYTES)
+    count = 0
+    with open(args.output, "wb") as f:
+        f.write(bytes(HEADER_SIZE))
+        for frame in frames:
+            if count == MAX_FRAMES:
+                print("stopping at %d frames" % MAX_FRAMES, file=sys.stderr)
+                break
+            f.write(frame)
+            f.write(padding)
+            count += 1
+        f.seek(0)
+        f.write(b"RGV1" + struct.pack("<HHHB", WIDTH, HEIGHT, count, args.fps))
+    print("%s: %d frames at %d fps, %d bytes" %
+          (args.output, count, args.fps, HEADER_SIZE + count * FRAME_SIZE), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()